@@ -28,6 +28,11 @@
  *      n - none (mount order)
  *      s - special
  *      a - avail
+ *      T - total
+ *      f - free
+ *      p - percent used
+ *      U - inodes used
+ *      F - inodes free
  *      t - type
  *      r - reverse sort
  *
@@ -107,6 +112,9 @@
 #if _hdr_wchar
 # include <wchar.h>
 #endif
+#if _hdr_time
+# include <time.h>          /* nanosleep () */
+#endif
 #if _hdr_limits
 # include <limits.h>        /* PATH_MAX */
 #endif
@@ -141,6 +149,7 @@ typedef struct {
   int             *leftjust;
   const char      **jsonident;
   char            **strdata;
+  int             *stale;
 } di_disp_info_t;
 
 typedef struct {
@@ -166,6 +175,7 @@ static di_disp_text_t disptext [DI_SCALE_MAX] =
 };
 
 static void processExitFlag (void *di_data, int exitflag);
+static int  sleepInterval (int interval);
 static void di_display_data (void *);
 static void di_display_header (void *, di_disp_info_t *);
 static void usage (void);
@@ -179,6 +189,7 @@ main (int argc, const char * argv [])
 {
   void      *di_data;
   int       exitflag;
+  int       interval;
 
   if (strcmp (DI_VERSION, di_version ()) != 0) {
     fprintf (stderr, "version mismatch %s %s\n", DI_VERSION, di_version ());
@@ -188,13 +199,52 @@ main (int argc, const char * argv [])
   di_data = di_initialize ();
   exitflag = di_process_options (di_data, argc, argv, 1);
   processExitFlag (di_data, exitflag);
-  exitflag = di_get_all_disk_info (di_data);
-  processExitFlag (di_data, exitflag);
-  di_display_data (di_data);
+
+  interval = di_check_option (di_data, DI_OPT_INTERVAL);
+  if (interval <= 0) {
+    exitflag = di_get_all_disk_info (di_data);
+    processExitFlag (di_data, exitflag);
+    di_display_data (di_data);
+    di_cleanup (di_data);
+    return 0;
+  }
+
+  /* interval mode: runs until interrupted */
+  for (;;) {
+    exitflag = di_refresh_disk_info (di_data);
+    processExitFlag (di_data, exitflag);
+    di_display_data (di_data);
+    fflush (stdout);
+    if (sleepInterval (interval) != 0) {
+      break;
+    }
+    if (! di_check_option (di_data, DI_OPT_DISP_JSON)) {
+      fprintf (stdout, "\n");
+    }
+  }
   di_cleanup (di_data);
   return 0;
 }
 
+static int
+sleepInterval (int interval)
+{
+#if _lib_nanosleep
+  struct timespec   ts;
+
+  ts.tv_sec = interval / 1000;
+  ts.tv_nsec = (long) (interval % 1000) * 1000000L;
+  /* on an interrupt, sleep for the remainder */
+  while (nanosleep (&ts, &ts) != 0) {
+    continue;
+  }
+  return 0;
+#else
+  fprintf (stderr, "%s\n", DI_GT ("--interval is not supported"));
+  return -1;
+#endif
+}
+
 static void
 processExitFlag (void *di_data, int exitflag)
 {
@@ -328,6 +378,7 @@ di_display_data (void *di_data)
   dispinfo.leftjust = (int *) malloc (sizeof (int) * (Size_t) fmtstrlen);
   dispinfo.jsonident = (const char **) malloc (sizeof (char *) * (Size_t) fmtstrlen);
   dispinfo.strdata = (char **) malloc (sizeof (char *) * (Size_t) displinecount * (Size_t) fmtstrlen);
+  dispinfo.stale = (int *) malloc (sizeof (int) * (Size_t) (displinecount + 1));
   strdata = dispinfo.strdata;
 
   for (i = 0; i < fmtstrlen; ++i) {
@@ -339,6 +390,7 @@ di_display_data (void *di_data)
   for (i = 0; i < displinecount; ++i) {
     int   j;
 
+    dispinfo.stale [i] = 0;
     for (j = 0; j < fmtstrlen; ++j) {
       int       idx;
 
@@ -381,6 +433,8 @@ di_display_data (void *di_data)
     int         dataidx;
 
     fmtcount = 0;
+    /* the deadline passed before this partition was sampled */
+    dispinfo.stale [dispcount] = pub->printFlag == DI_PRNT_STALE;
     di_format_iter_init (di_data);
     while ( (fmt = di_format_iterate (di_data)) != DI_FMT_ITER_STOP) {
       dataidx = dispcount * fmtstrlen + fmtcount;
@@ -594,6 +648,15 @@ di_display_data (void *di_data)
         }
       }
 
+      /* the values of a stale partition are not known */
+      if (dispinfo.stale [dispcount] &&
+          dispinfo.jsonident [fmtcount] != NULL &&
+          ! dispinfo.leftjust [fmtcount]) {
+        free (strdata [dataidx]);
+        strdata [dataidx] = strdup ("?");
+        dispinfo.suffix [dataidx] = "";
+      }
+
       ++fmtcount;
     }
 
@@ -636,6 +699,9 @@ di_display_data (void *di_data)
 
     if (jsonout) {
       fprintf (stdout, "    {\n");
+      if (dispinfo.stale [i]) {
+        fprintf (stdout, "      \"stale\" : true,\n");
+      }
     }
     comma = ",";
     for (j = 0; j < fmtstrlen; ++j) {
@@ -743,6 +809,7 @@ di_display_data (void *di_data)
   free (dispinfo.suffix);
   free (dispinfo.leftjust);
   free (dispinfo.jsonident);
+  free (dispinfo.stale);
   free (strdata);
 }
 
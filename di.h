@@ -35,6 +35,8 @@ extern "C" {
 #define DI_PRNT_EXCLUDE     4
 #define DI_PRNT_FORCE       5
 #define DI_PRNT_SKIP        6
+#define DI_PRNT_TIMEOUT     7
+#define DI_PRNT_STALE       8
 
 /* string identifiers */
 #define DI_DISP_MOUNTPT     0
@@ -82,6 +84,7 @@ extern "C" {
 #define DI_OPT_FMT_STR_LEN      13
 #define DI_OPT_SCALE            14
 #define DI_OPT_BLOCK_SZ         15
+#define DI_OPT_INTERVAL         16
 
 #define DI_FMT_ITER_STOP        -1
 
@@ -144,6 +147,9 @@ extern void di_format_iter_init (void *di_data);
 extern int di_format_iterate (void *di_data);
 
 extern int di_get_all_disk_info (void *di_data);
+extern int di_refresh_disk_info (void *di_data);
+extern int di_get_path_info (void *di_data, const char *path, di_pub_disk_info_t *pub);
+extern int di_get_path_mounts (void *di_data, int count, const char *paths [], int indexes []);
 extern int di_iterate_init (void *di_data, int itertype);
 extern const di_pub_disk_info_t *di_iterate (void *di_data);
 extern int di_get_scale_max (void *, int, int, int, int);
@@ -0,0 +1,147 @@
+/* Copyright 2026 Brad Lanam Pleasant Hill CA */
+
+/*
+ *
+ *    A simple arena allocator.
+ *
+ *    The disk information strings are allocated from the arena at
+ *    their exact length.  Nothing is freed individually; the whole
+ *    arena is released at once when the disk information is thrown
+ *    away.  The chunk size doubles as the arena grows, so the number
+ *    of chunks stays small no matter how many mounts there are.
+ *
+ *    di_arena_init ()
+ *        initialize an empty arena.
+ *    di_arena_alloc ()
+ *        allocate aligned memory from the arena.
+ *    di_arena_strdup ()
+ *        copy a string into the arena.
+ *    di_arena_free ()
+ *        release all of the memory held by the arena.
+ *
+ */
+
+#include "config.h"
+
+#if _hdr_stdio
+# include <stdio.h>
+#endif
+#if _hdr_stdlib
+# include <stdlib.h>
+#endif
+#if _hdr_string
+# include <string.h>
+#endif
+#if _hdr_strings
+# include <strings.h>
+#endif
+#if _hdr_memory
+# include <memory.h>
+#endif
+#if _hdr_malloc
+# include <malloc.h>
+#endif
+#if _hdr_errno
+# include <errno.h>
+#endif
+
+#include "di.h"
+#include "disystem.h"
+#include "diinternal.h"
+
+#define DI_ARENA_MIN_CHUNK    4096
+#define DI_ARENA_MAX_CHUNK    (1024 * 1024)
+/* the data following the chunk header must be suitably aligned */
+#define DI_ARENA_ALIGN        (sizeof (double) > sizeof (void *) ? \
+    sizeof (double) : sizeof (void *))
+#define DI_ARENA_HDR_SZ       ((sizeof (di_arena_chunk_t) + DI_ARENA_ALIGN - 1) \
+    / DI_ARENA_ALIGN * DI_ARENA_ALIGN)
+
+static void *arenaAlloc (di_arena_t *arena, Size_t sz, Size_t align);
+
+void
+di_arena_init (di_arena_t *arena)
+{
+  arena->head = NULL;
+  arena->nextsz = DI_ARENA_MIN_CHUNK;
+}
+
+void *
+di_arena_alloc (di_arena_t *arena, Size_t sz)
+{
+  return arenaAlloc (arena, sz, DI_ARENA_ALIGN);
+}
+
+char *
+di_arena_strdup (di_arena_t *arena, const char *str)
+{
+  Size_t    len;
+  char      *p;
+
+  len = strlen (str) + 1;
+  p = (char *) arenaAlloc (arena, len, 1);
+  if (p != NULL) {
+    memcpy (p, str, len);
+  }
+  return p;
+}
+
+void
+di_arena_free (di_arena_t *arena)
+{
+  di_arena_chunk_t  *chunk;
+  di_arena_chunk_t  *next;
+
+  chunk = arena->head;
+  while (chunk != NULL) {
+    next = chunk->next;
+    free (chunk);
+    chunk = next;
+  }
+  di_arena_init (arena);
+}
+
+static void *
+arenaAlloc (di_arena_t *arena, Size_t sz, Size_t align)
+{
+  di_arena_chunk_t  *chunk;
+  Size_t            offset;
+  Size_t            csz;
+
+  chunk = arena->head;
+  if (chunk != NULL) {
+    offset = (chunk->used + align - 1) / align * align;
+    if (offset + sz <= chunk->size) {
+      chunk->used = offset + sz;
+      return (char *) chunk + DI_ARENA_HDR_SZ + offset;
+    }
+  }
+
+  csz = arena->nextsz;
+  if (sz > csz) {
+    /* an over-size request gets a chunk of its own */
+    csz = sz;
+  } else if (arena->nextsz < DI_ARENA_MAX_CHUNK) {
+    arena->nextsz *= 2;
+  }
+
+  chunk = (di_arena_chunk_t *) malloc (DI_ARENA_HDR_SZ + csz);
+  if (chunk == NULL) {
+    fprintf (stderr, "malloc failed in di_arena_alloc.  errno %d\n", errno);
+    return NULL;
+  }
+  chunk->size = csz;
+  chunk->used = sz;
+
+  if (arena->head != NULL && sz == csz &&
+      arena->head->size - arena->head->used > 0) {
+    /* keep filling the current chunk */
+    chunk->next = arena->head->next;
+    arena->head->next = chunk;
+  } else {
+    chunk->next = arena->head;
+    arena->head = chunk;
+  }
+
+  return (char *) chunk + DI_ARENA_HDR_SZ;
+}
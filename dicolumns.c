@@ -0,0 +1,208 @@
+/* Copyright 2026 Brad Lanam Pleasant Hill CA */
+
+/*
+ *
+ *    Column snapshot of the disk information.
+ *
+ *    The passes that look at one field across all of the entries
+ *    (sorting, totals, the printable count, the display scaling)
+ *    use contiguous arrays rather than walking the di_disk_info_t
+ *    structures.  The values are copied as plain integers.  An
+ *    entry whose values do not all fit is marked as not exact,
+ *    and the caller falls back to the dinum_t values.
+ *
+ *    The di_disk_info_t structures remain the primary copy, and
+ *    the public interface is unchanged.
+ *
+ *    di_columns_init ()
+ *        initialize an empty column snapshot.
+ *    di_columns_build ()
+ *        (re)build the columns from the disk info entries.
+ *    di_columns_set_row ()
+ *        update the columns for one entry.
+ *    di_columns_count ()
+ *        count the printable entries.
+ *    di_columns_free ()
+ *        release the columns.
+ *
+ */
+
+#include "config.h"
+
+#if _hdr_stdio
+# include <stdio.h>
+#endif
+#if _hdr_stdlib
+# include <stdlib.h>
+#endif
+#if _hdr_stdbool
+# include <stdbool.h>
+#endif
+#if _hdr_string
+# include <string.h>
+#endif
+#if _hdr_strings
+# include <strings.h>
+#endif
+#if _hdr_memory
+# include <memory.h>
+#endif
+#if _hdr_malloc
+# include <malloc.h>
+#endif
+#if _hdr_errno
+# include <errno.h>
+#endif
+
+#include "di.h"
+#include "disystem.h"
+#include "diinternal.h"
+#include "dimath.h"
+#include "dimath_mp.h"
+
+/* number of bits set in each nibble */
+static const unsigned char nibbleBits [16] = {
+  0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+};
+
+void
+di_columns_init (di_columns_t *cols)
+{
+  int     i;
+
+  for (i = 0; i < DI_VALUE_MAX; ++i) {
+    cols->values [i] = NULL;
+  }
+  cols->printable = NULL;
+  cols->exact = NULL;
+  cols->fsclass = NULL;
+  cols->count = 0;
+  cols->alloc = 0;
+  cols->valid = false;
+}
+
+/* the columns include the totals bucket */
+int
+di_columns_build (di_data_t *di_data)
+{
+  di_columns_t  *cols;
+  di_ui_t       *tvalues;
+  int           count;
+  Size_t        bsz;
+  int           i;
+
+  cols = &di_data->columns;
+  cols->valid = false;
+  count = di_data->fscount + 1;
+
+  if (count > cols->alloc) {
+    di_columns_free (cols);
+    bsz = (Size_t) (count + 7) / 8;
+    /* the value columns are one allocation */
+    tvalues = (di_ui_t *) malloc (sizeof (di_ui_t) * (Size_t) count * DI_VALUE_MAX);
+    cols->printable = (unsigned char *) malloc (bsz);
+    cols->exact = (unsigned char *) malloc (bsz);
+    cols->fsclass = (int *) malloc (sizeof (int) * (Size_t) count);
+    if (tvalues == NULL || cols->printable == NULL ||
+        cols->exact == NULL || cols->fsclass == NULL) {
+      fprintf (stderr, "malloc failed in di_columns_build.  errno %d\n", errno);
+      if (tvalues != NULL) {
+        free (tvalues);
+      }
+      di_columns_free (cols);
+      return -1;
+    }
+    for (i = 0; i < DI_VALUE_MAX; ++i) {
+      cols->values [i] = tvalues + (Size_t) i * (Size_t) count;
+    }
+    cols->alloc = count;
+  }
+
+  cols->count = count;
+  bsz = (Size_t) (count + 7) / 8;
+  memset (cols->printable, 0, bsz);
+  memset (cols->exact, 0, bsz);
+  for (i = 0; i < count; ++i) {
+    di_columns_set_row (di_data, i);
+  }
+  cols->valid = true;
+  return 0;
+}
+
+void
+di_columns_set_row (di_data_t *di_data, int idx)
+{
+  di_columns_t    *cols;
+  di_disk_info_t  *dinfo;
+  int             exact;
+  int             i;
+
+  cols = &di_data->columns;
+  if (idx < 0 || idx >= cols->count) {
+    return;
+  }
+  dinfo = &di_data->diskInfo [idx];
+
+  exact = true;
+  for (i = 0; i < DI_VALUE_MAX; ++i) {
+    if (! dinum_get_u (&dinfo->values [i], &cols->values [i][idx])) {
+      cols->values [i][idx] = 0;
+      exact = false;
+    }
+  }
+
+  if (exact) {
+    DI_BIT_SET (cols->exact, idx);
+  } else {
+    DI_BIT_CLEAR (cols->exact, idx);
+  }
+  if (dinfo->doPrint && ! dinfo->topHidden && ! dinfo->whereHidden) {
+    DI_BIT_SET (cols->printable, idx);
+  } else {
+    DI_BIT_CLEAR (cols->printable, idx);
+  }
+  cols->fsclass [idx] = dinfo->fsClass;
+}
+
+/* the number of printable entries in [0, count) */
+int
+di_columns_count (const di_columns_t *cols, int count)
+{
+  int             total;
+  int             nbytes;
+  int             i;
+  unsigned char   byte;
+
+  if (count > cols->count) {
+    count = cols->count;
+  }
+  total = 0;
+  nbytes = count / 8;
+  for (i = 0; i < nbytes; ++i) {
+    byte = cols->printable [i];
+    total += nibbleBits [byte & 0x0f] + nibbleBits [byte >> 4];
+  }
+  for (i = nbytes * 8; i < count; ++i) {
+    total += DI_BIT_TEST (cols->printable, i);
+  }
+  return total;
+}
+
+void
+di_columns_free (di_columns_t *cols)
+{
+  /* values [0] is the start of the value allocation */
+  if (cols->values [0] != NULL) {
+    free (cols->values [0]);
+  }
+  if (cols->printable != NULL) {
+    free (cols->printable);
+  }
+  if (cols->exact != NULL) {
+    free (cols->exact);
+  }
+  if (cols->fsclass != NULL) {
+    free (cols->fsclass);
+  }
+  di_columns_init (cols);
+}
@@ -29,6 +29,9 @@
 #if _hdr_errno
 # include <errno.h>
 #endif
+#if _hdr_unistd
+# include <unistd.h>            /* close () */
+#endif
 
 #include "di.h"
 #include "disystem.h"
@@ -37,17 +40,39 @@
 #include "dimath.h"
 #include "dimath_mp.h"
 #include "dimntopt.h"
+#include "dioptions.h"
 
 /*
  *    This module contains utility routines for conversion
  *    and checking the data.
  *
+ *    di_disk_info_reserve ()
+ *        make room for more disk info entries.
  *    di_initialize_disk_info ()
- *        initialize disk info structure
+ *        initialize disk info structure, with string buffers that
+ *        the caller fills in.
+ *    di_initialize_disk_info_arena ()
+ *        initialize disk info structure, the strings are set with
+ *        di_set_disk_string ().
+ *    di_set_disk_string ()
+ *        store a string in the arena.  All but the mount point are
+ *        interned, and the file system type class is set.
+ *    di_compact_disk_info ()
+ *        move the string buffers into the arena.
+ *    di_filter_paths ()
+ *        check a mount point against the path filters.
+ *    di_filter_match ()
+ *        combine the type and path filters for an entry.
+ *    di_drop_mount ()
+ *        should the mount table code drop this mount?
+ *    di_release_disk_fd ()
+ *        close the held mount point descriptor.
  *    di_save_block_sizes ()
  *        save the block sizes in the diskinfo structure.
  *    di_save_inode_sizes ()
  *        save the inode sizes in the diskinfo structure.
+ *    di_copy_disk_values ()
+ *        copy the sizes from another diskinfo structure.
  *    convertMountOptions ()
  *        converts mount options to text format.
  *    convertNFSMountOptions ()
@@ -56,35 +81,256 @@
  *        Checks to see if the mount option is set.
  *        Used if hasmntopt () is not present.
  *    di_is_remote_disk ()
- *        test a disk to see if it is remote (nfs, nfs3).
+ *        test a disk to see if it is remote (nfs, cifs, ceph, ...).
  *
  */
 
+static char diEmptyStr [1] = { '\0' };
+
+/* solaris: swap */
+/* linux: devtmpfs, cgroup, tmpfs, squashfs, overlay, efivarfs */
+static const char *diIgnoreFSTypes [] = {
+  "rootfs", "procfs", "ptyfs", "kernfs", "devfs", "tmpfs", "swap",
+  "cgroup", "squashfs", "overlay", "efivarfs", "devtmpfs",
+};
+#define DI_IGNORE_FSTYPE_COUNT \
+    ((int) (sizeof (diIgnoreFSTypes) / sizeof (const char *)))
+
+static void initDiskInfo (di_disk_info_t *diptr, int idx);
+static int  fstypeClass (di_data_t *di_data, int id);
+static int  hasMountOption (const char *opts, const char *name);
+
+/* grows the entry array geometrically; room is kept for the totals bucket */
+int
+di_disk_info_reserve (di_data_t *di_data, int count)
+{
+  di_disk_info_t  *tdinfo;
+  int             alloccount;
+
+  if (count + 1 <= di_data->fsalloc) {
+    return 0;
+  }
+
+  alloccount = di_data->fsalloc * 2;
+  if (alloccount < DI_DISK_INFO_MIN_ALLOC) {
+    alloccount = DI_DISK_INFO_MIN_ALLOC;
+  }
+  if (alloccount < count + 1) {
+    alloccount = count + 1;
+  }
+
+  tdinfo = (di_disk_info_t *) di_realloc (
+      (char *) di_data->diskInfo,
+      sizeof (di_disk_info_t) * (Size_t) alloccount);
+  if (tdinfo == (di_disk_info_t *) NULL) {
+    fprintf (stderr, "malloc failed for diskInfo. errno %d\n", errno);
+    return -1;
+  }
+  di_data->diskInfo = tdinfo;
+  di_data->fsalloc = alloccount;
+  return 0;
+}
+
 void
 di_initialize_disk_info (di_disk_info_t *diptr, int idx)
 {
   int     i;
 
-  memset ( (char *) diptr, '\0', sizeof (di_disk_info_t));
-  diptr->sortIndex [DI_SORT_MAIN] = idx;
-  diptr->sortIndex [DI_SORT_TOTAL] = idx;
-  for (i = 0; i < DI_VALUE_MAX; ++i) {
-    dinum_init (&diptr->values [i]);
-  }
-  diptr->doPrint = 0;
-  diptr->printFlag = DI_PRNT_OK;
-  diptr->isLocal = true;
-  diptr->isReadOnly = false;
-  diptr->isLoopback = false;
+  initDiskInfo (diptr, idx);
   diptr->strdata [DI_DISP_MOUNTPT] = (char *) malloc (DI_MOUNTPT_LEN);
   diptr->strdata [DI_DISP_FILESYSTEM] = (char *) malloc (DI_FILESYSTEM_LEN);
   diptr->strdata [DI_DISP_MOUNTOPT] = (char *) malloc (DI_MOUNTOPT_LEN);
   diptr->strdata [DI_DISP_FSTYPE] = (char *) malloc (DI_FSTYPE_LEN);
   for (i = 0; i < DI_DISP_MAX; ++i) {
     diptr->strdata [i][0] = '\0';
+    diptr->strStaged |= 1 << i;
   }
 }
 
+void
+di_initialize_disk_info_arena (di_disk_info_t *diptr, int idx)
+{
+  int     i;
+
+  initDiskInfo (diptr, idx);
+  for (i = 0; i < DI_DISP_MAX; ++i) {
+    diptr->strdata [i] = diEmptyStr;
+  }
+}
+
+void
+di_set_disk_string (di_data_t *di_data, di_disk_info_t *diptr,
+    int stridx, const char *str)
+{
+  char    *p;
+  int     id;
+
+  p = diEmptyStr;
+  id = -1;
+  if (stridx == DI_DISP_MOUNTOPT) {
+    /* statvfs () sharing needs to know about project quotas, */
+    /* even if the mount options are not kept                 */
+    diptr->hasPrjQuota = hasMountOption (str, "prjquota") ||
+        hasMountOption (str, "pquota") ||
+        hasMountOption (str, "pqnoenforce");
+  }
+  if (stridx == DI_DISP_MOUNTPT) {
+    /* the mount points are unique, there is no point in interning them */
+    if (*str) {
+      p = di_arena_strdup (&di_data->arena, str);
+      if (p == NULL) {
+        p = diEmptyStr;
+      }
+    }
+  } else if (stridx != DI_DISP_MOUNTOPT || di_data->plan.options) {
+    id = di_intern (di_data, str);
+    if (id >= 0) {
+      p = di_data->intern.strs [id];
+    }
+  }
+  if ((diptr->strStaged & (1 << stridx)) != 0) {
+    free (diptr->strdata [stridx]);
+    diptr->strStaged &= ~ (1 << stridx);
+  }
+  diptr->strdata [stridx] = p;
+  diptr->strId [stridx] = id;
+  /* the remote mounts are known before any of the mounts is probed */
+  if (stridx == DI_DISP_FSTYPE) {
+    diptr->fsClass = fstypeClass (di_data, id);
+    di_is_remote_disk (diptr);
+  }
+}
+
+/* the string buffers filled in by the platform code are replaced */
+/* by exact length copies in the arena                            */
+void
+di_compact_disk_info (di_data_t *di_data)
+{
+  di_disk_info_t  *diptr;
+  int             i;
+  int             j;
+
+  for (i = 0; i < di_data->fscount; ++i) {
+    diptr = &di_data->diskInfo [i];
+    if (diptr->strStaged == 0) {
+      continue;
+    }
+    for (j = 0; j < DI_DISP_MAX; ++j) {
+      if ((diptr->strStaged & (1 << j)) != 0) {
+        di_set_disk_string (di_data, diptr, j, diptr->strdata [j]);
+      }
+    }
+  }
+}
+
+/* the path lists are compiled; the cost does not depend on their length */
+int
+di_filter_paths (di_data_t *di_data, const char *mountpt)
+{
+  di_opt_t    *diopts;
+  int         match;
+
+  diopts = (di_opt_t *) di_data->options;
+  match = 0;
+  if (diopts->exclude_path_list.count > 0 &&
+      di_opt_path_match (&diopts->exclude_paths, mountpt)) {
+    match |= DI_FILTER_EXCL_PATH;
+  }
+  if (diopts->include_path_list.count > 0 &&
+      di_opt_path_match (&diopts->include_paths, mountpt)) {
+    match |= DI_FILTER_INCL_PATH;
+  }
+  return match;
+}
+
+/*
+ * An entry is excluded if it matches either of the exclude lists.
+ * If include lists are set, the entry must match each of them.
+ * The include lists override the -x list, but not --exclude-path:
+ * a mount point in the --exclude-path list is never included.
+ * The type lists have already been checked by fstypeClass ().
+ */
+int
+di_filter_match (di_data_t *di_data, int fsclass, int pathmatch)
+{
+  di_opt_t    *diopts;
+  int         match;
+
+  diopts = (di_opt_t *) di_data->options;
+  match = 0;
+  if ((diopts->exclude_list.count > 0 &&
+      (fsclass & DI_FSCLASS_EXCLUDE) == DI_FSCLASS_EXCLUDE) ||
+      (pathmatch & DI_FILTER_EXCL_PATH) == DI_FILTER_EXCL_PATH) {
+    match |= DI_FILTER_EXCLUDE;
+  }
+
+  if (diopts->include_list.count > 0 ||
+      diopts->include_path_list.count > 0) {
+    match |= DI_FILTER_INCLIST | DI_FILTER_INCLUDE;
+    if (diopts->include_list.count > 0 &&
+        (fsclass & DI_FSCLASS_INCLUDE) != DI_FSCLASS_INCLUDE) {
+      match &= ~DI_FILTER_INCLUDE;
+    }
+    if (diopts->include_path_list.count > 0 &&
+        (pathmatch & DI_FILTER_INCL_PATH) != DI_FILTER_INCL_PATH) {
+      match &= ~DI_FILTER_INCLUDE;
+    }
+    if ((pathmatch & DI_FILTER_EXCL_PATH) == DI_FILTER_EXCL_PATH) {
+      match &= ~DI_FILTER_INCLUDE;
+    }
+  }
+  return match;
+}
+
+/*
+ * The -x, -I, --exclude-path, --include-path and -l filters only need
+ * the file system type and the mount point, and are applied by the
+ * mount table code before an entry is stored.  The include lists
+ * override the -x and -l filters, as in preCheckDiskInfo ().  An
+ * --exclude-path match is never included.  The pooled file
+ * systems are always kept.
+ */
+int
+di_drop_mount (di_data_t *di_data, const char *fstype, const char *mountpt)
+{
+  di_opt_t    *diopts;
+  int         fsclass;
+  int         match;
+  int         drop;
+
+  if (! di_data->plan.filter) {
+    return false;
+  }
+
+  diopts = (di_opt_t *) di_data->options;
+  fsclass = fstypeClass (di_data, di_intern (di_data, fstype));
+  if ((fsclass & DI_FSCLASS_POOLED) == DI_FSCLASS_POOLED ||
+      (fsclass & DI_FSCLASS_NULL) == DI_FSCLASS_NULL) {
+    return false;
+  }
+
+  match = di_filter_match (di_data, fsclass, di_filter_paths (di_data, mountpt));
+  drop = false;
+  if ((match & DI_FILTER_INCLIST) == DI_FILTER_INCLIST) {
+    if ((match & DI_FILTER_INCLUDE) != DI_FILTER_INCLUDE) {
+      drop = true;
+    }
+  } else if ((match & DI_FILTER_EXCLUDE) == DI_FILTER_EXCLUDE) {
+    drop = true;
+  } else if (diopts->optval [DI_OPT_LOCAL_ONLY] &&
+      (fsclass & DI_FSCLASS_REMOTE) == DI_FSCLASS_REMOTE) {
+    drop = true;
+  }
+
+  if (drop) {
+    ++di_data->fsdropped;
+    if (diopts->optval [DI_OPT_DEBUG] > 2) {
+      printf ("mnt: drop: fstype %s: %s\n", fstype, mountpt);
+    }
+  }
+  return drop;
+}
+
 void
 di_free_disk_info (di_disk_info_t *diptr)
 {
@@ -97,18 +343,26 @@ di_free_disk_info (di_disk_info_t *diptr)
   for (i = 0; i < DI_VALUE_MAX; ++i) {
     dinum_clear (&diptr->values [i]);
   }
-  if (diptr->strdata [DI_DISP_MOUNTPT] != NULL) {
-    free (diptr->strdata [DI_DISP_MOUNTPT]);
-  }
-  if (diptr->strdata [DI_DISP_FILESYSTEM] != NULL) {
-    free (diptr->strdata [DI_DISP_FILESYSTEM]);
-  }
-  if (diptr->strdata [DI_DISP_FSTYPE] != NULL) {
-    free (diptr->strdata [DI_DISP_FSTYPE]);
+  /* all other strings are in the arena */
+  for (i = 0; i < DI_DISP_MAX; ++i) {
+    if ((diptr->strStaged & (1 << i)) != 0 && diptr->strdata [i] != NULL) {
+      free (diptr->strdata [i]);
+    }
+    diptr->strdata [i] = diEmptyStr;
   }
-  if (diptr->strdata [DI_DISP_MOUNTOPT] != NULL) {
-    free (diptr->strdata [DI_DISP_MOUNTOPT]);
+  diptr->strStaged = 0;
+  di_release_disk_fd (diptr);
+}
+
+void
+di_release_disk_fd (di_disk_info_t *diptr)
+{
+#if _hdr_unistd
+  if (diptr->mntFd >= 0) {
+    close (diptr->mntFd);
   }
+#endif
+  diptr->mntFd = -1;
 }
 
 void
@@ -129,6 +383,16 @@ di_save_inode_sizes (di_disk_info_t *diptr, di_ui_t total_nodes,
   dinum_set_u (&diptr->values [DI_INODE_AVAIL], avail_nodes);
 }
 
+void
+di_copy_disk_values (di_disk_info_t *diptr, const di_disk_info_t *src)
+{
+  int     i;
+
+  for (i = 0; i < DI_VALUE_MAX; ++i) {
+    dinum_set (&diptr->values [i], &src->values [i]);
+  }
+}
+
 void
 convertMountOptions (unsigned long flags, di_disk_info_t *diptr)
 {
@@ -390,7 +654,7 @@ chkMountOptions (const char *mntopts, const char *str)
 void
 di_is_remote_disk (di_disk_info_t *diskInfo)
 {
-  if (strncmp (diskInfo->strdata [DI_DISP_FSTYPE], "nfs", 3) == 0) {
+  if ((diskInfo->fsClass & DI_FSCLASS_REMOTE) == DI_FSCLASS_REMOTE) {
     diskInfo->isLocal = false;
   }
 }
@@ -398,10 +662,8 @@ di_is_remote_disk (di_disk_info_t *diskInfo)
 int
 di_isPooledFs (di_disk_info_t *diskInfo)
 {
-  if (strcmp (diskInfo->strdata [DI_DISP_FSTYPE], "zfs") == 0 ||
-      strcmp (diskInfo->strdata [DI_DISP_FSTYPE], "advfs") == 0 ||
-      strcmp (diskInfo->strdata [DI_DISP_FSTYPE], "apfs") == 0 ||
-      (strcmp (diskInfo->strdata [DI_DISP_FSTYPE], "null") == 0 &&
+  if ((diskInfo->fsClass & DI_FSCLASS_POOLED) == DI_FSCLASS_POOLED ||
+      ((diskInfo->fsClass & DI_FSCLASS_NULL) == DI_FSCLASS_NULL &&
        strstr (diskInfo->strdata [DI_DISP_FILESYSTEM], "/@@-") != (char *) NULL)) {
     return true;
   }
@@ -411,10 +673,11 @@ di_isPooledFs (di_disk_info_t *diskInfo)
 int
 di_isLoopbackFs (di_disk_info_t *diskInfo)
 {
-  if ((strcmp (diskInfo->strdata [DI_DISP_FSTYPE], "lofs") == 0 && diskInfo->sp_rdev != 0) ||
-      (strcmp (diskInfo->strdata [DI_DISP_FSTYPE], "nullfs") == 0 &&
+  if (((diskInfo->fsClass & DI_FSCLASS_LOFS) == DI_FSCLASS_LOFS &&
+       diskInfo->sp_rdev != 0) ||
+      ((diskInfo->fsClass & DI_FSCLASS_NULLFS) == DI_FSCLASS_NULLFS &&
        strstr (diskInfo->strdata [DI_DISP_FILESYSTEM], "/@@-") == (char *) NULL) ||
-      strcmp (diskInfo->strdata [DI_DISP_FSTYPE], "none") == 0) {
+      (diskInfo->fsClass & DI_FSCLASS_NONE) == DI_FSCLASS_NONE) {
     return true;
   }
   return false;
@@ -456,3 +719,113 @@ di_mungePoolName (char *poolname)
   return strlen (poolname);
 }
 
+
+static int
+hasMountOption (const char *opts, const char *name)
+{
+  const char  *p;
+  Size_t      len;
+
+  len = strlen (name);
+  p = opts;
+  while ( (p = strstr (p, name)) != NULL) {
+    if ( (p == opts || p [-1] == ',') &&
+        (p [len] == '\0' || p [len] == ',' || p [len] == '=')) {
+      return true;
+    }
+    p += len;
+  }
+  return false;
+}
+
+static void
+initDiskInfo (di_disk_info_t *diptr, int idx)
+{
+  int     i;
+
+  memset ( (char *) diptr, '\0', sizeof (di_disk_info_t));
+  diptr->sortIndex [DI_SORT_MAIN] = idx;
+  diptr->sortIndex [DI_SORT_TOTAL] = idx;
+  for (i = 0; i < DI_VALUE_MAX; ++i) {
+    dinum_init (&diptr->values [i]);
+  }
+  diptr->doPrint = 0;
+  diptr->printFlag = DI_PRNT_OK;
+  diptr->isLocal = true;
+  diptr->isReadOnly = false;
+  diptr->isLoopback = false;
+  diptr->hasPrjQuota = false;
+  diptr->topHidden = false;
+  diptr->whereHidden = false;
+  diptr->mntFd = -1;
+  diptr->statRep = -1;
+  diptr->strStaged = 0;
+  for (i = 0; i < DI_DISP_MAX; ++i) {
+    diptr->strId [i] = -1;
+  }
+  diptr->fsClass = 0;
+  diptr->pathFilter = 0;
+}
+
+/* the class is computed once for each distinct file system type */
+static int
+fstypeClass (di_data_t *di_data, int id)
+{
+  const char    *fstype;
+  di_opt_t      *diopts;
+  int           fsclass;
+  int           i;
+
+  if (id < 0) {
+    return 0;
+  }
+  if (di_data->intern.fsclass [id] != 0) {
+    return di_data->intern.fsclass [id];
+  }
+
+  diopts = (di_opt_t *) di_data->options;
+  fstype = di_data->intern.strs [id];
+  fsclass = DI_FSCLASS_VALID;
+
+  if (strcmp (fstype, "zfs") == 0 ||
+      strcmp (fstype, "advfs") == 0 ||
+      strcmp (fstype, "apfs") == 0) {
+    fsclass |= DI_FSCLASS_POOLED;
+  }
+  if (strcmp (fstype, "apfs") == 0) {
+    fsclass |= DI_FSCLASS_APFS;
+  }
+  if (strcmp (fstype, "null") == 0) {
+    fsclass |= DI_FSCLASS_NULL;
+  }
+  if (di_opt_type_match (&diopts->remote_types, fstype)) {
+    fsclass |= DI_FSCLASS_REMOTE;
+  }
+  if (strcmp (fstype, "lofs") == 0) {
+    fsclass |= DI_FSCLASS_LOFS;
+  }
+  if (strcmp (fstype, "nullfs") == 0) {
+    fsclass |= DI_FSCLASS_NULLFS;
+  }
+  if (strcmp (fstype, "none") == 0) {
+    fsclass |= DI_FSCLASS_NONE;
+  }
+  if (strcmp (fstype, "btrfs") == 0) {
+    fsclass |= DI_FSCLASS_BTRFS;
+  }
+  for (i = 0; i < DI_IGNORE_FSTYPE_COUNT; ++i) {
+    if (strcmp (fstype, diIgnoreFSTypes [i]) == 0) {
+      fsclass |= DI_FSCLASS_IGNORE;
+      break;
+    }
+  }
+  if (di_opt_type_match (&diopts->exclude_types, fstype)) {
+    fsclass |= DI_FSCLASS_EXCLUDE;
+  }
+  if (di_opt_type_match (&diopts->include_types, fstype)) {
+    fsclass |= DI_FSCLASS_INCLUDE;
+  }
+
+  di_data->intern.fsclass [id] = fsclass;
+  return fsclass;
+}
@@ -8,6 +8,8 @@
  *    di_get_disk_entries ()
  *        Get a list of mounted filesystems.
  *        In many cases, this also does the work of di_get_disk_info ().
+ *    di_get_mount_entry ()
+ *        Get a single mounted filesystem by its mount id.
  */
 
 #include "config.h"
@@ -43,6 +45,24 @@
 #if _hdr_errno
 # include <errno.h>
 #endif
+#if _hdr_fcntl
+# include <fcntl.h>
+#endif
+#if _hdr_unistd
+# include <unistd.h>
+#endif
+#if _sys_sysmacros
+# include <sys/sysmacros.h>     /* makedev () */
+#endif
+#if _hdr_stdint
+# include <stdint.h>
+#endif
+#if _sys_syscall
+# include <sys/syscall.h>       /* linux: statmount (), listmount () */
+#endif
+#if _hdr_poll
+# include <poll.h>              /* mount table change notification */
+#endif
 #if _hdr_string
 # include <string.h>
 #endif
@@ -199,11 +219,7 @@ di_get_disk_entries (di_data_t *di_data, int *diCount)
   while (getmntent (f, &mntEntry) == 0) {
     idx = *diCount;
     *diCount += 1;
-    di_data->diskInfo = (di_disk_info_t *) di_realloc (
-        (char *) di_data->diskInfo,
-        sizeof (di_disk_info_t) * (Size_t) (*diCount + 1));
-    if (di_data->diskInfo == (di_disk_info_t *) NULL) {
-      fprintf (stderr, "malloc failed for diskInfo. errno %d\n", errno);
+    if (di_disk_info_reserve (di_data, *diCount) < 0) {
       return -1;
     }
     diptr = di_data->diskInfo + idx;
@@ -277,6 +293,121 @@ checkMountOptions (struct mnttab *mntEntry, char *str)
 # define MNTTYPE_IGNORE "ignore"
 #endif
 
+#if (defined (linux) || defined (__linux__)) && _hdr_fcntl && _hdr_unistd
+# define DI_MOUNTINFO_FILE "/proc/self/mountinfo"
+#endif
+
+/* statmount () and listmount () were added in linux 6.8.   */
+/* The C library may not have the syscall numbers or structures yet. */
+#if defined (DI_MOUNTINFO_FILE) && _lib_syscall && _sys_syscall && _hdr_stdint
+# if ! defined (__NR_statmount) && ! defined (__alpha__)
+#  define __NR_statmount 457
+# endif
+# if ! defined (__NR_listmount) && ! defined (__alpha__)
+#  define __NR_listmount 458
+# endif
+# if defined (__NR_statmount) && defined (__NR_listmount)
+#  define DI_USE_STATMOUNT 1
+# endif
+#endif
+
+#if defined (DI_USE_STATMOUNT)
+
+/* struct mnt_id_req, MNT_ID_REQ_SIZE_VER0 */
+typedef struct {
+  uint32_t    size;
+  uint32_t    spare;
+  uint64_t    mnt_id;
+  uint64_t    param;
+} di_mnt_id_req_t;
+
+/* struct statmount; the strings follow the structure, at offset 512 */
+/* (sizeof (struct statmount)) in all versions                        */
+typedef struct {
+  uint32_t    size;
+  uint32_t    mnt_opts;
+  uint64_t    mask;
+  uint32_t    sb_dev_major;
+  uint32_t    sb_dev_minor;
+  uint64_t    sb_magic;
+  uint32_t    sb_flags;
+  uint32_t    fs_type;
+  uint64_t    mnt_id;
+  uint64_t    mnt_parent_id;
+  uint32_t    mnt_id_old;
+  uint32_t    mnt_parent_id_old;
+  uint64_t    mnt_attr;
+  uint64_t    mnt_propagation;
+  uint64_t    mnt_peer_group;
+  uint64_t    mnt_master;
+  uint64_t    propagate_from;
+  uint32_t    mnt_root;
+  uint32_t    mnt_point;
+  uint64_t    mnt_ns_id;
+  uint32_t    fs_subtype;
+  uint32_t    sb_source;
+  uint32_t    opt_num;
+  uint32_t    opt_array;
+  uint32_t    opt_sec_num;
+  uint32_t    opt_sec_array;
+  uint64_t    supported_mask;
+  uint32_t    mnt_uidmap_num;
+  uint32_t    mnt_uidmap;
+  uint32_t    mnt_gidmap_num;
+  uint32_t    mnt_gidmap;
+  uint64_t    spare2 [43];
+} di_statmount_t;
+
+# define DI_LSMT_ROOT                 0xffffffffffffffffULL
+# define DI_LISTMOUNT_BATCH           512
+# define DI_STATMOUNT_BUFSZ           8192
+
+# define DI_STATMOUNT_SB_BASIC        0x00000001U
+# define DI_STATMOUNT_MNT_BASIC       0x00000002U
+# define DI_STATMOUNT_MNT_ROOT        0x00000008U
+# define DI_STATMOUNT_MNT_POINT       0x00000010U
+# define DI_STATMOUNT_FS_TYPE         0x00000020U
+# define DI_STATMOUNT_MNT_OPTS        0x00000080U
+# define DI_STATMOUNT_FS_SUBTYPE      0x00000100U
+# define DI_STATMOUNT_SB_SOURCE       0x00000200U
+/* The mount options and fs subtype are not returned if they are  */
+/* empty.  sb_source was added after the mount options, so if it   */
+/* is returned, a missing mount option string is really empty.     */
+# define DI_STATMOUNT_REQUIRED        (DI_STATMOUNT_SB_BASIC | \
+    DI_STATMOUNT_MNT_BASIC | DI_STATMOUNT_MNT_ROOT | \
+    DI_STATMOUNT_MNT_POINT | DI_STATMOUNT_FS_TYPE | \
+    DI_STATMOUNT_SB_SOURCE)
+
+/* MOUNT_ATTR_* */
+# define DI_MOUNT_ATTR_RDONLY         0x00000001
+# define DI_MOUNT_ATTR_NOSUID         0x00000002
+# define DI_MOUNT_ATTR_NODEV          0x00000004
+# define DI_MOUNT_ATTR_NOEXEC         0x00000008
+# define DI_MOUNT_ATTR__ATIME         0x00000070
+# define DI_MOUNT_ATTR_RELATIME       0x00000000
+# define DI_MOUNT_ATTR_NOATIME        0x00000010
+# define DI_MOUNT_ATTR_NODIRATIME     0x00000080
+# define DI_MOUNT_ATTR_NOSYMFOLLOW    0x00200000
+/* SB_* */
+# define DI_SB_RDONLY                 0x00000001
+# define DI_SB_SYNCHRONOUS            0x00000010
+# define DI_SB_MANDLOCK               0x00000040
+# define DI_SB_DIRSYNC                0x00000080
+# define DI_SB_LAZYTIME               0x02000000
+
+static int  di_get_statmount_entries (di_data_t *, int *);
+static int  statmountEntry (di_data_t *, di_disk_info_t *, uint64_t, di_statmount_t **, Size_t *);
+static void statmountOptions (di_data_t *, di_disk_info_t *, di_statmount_t *, const char *);
+
+#endif
+
+#if defined (DI_MOUNTINFO_FILE)
+static int  di_get_mountinfo_entries (di_data_t *, int *);
+static char *mntinfoReadFile (const char *, Size_t *);
+static char *mntinfoToken (char **, char *);
+static void mntinfoUnescape (char *);
+#endif
+
 int
 di_get_disk_entries (di_data_t *di_data, int *diCount)
 {
@@ -289,6 +420,18 @@ di_get_disk_entries (di_data_t *di_data, int *diCount)
 
   diopts = (di_opt_t *) di_data->options;
 
+#if defined (DI_USE_STATMOUNT)
+  if (di_get_statmount_entries (di_data, diCount) == 0) {
+    return 0;
+  }
+#endif
+#if defined (DI_MOUNTINFO_FILE)
+  /* the mountinfo file has more information, and is faster to process */
+  if (di_get_mountinfo_entries (di_data, diCount) == 0) {
+    return 0;
+  }
+#endif
+
   if (diopts->optval [DI_OPT_DEBUG] > 0) { printf ("# di_get_disk_entries: set/get/endmntent\n"); }
 /* if both are set not an ansi compiler... */
 #if _args_setmntent == 1
@@ -301,13 +444,12 @@ di_get_disk_entries (di_data_t *di_data, int *diCount)
   }
 
   while ( (mntEntry = getmntent (f)) != (struct mntent *) NULL) {
+    if (di_drop_mount (di_data, mntEntry->mnt_type, mntEntry->mnt_dir)) {
+      continue;
+    }
     idx = *diCount;
     *diCount += 1;
-    di_data->diskInfo = (di_disk_info_t *) di_realloc (
-        (char *) di_data->diskInfo,
-        sizeof (di_disk_info_t) * (Size_t) (*diCount + 1));
-    if (di_data->diskInfo == (di_disk_info_t *) NULL) {
-      fprintf (stderr, "malloc failed for diskInfo. errno %d\n", errno);
+    if (di_disk_info_reserve (di_data, *diCount) < 0) {
       return -1;
     }
     diptr = di_data->diskInfo + idx;
@@ -361,6 +503,611 @@ di_get_disk_entries (di_data_t *di_data, int *diCount)
   return 0;
 }
 
+#if defined (DI_MOUNTINFO_FILE)
+
+/*
+ * di_get_mountinfo_entries
+ *
+ * Linux: /proc/self/mountinfo
+ *
+ * The file is read into a single buffer and tokenized in place.
+ * Unlike /proc/mounts, this also has the mount id, parent id,
+ * major:minor device number and the root of each mount.
+ *
+ * Returns -1 if the file could not be read, and no entries
+ * have been added.
+ *
+ */
+
+static int
+di_get_mountinfo_entries (di_data_t *di_data, int *diCount)
+{
+  di_disk_info_t  *diptr;
+  char            *buff;
+  char            *p;
+  char            *eol;
+  char            *bend;
+  Size_t          len;
+  int             lines;
+  int             idx;
+  di_opt_t        *diopts;
+
+  diopts = (di_opt_t *) di_data->options;
+
+  buff = mntinfoReadFile (DI_MOUNTINFO_FILE, &len);
+  if (buff == NULL) {
+    return -1;
+  }
+
+  if (diopts->optval [DI_OPT_DEBUG] > 0) { printf ("# di_get_disk_entries: mountinfo\n"); }
+
+  bend = buff + len;
+  lines = 0;
+  p = buff;
+  while (p < bend) {
+    eol = (char *) memchr (p, '\n', (Size_t) (bend - p));
+    ++lines;
+    if (eol == NULL) {
+      break;
+    }
+    p = eol + 1;
+  }
+
+  if (di_disk_info_reserve (di_data, *diCount + lines) < 0) {
+    free (buff);
+    return -1;
+  }
+
+  p = buff;
+  while (p < bend) {
+    char            *mntid;
+    char            *parentid;
+    char            *majmin;
+    char            *root;
+    char            *mountpt;
+    char            *mntopts;
+    char            *fstype;
+    char            *special;
+    char            *superopts;
+    char            *tok;
+    char            *op;
+    char            *opend;
+    char            *devp;
+    char            optbuff [DI_MOUNTOPT_LEN];
+    unsigned int    maj;
+    unsigned int    min;
+
+    eol = (char *) memchr (p, '\n', (Size_t) (bend - p));
+    if (eol == NULL) {
+      eol = bend;
+    }
+    *eol = '\0';
+
+    /* id parent maj:min root mount-point options [optional...] - */
+    /*   fstype special super-options                              */
+    mntid = mntinfoToken (&p, eol);
+    parentid = mntinfoToken (&p, eol);
+    majmin = mntinfoToken (&p, eol);
+    root = mntinfoToken (&p, eol);
+    mountpt = mntinfoToken (&p, eol);
+    mntopts = mntinfoToken (&p, eol);
+    tok = mntinfoToken (&p, eol);
+    while (tok != NULL && strcmp (tok, "-") != 0) {
+      tok = mntinfoToken (&p, eol);
+    }
+    fstype = mntinfoToken (&p, eol);
+    special = mntinfoToken (&p, eol);
+    superopts = mntinfoToken (&p, eol);
+
+    p = eol + 1;
+    if (superopts == NULL) {
+      /* malformed, or an empty line */
+      continue;
+    }
+    mntinfoUnescape (mountpt);
+    if (di_drop_mount (di_data, fstype, mountpt)) {
+      continue;
+    }
+    mntinfoUnescape (root);
+    mntinfoUnescape (special);
+
+    idx = *diCount;
+    *diCount += 1;
+    diptr = di_data->diskInfo + idx;
+    di_initialize_disk_info_arena (diptr, idx);
+
+    diptr->mntId = strtoul (mntid, NULL, 10);
+    diptr->mntParentId = strtoul (parentid, NULL, 10);
+    diptr->hasMntId = true;
+    maj = (unsigned int) strtoul (majmin, &tok, 10);
+    min = 0;
+    if (*tok == ':') {
+      min = (unsigned int) strtoul (tok + 1, NULL, 10);
+    }
+# if defined (makedev)
+    diptr->mntDev = (unsigned long) makedev (maj, min);
+# else
+    diptr->mntDev = ((unsigned long) maj << 8) | min;
+# endif
+    diptr->hasMntDev = true;
+    diptr->mntRoot = di_arena_strdup (&di_data->arena, root);
+
+    di_set_disk_string (di_data, diptr, DI_DISP_FILESYSTEM, special);
+    di_set_disk_string (di_data, diptr, DI_DISP_MOUNTPT, mountpt);
+    di_set_disk_string (di_data, diptr, DI_DISP_FSTYPE, fstype);
+
+    if (strcmp (special, "none") == 0) {
+      diptr->printFlag = DI_PRNT_IGNORE;
+      if (diopts->optval [DI_OPT_DEBUG] > 2) {
+        printf ("mnt: ignore: special 'none': %s\n", diptr->strdata [DI_DISP_MOUNTPT]);
+      }
+    }
+
+    if (strcmp (fstype, MNTTYPE_IGNORE) == 0) {
+      diptr->printFlag = DI_PRNT_IGNORE;
+      if (diopts->optval [DI_OPT_DEBUG] > 2) {
+        printf ("mnt: ignore: mntopt 'ignore': %s\n",
+            diptr->strdata [DI_DISP_MOUNTPT]);
+      }
+    }
+
+    /* /proc/mounts displays the mount options followed by the */
+    /* super block options, without the super block's ro/rw   */
+    if (strncmp (superopts, "rw", 2) == 0 ||
+        strncmp (superopts, "ro", 2) == 0) {
+      if (superopts [2] == ',' || superopts [2] == '\0') {
+        superopts += 2;
+        if (*superopts == ',') {
+          ++superopts;
+        }
+      }
+    }
+    op = optbuff;
+    opend = optbuff + sizeof (optbuff);
+    op = stpecpy (op, opend, mntopts);
+    if (*superopts) {
+      op = stpecpy (op, opend, ",");
+      stpecpy (op, opend, superopts);
+    }
+
+    op = optbuff;
+    if ( (devp = strstr (op, "dev=")) != (char *) NULL) {
+      if (devp != op) {
+        --devp;
+      }
+      *devp = 0;   /* point to preceeding comma and cut off */
+    }
+    if (chkMountOptions (op, DI_MNTOPT_RO) != (char *) NULL) {
+      diptr->isReadOnly = true;
+    }
+    di_set_disk_string (di_data, diptr, DI_DISP_MOUNTOPT, optbuff);
+
+    if (diopts->optval [DI_OPT_DEBUG] > 1) {
+      printf ("mnt:%s - %s : %s\n", diptr->strdata [DI_DISP_MOUNTPT],
+          diptr->strdata [DI_DISP_FILESYSTEM], diptr->strdata [DI_DISP_FSTYPE]);
+    }
+  }
+
+  free (buff);
+  return 0;
+}
+
+/* the entire file is read; the buffer is grown geometrically */
+static char *
+mntinfoReadFile (const char *fn, Size_t *len)
+{
+  int       fd;
+  char      *buff;
+  char      *tbuff;
+  Size_t    sz;
+  Size_t    used;
+  ssize_t   rc;
+
+  *len = 0;
+  fd = open (fn, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  sz = 65536;
+  used = 0;
+  buff = (char *) malloc (sz);
+  while (buff != NULL) {
+    rc = read (fd, buff + used, sz - used - 1);
+    if (rc < 0 && errno == EINTR) {
+      continue;
+    }
+    if (rc < 0) {
+      free (buff);
+      buff = NULL;
+      break;
+    }
+    if (rc == 0) {
+      break;
+    }
+    used += (Size_t) rc;
+    if (used + 1 >= sz) {
+      sz *= 2;
+      tbuff = (char *) realloc (buff, sz);
+      if (tbuff == NULL) {
+        fprintf (stderr, "malloc failed in mntinfoReadFile.  errno %d\n", errno);
+        free (buff);
+      }
+      buff = tbuff;
+    }
+  }
+  close (fd);
+
+  if (buff != NULL) {
+    buff [used] = '\0';
+    *len = used;
+  }
+  return buff;
+}
+
+/* returns the next space separated token, and terminates it */
+static char *
+mntinfoToken (char **pp, char *end)
+{
+  char      *tok;
+  char      *sp;
+
+  tok = *pp;
+  if (tok >= end) {
+    return NULL;
+  }
+  /* end is already terminated */
+  sp = (char *) memchr (tok, ' ', (Size_t) (end - tok));
+  if (sp == NULL) {
+    *pp = end;
+    return tok;
+  }
+  *sp = '\0';
+  *pp = sp + 1;
+  return tok;
+}
+
+/* the kernel escapes space, tab, newline and backslash as \ooo */
+static void
+mntinfoUnescape (char *str)
+{
+  char      *rp;
+  char      *wp;
+
+  rp = strchr (str, '\\');
+  if (rp == NULL) {
+    return;
+  }
+
+  wp = rp;
+  while (*rp) {
+    if (rp [0] == '\\' &&
+        rp [1] >= '0' && rp [1] <= '3' &&
+        rp [2] >= '0' && rp [2] <= '7' &&
+        rp [3] >= '0' && rp [3] <= '7') {
+      *wp++ = (char) (((rp [1] - '0') << 6) |
+          ((rp [2] - '0') << 3) | (rp [3] - '0'));
+      rp += 4;
+      continue;
+    }
+    *wp++ = *rp++;
+  }
+  *wp = '\0';
+}
+
+#endif /* DI_MOUNTINFO_FILE */
+
+#if defined (DI_USE_STATMOUNT)
+
+/*
+ * di_get_statmount_entries
+ *
+ * Linux 6.8+: listmount () and statmount ()
+ *
+ * The mount ids are fetched with listmount () in batches, and
+ * each mount's attributes with statmount (); no text is parsed.
+ *
+ * Returns -1 if the kernel does not support these calls, or does
+ * not return the needed information; no entries are added.
+ *
+ */
+
+static int
+di_get_statmount_entries (di_data_t *di_data, int *diCount)
+{
+  di_disk_info_t  *diptr;
+  di_mnt_id_req_t req;
+  di_statmount_t  *sm;
+  uint64_t        *ids;
+  uint64_t        cursor;
+  Size_t          smsz;
+  int             startCount;
+  int             rc;
+  int             erc;
+  int             slotinit;
+  long            count;
+  long            i;
+  di_opt_t        *diopts;
+
+  diopts = (di_opt_t *) di_data->options;
+
+  ids = (uint64_t *) malloc (sizeof (uint64_t) * DI_LISTMOUNT_BATCH);
+  smsz = DI_STATMOUNT_BUFSZ;
+  sm = (di_statmount_t *) malloc (smsz);
+  if (ids == NULL || sm == NULL) {
+    fprintf (stderr, "malloc failed in di_get_statmount_entries.  errno %d\n", errno);
+    free (ids);
+    free (sm);
+    return -1;
+  }
+
+  startCount = *diCount;
+  rc = 0;
+  cursor = 0;
+  slotinit = false;
+
+  for (;;) {
+    memset (&req, 0, sizeof (req));
+    req.size = sizeof (req);
+    req.mnt_id = DI_LSMT_ROOT;
+    req.param = cursor;
+    count = syscall (__NR_listmount, &req, ids, (Size_t) DI_LISTMOUNT_BATCH, 0);
+    if (count < 0) {
+      rc = -1;
+      break;
+    }
+    if (count == 0) {
+      break;
+    }
+
+    if (di_disk_info_reserve (di_data, *diCount + (int) count) < 0) {
+      rc = -1;
+      break;
+    }
+
+    for (i = 0; i < count; ++i) {
+      diptr = di_data->diskInfo + *diCount;
+      if (! slotinit) {
+        di_initialize_disk_info_arena (diptr, *diCount);
+        slotinit = true;
+      }
+      erc = statmountEntry (di_data, diptr, ids [i], &sm, &smsz);
+      if (erc > 0) {
+        /* dropped by the filters before the slot is */
+        /* touched; the slot is used for the next mount */
+        continue;
+      }
+      if (erc != 0) {
+        di_free_disk_info (diptr);
+        slotinit = false;
+        if (errno == ENOENT) {
+          /* unmounted after the listmount () call */
+          continue;
+        }
+        rc = -1;
+        break;
+      }
+      *diCount += 1;
+      slotinit = false;
+    }
+    if (rc != 0) {
+      break;
+    }
+
+    cursor = ids [count - 1];
+    if (count < DI_LISTMOUNT_BATCH) {
+      break;
+    }
+  }
+
+  free (ids);
+  free (sm);
+  if (slotinit) {
+    /* the last mounts were dropped */
+    di_free_disk_info (di_data->diskInfo + *diCount);
+  }
+
+  if (rc != 0) {
+    if (diopts->optval [DI_OPT_DEBUG] > 0) {
+      printf ("# di_get_disk_entries: statmount: not available: errno %d\n", errno);
+    }
+    for (i = startCount; i < *diCount; ++i) {
+      di_free_disk_info (di_data->diskInfo + i);
+    }
+    *diCount = startCount;
+    return -1;
+  }
+
+  if (diopts->optval [DI_OPT_DEBUG] > 0) {
+    printf ("# di_get_disk_entries: statmount: %d mounts\n",
+        *diCount - startCount);
+  }
+  return 0;
+}
+
+/* fills in a disk info entry; the buffer is grown as needed.  */
+/* returns 1 if the mount is dropped by the filters            */
+static int
+statmountEntry (di_data_t *di_data, di_disk_info_t *diptr, uint64_t id,
+    di_statmount_t **smp, Size_t *smszp)
+{
+  di_mnt_id_req_t req;
+  di_statmount_t  *sm;
+  di_statmount_t  *tsm;
+  const char      *str;
+  char            *p;
+  char            *end;
+  char            fstype [DI_FSTYPE_LEN];
+  long            rc;
+  di_opt_t        *diopts;
+
+  diopts = (di_opt_t *) di_data->options;
+
+  memset (&req, 0, sizeof (req));
+  req.size = sizeof (req);
+  req.mnt_id = id;
+  req.param = DI_STATMOUNT_SB_BASIC | DI_STATMOUNT_MNT_BASIC |
+      DI_STATMOUNT_MNT_ROOT | DI_STATMOUNT_MNT_POINT |
+      DI_STATMOUNT_FS_TYPE | DI_STATMOUNT_MNT_OPTS |
+      DI_STATMOUNT_FS_SUBTYPE | DI_STATMOUNT_SB_SOURCE;
+
+  for (;;) {
+    sm = *smp;
+    rc = syscall (__NR_statmount, &req, sm, *smszp, 0);
+    if (rc == 0) {
+      break;
+    }
+    if (errno != EOVERFLOW) {
+      return -1;
+    }
+    tsm = (di_statmount_t *) realloc (sm, *smszp * 2);
+    if (tsm == NULL) {
+      fprintf (stderr, "malloc failed in statmountEntry.  errno %d\n", errno);
+      return -1;
+    }
+    *smp = tsm;
+    *smszp *= 2;
+  }
+
+  if ((sm->mask & DI_STATMOUNT_REQUIRED) != DI_STATMOUNT_REQUIRED) {
+    errno = EOPNOTSUPP;
+    return -1;
+  }
+
+  /* the strings are offsets past the fixed size structure */
+  str = (const char *) sm + sizeof (di_statmount_t);
+
+  p = fstype;
+  end = fstype + sizeof (fstype);
+  p = stpecpy (p, end, str + sm->fs_type);
+  /* mountinfo displays e.g. fuse.sshfs */
+  if ((sm->mask & DI_STATMOUNT_FS_SUBTYPE) == DI_STATMOUNT_FS_SUBTYPE &&
+      str [sm->fs_subtype] != '\0') {
+    p = stpecpy (p, end, ".");
+    stpecpy (p, end, str + sm->fs_subtype);
+  }
+  if (di_drop_mount (di_data, fstype, str + sm->mnt_point)) {
+    return 1;
+  }
+
+  diptr->mntId = sm->mnt_id_old;
+  diptr->mntParentId = sm->mnt_parent_id_old;
+  diptr->mntUniqueId = (di_mntid_t) sm->mnt_id;
+  diptr->hasMntId = true;
+# if defined (makedev)
+  diptr->mntDev = (unsigned long) makedev (sm->sb_dev_major, sm->sb_dev_minor);
+# else
+  diptr->mntDev = ((unsigned long) sm->sb_dev_major << 8) | sm->sb_dev_minor;
+# endif
+  diptr->hasMntDev = true;
+  diptr->mntRoot = di_arena_strdup (&di_data->arena, str + sm->mnt_root);
+
+  di_set_disk_string (di_data, diptr, DI_DISP_FILESYSTEM, str + sm->sb_source);
+  di_set_disk_string (di_data, diptr, DI_DISP_MOUNTPT, str + sm->mnt_point);
+  di_set_disk_string (di_data, diptr, DI_DISP_FSTYPE, fstype);
+
+  if (strcmp (diptr->strdata [DI_DISP_FILESYSTEM], "none") == 0) {
+    diptr->printFlag = DI_PRNT_IGNORE;
+    if (diopts->optval [DI_OPT_DEBUG] > 2) {
+      printf ("mnt: ignore: special 'none': %s\n", diptr->strdata [DI_DISP_MOUNTPT]);
+    }
+  }
+
+  if (strcmp (diptr->strdata [DI_DISP_FSTYPE], MNTTYPE_IGNORE) == 0) {
+    diptr->printFlag = DI_PRNT_IGNORE;
+    if (diopts->optval [DI_OPT_DEBUG] > 2) {
+      printf ("mnt: ignore: mntopt 'ignore': %s\n",
+          diptr->strdata [DI_DISP_MOUNTPT]);
+    }
+  }
+
+  if ((sm->mask & DI_STATMOUNT_MNT_OPTS) == DI_STATMOUNT_MNT_OPTS) {
+    statmountOptions (di_data, diptr, sm, str + sm->mnt_opts);
+  } else {
+    statmountOptions (di_data, diptr, sm, "");
+  }
+
+  if (diopts->optval [DI_OPT_DEBUG] > 1) {
+    printf ("mnt:%s - %s : %s\n", diptr->strdata [DI_DISP_MOUNTPT],
+        diptr->strdata [DI_DISP_FILESYSTEM], diptr->strdata [DI_DISP_FSTYPE]);
+  }
+
+  return 0;
+}
+
+/* builds the same option string as /proc/mounts: */
+/*   ro/rw, super block flags, mount flags, fs options */
+static void
+statmountOptions (di_data_t *di_data, di_disk_info_t *diptr,
+    di_statmount_t *sm, const char *fsopts)
+{
+  char      *p;
+  char      *end;
+  char      *devp;
+  char      optbuff [DI_MOUNTOPT_LEN];
+  uint64_t  attr;
+
+  attr = sm->mnt_attr;
+  p = optbuff;
+  end = optbuff + sizeof (optbuff);
+
+  if ((attr & DI_MOUNT_ATTR_RDONLY) == DI_MOUNT_ATTR_RDONLY ||
+      (sm->sb_flags & DI_SB_RDONLY) == DI_SB_RDONLY) {
+    p = stpecpy (p, end, "ro");
+    diptr->isReadOnly = true;
+  } else {
+    p = stpecpy (p, end, "rw");
+  }
+  if ((sm->sb_flags & DI_SB_SYNCHRONOUS) == DI_SB_SYNCHRONOUS) {
+    p = stpecpy (p, end, ",sync");
+  }
+  if ((sm->sb_flags & DI_SB_DIRSYNC) == DI_SB_DIRSYNC) {
+    p = stpecpy (p, end, ",dirsync");
+  }
+  if ((sm->sb_flags & DI_SB_MANDLOCK) == DI_SB_MANDLOCK) {
+    p = stpecpy (p, end, ",mand");
+  }
+  if ((sm->sb_flags & DI_SB_LAZYTIME) == DI_SB_LAZYTIME) {
+    p = stpecpy (p, end, ",lazytime");
+  }
+  if ((attr & DI_MOUNT_ATTR_NOSUID) == DI_MOUNT_ATTR_NOSUID) {
+    p = stpecpy (p, end, ",nosuid");
+  }
+  if ((attr & DI_MOUNT_ATTR_NODEV) == DI_MOUNT_ATTR_NODEV) {
+    p = stpecpy (p, end, ",nodev");
+  }
+  if ((attr & DI_MOUNT_ATTR_NOEXEC) == DI_MOUNT_ATTR_NOEXEC) {
+    p = stpecpy (p, end, ",noexec");
+  }
+  if ((attr & DI_MOUNT_ATTR__ATIME) == DI_MOUNT_ATTR_NOATIME) {
+    p = stpecpy (p, end, ",noatime");
+  }
+  if ((attr & DI_MOUNT_ATTR_NODIRATIME) == DI_MOUNT_ATTR_NODIRATIME) {
+    p = stpecpy (p, end, ",nodiratime");
+  }
+  if ((attr & DI_MOUNT_ATTR__ATIME) == DI_MOUNT_ATTR_RELATIME) {
+    p = stpecpy (p, end, ",relatime");
+  }
+  if ((attr & DI_MOUNT_ATTR_NOSYMFOLLOW) == DI_MOUNT_ATTR_NOSYMFOLLOW) {
+    p = stpecpy (p, end, ",nosymfollow");
+  }
+  if (*fsopts) {
+    p = stpecpy (p, end, ",");
+    stpecpy (p, end, fsopts);
+  }
+
+  p = optbuff;
+  if ( (devp = strstr (p, "dev=")) != (char *) NULL) {
+    if (devp != p) {
+      --devp;
+    }
+    *devp = 0;   /* point to preceeding comma and cut off */
+  }
+  di_set_disk_string (di_data, diptr, DI_DISP_MOUNTOPT, optbuff);
+}
+
+#endif /* DI_USE_STATMOUNT */
+
 #endif /* _lib_getmntent && _lib_setmntent && _lib_endmntent */
 
 /* QNX */
@@ -478,11 +1225,7 @@ di_getQNXDiskEntries (di_data_t *di_data, char *ipath, int *diCount)
 
     idx = *diCount;
     *diCount += 1;
-    di_data->diskInfo = (di_disk_info_t *) di_realloc (
-        (char *) di_data->diskInfo,
-        sizeof (di_disk_info_t) * (Size_t) (*diCount + 1));
-    if (di_data->diskInfo == (di_disk_info_t *) NULL) {
-      fprintf (stderr, "malloc failed for diskInfo. errno %d\n", errno);
+    if (di_disk_info_reserve (di_data, *diCount) < 0) {
       return -1;
     }
     diptr = di_data->diskInfo + idx;
@@ -552,11 +1295,7 @@ di_get_disk_entries (di_data_t *di_data, int *diCount)
         strcmp (mntEntry.mt_filsys, "nothing") != 0) {
       idx = *diCount;
       *diCount += 1;
-      di_data->diskInfo = (di_disk_info_t *) di_realloc (
-          (char *) di_data->diskInfo,
-          sizeof (di_disk_info_t) * (Size_t) (*diCount + 1));
-      if (di_data->diskInfo == (di_disk_info_t *) NULL) {
-        fprintf (stderr, "malloc failed for diskInfo. errno %d\n", errno);
+      if (di_disk_info_reserve (di_data, *diCount) < 0) {
         return -1;
       }
       diptr = di_data->diskInfo + idx;
@@ -1564,11 +2303,7 @@ di_get_disk_entries (di_data_t *di_data, int *diCount)
 
     idx = *diCount;
     *diCount += 1;
-    di_data->diskInfo = (di_disk_info_t *) di_realloc (
-        (char *) di_data->diskInfo,
-        sizeof (di_disk_info_t) * (*diCount + 1));
-    if (di_data->diskInfo == (di_disk_info_t *) NULL) {
-      fprintf (stderr, "malloc failed for diskInfo. errno %d\n", errno);
+    if (di_disk_info_reserve (di_data, *diCount) < 0) {
       return -1;
     }
     diptr = di_data->diskInfo + idx;
@@ -1621,3 +2356,86 @@ di_get_disk_entries (di_data_t *di_data, int *diCount)
 }
 
 #endif
+
+/*
+ * di_get_mount_entry
+ *
+ * Used by di_get_path_info ().  Fills in the entry for the single
+ * mount with the given unique mount id, without listing the other
+ * mounts.  Returns -1 if statmount () is not available, or the
+ * mount is gone.
+ *
+ */
+
+int
+di_get_mount_entry (di_data_t *di_data, di_disk_info_t *diptr, di_mntid_t id)
+{
+#if defined (DI_USE_STATMOUNT)
+  di_statmount_t  *sm;
+  Size_t          smsz;
+  int             rc;
+
+  smsz = DI_STATMOUNT_BUFSZ;
+  sm = (di_statmount_t *) malloc (smsz);
+  if (sm == NULL) {
+    fprintf (stderr, "malloc failed in di_get_mount_entry.  errno %d\n", errno);
+    return -1;
+  }
+  rc = statmountEntry (di_data, diptr, (uint64_t) id, &sm, &smsz);
+  free (sm);
+  return rc;
+#else
+  (void) di_data;
+  (void) diptr;
+  (void) id;
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+/*
+ * di_mount_table_changed
+ *
+ * Used by the interval sampling to decide whether the held mount
+ * point descriptors are still valid.  The first call starts watching
+ * the mount table and returns true.  Linux raises POLLPRI on
+ * /proc/self/mountinfo whenever a mount or unmount happens in the
+ * mount namespace.  Where no notification is available, the mount
+ * table is always considered to have changed.
+ *
+ */
+
+int
+di_mount_table_changed (di_data_t *di_data)
+{
+#if defined (DI_MOUNTINFO_FILE) && _hdr_poll
+  struct pollfd   pfd;
+
+  if (di_data->mntWatchFd < 0) {
+    di_data->mntWatchFd = open (DI_MOUNTINFO_FILE, O_RDONLY | O_CLOEXEC);
+    return true;
+  }
+
+  pfd.fd = di_data->mntWatchFd;
+  pfd.events = POLLPRI;
+  pfd.revents = 0;
+  if (poll (&pfd, 1, 0) != 0) {
+    /* changed, or the poll () failed */
+    return true;
+  }
+  return false;
+#else
+  return true;
+#endif
+}
+
+void
+di_mount_table_release (di_data_t *di_data)
+{
+#if defined (DI_MOUNTINFO_FILE) && _hdr_poll
+  if (di_data->mntWatchFd >= 0) {
+    close (di_data->mntWatchFd);
+  }
+#endif
+  di_data->mntWatchFd = -1;
+}
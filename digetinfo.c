@@ -12,9 +12,16 @@
  *    di_get_disk_info ()
  *        Gets the disk space used/available on the
  *        partitions we want displayed.
+ *    di_get_disk_info_path ()
+ *        Gets the disk space used/available for a single path.
  *
  */
 
+/* linux: O_PATH */
+#if (defined (linux) || defined (__linux__)) && ! defined (_GNU_SOURCE)
+# define _GNU_SOURCE 1
+#endif
+
 #include "config.h"
 
 #if _hdr_stdio
@@ -23,6 +30,9 @@
 #if _hdr_stdlib
 # include <stdlib.h>
 #endif
+#if _hdr_stdbool
+# include <stdbool.h>
+#endif
 #if _sys_types \
     && ! defined (DI_INC_SYS_TYPES_H) /* xenix */
 # define DI_INC_SYS_TYPES_H
@@ -40,6 +50,15 @@
 #if _hdr_strings
 # include <strings.h>
 #endif
+#if _hdr_fcntl
+# include <fcntl.h>             /* open (); O_PATH */
+#endif
+#if _hdr_unistd
+# include <unistd.h>            /* close () */
+#endif
+#if _sys_stat
+# include <sys/stat.h>          /* fstat () */
+#endif
 
 /* FreeBSD, OpenBSD, old NetBSD, HP-UX, MacOS */
 #if _sys_mount && ! defined (DI_INC_SYS_MOUNT)
@@ -107,89 +126,527 @@ extern "C" {
  */
 
 # define DI_GETDISKINFO_DEF 1
+# define DI_HELDINFO_DEF 1
+# define DI_PATHINFO_DEF 1
+
+/* The mount point is opened once with O_PATH, and the same  */
+/* descriptor is used for the fstatvfs () and the fstat ().  */
+/* There is only one path lookup per mount, and the mount    */
+/* cannot be swapped between the two calls.                  */
+# if _const_O_PATH && _lib_fstatvfs && _hdr_fcntl && _hdr_unistd && \
+    _sys_stat && defined (O_NOFOLLOW)
+#  define DI_FUSED_PROBE 1
+# endif
+
+typedef struct {
+  Statvfs_t       statBuf;
+  unsigned long   st_dev;
+  int             hasdev;
+  /* the descriptor opened by the probe, or -1 */
+  int             fd;
+  /* the held descriptor to re-read (input) */
+  int             heldfd;
+  int             rc;
+  int             err;
+} di_statvfs_probe_t;
+
+static void statvfsPath (const char *, di_statvfs_probe_t *, int);
+static void statvfsProbeFree (void *);
+static int  statvfsGroups (di_data_t *, int, const char * []);
+static int  statvfsShareable (const di_disk_info_t *);
+static void statvfsSave (di_data_t *, di_disk_info_t *, Statvfs_t *);
+
+static void
+statvfsProbe (const char *path, void *result)
+{
+  statvfsPath (path, (di_statvfs_probe_t *) result, false);
+}
+
+/* interval sampling: the descriptor is handed back to be held open */
+static void
+statvfsHeldProbe (const char *path, void *result)
+{
+  statvfsPath (path, (di_statvfs_probe_t *) result, true);
+}
+
+# if defined (DI_FUSED_PROBE)
+/* interval sampling: re-reads a held descriptor, there is no path lookup */
+static void
+statvfsFdProbe (const char *path, void *result)
+{
+  di_statvfs_probe_t  *probe;
+
+  (void) path;
+  probe = (di_statvfs_probe_t *) result;
+  probe->hasdev = false;
+  probe->fd = -1;
+  probe->err = 0;
+  probe->rc = fstatvfs (probe->heldfd, &probe->statBuf);
+  if (probe->rc != 0) {
+    probe->err = errno;
+  }
+}
+# endif
+
+/* a probe that finished after it was abandoned: the descriptor */
+/* it opened is not held by anyone                               */
+static void
+statvfsProbeFree (void *result)
+{
+  di_statvfs_probe_t  *probe;
+
+  probe = (di_statvfs_probe_t *) result;
+# if defined (DI_FUSED_PROBE)
+  if (probe->fd >= 0) {
+    close (probe->fd);
+  }
+# endif
+  probe->fd = -1;
+}
+
+static void
+statvfsPath (const char *path, di_statvfs_probe_t *probe, int hold)
+{
+  probe->hasdev = false;
+  probe->fd = -1;
+  probe->err = 0;
+
+# if defined (DI_FUSED_PROBE)
+  {
+    int           fd;
+    struct stat   statBuf;
+
+    fd = open (path, O_PATH | O_NOFOLLOW | O_CLOEXEC);
+    if (fd >= 0) {
+      probe->rc = fstatvfs (fd, &probe->statBuf);
+      if (probe->rc != 0) {
+        probe->err = errno;
+      }
+      if (probe->rc == 0 && fstat (fd, &statBuf) == 0) {
+        probe->st_dev = (unsigned long) statBuf.st_dev;
+        probe->hasdev = true;
+      }
+      if (hold && probe->rc == 0) {
+        probe->fd = fd;
+      } else {
+        close (fd);
+      }
+      /* older kernels do not support fstatvfs () on an O_PATH fd */
+      if (probe->rc == 0 || probe->err != EBADF) {
+        return;
+      }
+    }
+  }
+# else
+  (void) hold;
+# endif
+
+  probe->rc = statvfs (path, &probe->statBuf);
+  probe->err = 0;
+  if (probe->rc != 0) {
+    probe->err = errno;
+  }
+}
 
 void
 di_get_disk_info (di_data_t *di_data, int *diCount)
 {
-  di_disk_info_t  *diptr;
-  int             i;
-  Statvfs_t       statBuf;
-  di_opt_t        *diopts;
+  di_disk_info_t      *diptr;
+  int                 i;
+  di_statvfs_probe_t  *probes;
+  const char          **paths;
+  int                 *status;
+  Statvfs_t           *statBuf;
+  di_opt_t            *diopts;
+  di_probe_func_t     probefunc;
+  int                 shared;
+  int                 j;
 
   diopts = (di_opt_t *) di_data->options;
 
   if (diopts->optval [DI_OPT_DEBUG] > 0) { printf ("# di_get_disk_info: statvfs\n"); }
+  if (*diCount <= 0) {
+    return;
+  }
+
+  probes = (di_statvfs_probe_t *) malloc (sizeof (di_statvfs_probe_t) *
+      (Size_t) *diCount);
+  paths = (const char **) malloc (sizeof (const char *) * (Size_t) *diCount);
+  status = (int *) malloc (sizeof (int) * (Size_t) *diCount);
+  if (probes == NULL || paths == NULL || status == NULL) {
+    fprintf (stderr, "malloc failed in di_get_disk_info.  errno %d\n", errno);
+    free (probes);
+    free (paths);
+    free (status);
+    return;
+  }
+
   for (i = 0; i < *diCount; ++i) {
     diptr = di_data->diskInfo + i;
-
+    paths [i] = NULL;
+    probes [i].rc = -1;
+    probes [i].err = 0;
+    probes [i].fd = -1;
+    probes [i].heldfd = -1;
     if (diptr->printFlag == DI_PRNT_OK ||
         diptr->printFlag == DI_PRNT_SKIP ||
         diptr->printFlag == DI_PRNT_FORCE) {
-      di_ui_t    tblocksz;
+      paths [i] = diptr->strdata [DI_DISP_MOUNTPT];
+    }
+  }
 
-      if (statvfs (diptr->strdata [DI_DISP_MOUNTPT], &statBuf) == 0) {
-        /* data general DG/UX 5.4R3.00 sometime returns 0   */
-        /* in the fragment size field.                      */
-        if (statBuf.f_frsize == 0 && statBuf.f_bsize != 0) {
-          tblocksz = statBuf.f_bsize;
-        } else {
-          tblocksz = statBuf.f_frsize;
+  shared = statvfsGroups (di_data, *diCount, paths);
+  if (diopts->optval [DI_OPT_DEBUG] > 0) {
+    printf ("# di_get_disk_info: %d shared\n", shared);
+  }
+
+  /* The statvfs () calls may be run in parallel, and may time out.   */
+  /* A descriptor opened by a probe that was abandoned is closed by    */
+  /* the probe pool.                                                   */
+  probefunc = statvfsProbe;
+  if (di_data->holdFds) {
+    probefunc = statvfsHeldProbe;
+  }
+  di_probe_run (di_data, *diCount, paths, probefunc, statvfsProbeFree,
+      probes, sizeof (di_statvfs_probe_t), status);
+
+  for (i = 0; i < *diCount; ++i) {
+    diptr = di_data->diskInfo + i;
+
+    if (diptr->printFlag == DI_PRNT_OK ||
+        diptr->printFlag == DI_PRNT_SKIP ||
+        diptr->printFlag == DI_PRNT_FORCE) {
+      /* a shared entry uses the result of its group's probe */
+      j = i;
+      if (diptr->statRep >= 0) {
+        j = diptr->statRep;
+      }
+      statBuf = &probes [j].statBuf;
+      if (status [j] == DI_PROBE_TIMEOUT) {
+        diptr->printFlag = DI_PRNT_TIMEOUT;
+        fprintf (stderr, "statvfs: %s timed out\n", diptr->strdata [DI_DISP_MOUNTPT]);
+      } else if (status [j] == DI_PROBE_STALE) {
+        /* the deadline passed before this mount could be sampled */
+        if (diptr->printFlag != DI_PRNT_SKIP) {
+          diptr->printFlag = DI_PRNT_STALE;
         }
+      } else if (status [j] == DI_PROBE_DONE && probes [j].rc == 0) {
+        if (probes [j].hasdev) {
+          diptr->st_dev = probes [j].st_dev;
+          diptr->hasStDev = true;
+        }
+        if (j == i) {
+          diptr->mntFd = probes [i].fd;
+        }
+        statvfsSave (di_data, diptr, statBuf);
+      }
+      else
+      {
+        diptr->printFlag = DI_PRNT_BAD;
+        if (probes [j].err != 0 &&
+            probes [j].err != ENOENT &&
+            probes [j].err != EACCES &&
+            probes [j].err != EPERM) {
+          fprintf (stderr, "statvfs: %s %s\n", diptr->strdata [DI_DISP_MOUNTPT],
+              strerror (probes [j].err));
+        }
+      }
+    }
+  } /* for each entry */
+
+  free (probes);
+  free (paths);
+  free (status);
+}
+
+/*
+ * di_get_held_disk_info
+ *
+ * Interval sampling.  Re-reads the disk space of the displayed
+ * partitions using the mount point descriptors held open by the
+ * previous full sample.  There is no path lookup.
+ * The descriptors are read through di_probe_run (), with the same
+ * probe timeout and deadline as a full sample.
+ * Returns -1 if a full sample is needed.
+ *
+ */
+
+int
+di_get_held_disk_info (di_data_t *di_data)
+{
+# if defined (DI_FUSED_PROBE)
+  di_disk_info_t      *diptr;
+  int                 i;
+  int                 j;
+  int                 rc;
+  di_statvfs_probe_t  *probes;
+  const char          **paths;
+  int                 *status;
+  di_opt_t            *diopts;
+
+  diopts = (di_opt_t *) di_data->options;
+
+  if (diopts->optval [DI_OPT_DEBUG] > 0) { printf ("# di_get_held_disk_info: fstatvfs\n"); }
+  if (di_data->fscount <= 0) {
+    return 0;
+  }
+
+  for (i = 0; i < di_data->fscount; ++i) {
+    diptr = di_data->diskInfo + i;
+
+    /* a partition that timed out or was not sampled in time */
+    /* is tried again                                         */
+    if (diptr->printFlag == DI_PRNT_TIMEOUT ||
+        diptr->printFlag == DI_PRNT_STALE) {
+      return -1;
+    }
+    if (! diptr->doPrint || diptr->statRep >= 0) {
+      continue;
+    }
+    /* a displayed partition without a descriptor needs a full sample */
+    if (diptr->mntFd < 0 &&
+        (diptr->printFlag == DI_PRNT_OK || diptr->printFlag == DI_PRNT_FORCE)) {
+      return -1;
+    }
+  }
+
+  probes = (di_statvfs_probe_t *) malloc (sizeof (di_statvfs_probe_t) *
+      (Size_t) di_data->fscount);
+  paths = (const char **) malloc (sizeof (const char *) *
+      (Size_t) di_data->fscount);
+  status = (int *) malloc (sizeof (int) * (Size_t) di_data->fscount);
+  if (probes == NULL || paths == NULL || status == NULL) {
+    fprintf (stderr, "malloc failed in di_get_held_disk_info.  errno %d\n", errno);
+    free (probes);
+    free (paths);
+    free (status);
+    return -1;
+  }
+
+  for (i = 0; i < di_data->fscount; ++i) {
+    diptr = di_data->diskInfo + i;
+    paths [i] = NULL;
+    probes [i].rc = -1;
+    probes [i].err = 0;
+    probes [i].fd = -1;
+    probes [i].heldfd = diptr->mntFd;
+    if (diptr->mntFd >= 0) {
+      paths [i] = diptr->strdata [DI_DISP_MOUNTPT];
+    }
+  }
+
+  di_probe_run (di_data, di_data->fscount, paths, statvfsFdProbe, NULL,
+      probes, sizeof (di_statvfs_probe_t), status);
+
+  rc = 0;
+  for (i = 0; i < di_data->fscount; ++i) {
+    diptr = di_data->diskInfo + i;
+
+    /* a shared entry uses the result of its group's probe */
+    j = i;
+    if (diptr->statRep >= 0) {
+      j = diptr->statRep;
+      if (! diptr->doPrint) {
+        continue;
+      }
+    }
+    if (paths [j] == NULL) {
+      continue;
+    }
+
+    if (status [j] == DI_PROBE_TIMEOUT) {
+      diptr->printFlag = DI_PRNT_TIMEOUT;
+      diptr->doPrint = false;
+      fprintf (stderr, "statvfs: %s timed out\n", diptr->strdata [DI_DISP_MOUNTPT]);
+    } else if (status [j] == DI_PROBE_STALE) {
+      if (diptr->printFlag != DI_PRNT_SKIP) {
+        diptr->printFlag = DI_PRNT_STALE;
+      }
+    } else if (status [j] == DI_PROBE_DONE && probes [j].rc == 0) {
+      if (j == i) {
+        statvfsSave (di_data, diptr, &probes [i].statBuf);
+      } else {
+        /* the group's first entry has already been saved */
+        di_copy_disk_values (diptr, di_data->diskInfo + j);
+      }
+    } else {
+      rc = -1;
+    }
+  }
+
+  free (probes);
+  free (paths);
+  free (status);
+  return rc;
+# else
+  (void) di_data;
+  return -1;
+# endif
+}
+
+/*
+ * di_get_disk_info_path
+ *
+ * di_get_path_info ().  statvfs () is called on the path itself
+ * rather than on the mount point.  The mount point may be hidden
+ * by a later mount, or may not be accessible.
+ * Returns -1 on failure, with errno set.
+ *
+ */
+
+int
+di_get_disk_info_path (di_data_t *di_data, di_disk_info_t *diptr, const char *path)
+{
+  Statvfs_t           statBuf;
+  di_opt_t            *diopts;
+
+  diopts = (di_opt_t *) di_data->options;
+
+  if (diopts->optval [DI_OPT_DEBUG] > 0) { printf ("# di_get_disk_info_path: statvfs\n"); }
+  if (statvfs (path, &statBuf) != 0) {
+    return -1;
+  }
+  statvfsSave (di_data, diptr, &statBuf);
+  return 0;
+}
+
+/*
+ * statvfsGroups
+ *
+ * Bind mounts and other mounts of the same filesystem get the same
+ * answer from statvfs ().  The entries are grouped by the device
+ * number from the mount table.  Only the first entry of each group
+ * is probed, the others are pointed at it (statRep) and their path
+ * is cleared.  Returns the number of entries that share a probe.
+ *
+ */
+
+static int
+statvfsGroups (di_data_t *di_data, int count, const char *paths [])
+{
+  di_disk_info_t  *diptr;
+  int             *table;
+  Size_t          tsize;
+  Size_t          h;
+  int             i;
+  int             shared = 0;
+
+  tsize = 16;
+  while (tsize < (Size_t) count * 2) {
+    tsize *= 2;
+  }
+  table = (int *) malloc (sizeof (int) * tsize);
+  if (table == NULL) {
+    /* every entry is probed */
+    return 0;
+  }
+  for (h = 0; h < tsize; ++h) {
+    table [h] = -1;
+  }
+
+  for (i = 0; i < count; ++i) {
+    diptr = di_data->diskInfo + i;
+    if (paths [i] == NULL || ! statvfsShareable (diptr)) {
+      continue;
+    }
+
+    h = (Size_t) ((diptr->mntDev ^ (diptr->mntDev >> 20)) * 2654435761UL);
+    h &= tsize - 1;
+    while (table [h] >= 0 &&
+        di_data->diskInfo [table [h]].mntDev != diptr->mntDev) {
+      h = (h + 1) & (tsize - 1);
+    }
+    if (table [h] < 0) {
+      table [h] = i;
+      continue;
+    }
+    diptr->statRep = table [h];
+    paths [i] = NULL;
+    ++shared;
+  }
+
+  free (table);
+  return shared;
+}
+
+/*
+ * A btrfs subvolume does not have the filesystem's device number in
+ * the mount table.  With project quotas (xfs, ext4), statvfs ()
+ * reports the limits of the directory tree that was mounted.
+ */
+
+static int
+statvfsShareable (const di_disk_info_t *diptr)
+{
+  if (! diptr->hasMntDev) {
+    return false;
+  }
+  if ((diptr->fsClass & DI_FSCLASS_BTRFS) == DI_FSCLASS_BTRFS) {
+    return false;
+  }
+  if (diptr->hasPrjQuota) {
+    return false;
+  }
+  return true;
+}
+
+static void
+statvfsSave (di_data_t *di_data, di_disk_info_t *diptr, Statvfs_t *statBuf)
+{
+  di_ui_t    tblocksz;
+  di_opt_t   *diopts;
+
+  diopts = (di_opt_t *) di_data->options;
+
+  /* data general DG/UX 5.4R3.00 sometime returns 0   */
+  /* in the fragment size field.                      */
+  if (statBuf->f_frsize == 0 && statBuf->f_bsize != 0) {
+    tblocksz = statBuf->f_bsize;
+  } else {
+    tblocksz = statBuf->f_frsize;
+  }
 /* Linux! statvfs () returns values in f_bsize rather f_frsize.  Bleah.  */
 /* Non-POSIX!  Linux manual pages are incorrect.                        */
 #  if defined (linux)
-        tblocksz = statBuf.f_bsize;
+  tblocksz = statBuf->f_bsize;
 #  endif /* linux */
 
-        di_save_block_sizes (diptr, tblocksz,
-            (di_ui_t) statBuf.f_blocks,
-            (di_ui_t) statBuf.f_bfree, (di_ui_t) statBuf.f_bavail);
-        di_save_inode_sizes (diptr, (di_ui_t) statBuf.f_files,
-            (di_ui_t) statBuf.f_ffree, (di_ui_t) statBuf.f_favail);
+  di_save_block_sizes (diptr, tblocksz,
+      (di_ui_t) statBuf->f_blocks,
+      (di_ui_t) statBuf->f_bfree, (di_ui_t) statBuf->f_bavail);
+  di_save_inode_sizes (diptr, (di_ui_t) statBuf->f_files,
+      (di_ui_t) statBuf->f_ffree, (di_ui_t) statBuf->f_favail);
 # if _mem_struct_statvfs_f_basetype
-        if (! *diptr->strdata [DI_DISP_FSTYPE]) {
-          stpecpy (diptr->strdata [DI_DISP_FSTYPE],
-              diptr->strdata [DI_DISP_FSTYPE] + DI_FSTYPE_LEN,
-              statBuf.f_basetype);
-        }
+  if (! *diptr->strdata [DI_DISP_FSTYPE]) {
+    di_set_disk_string (di_data, diptr, DI_DISP_FSTYPE, statBuf->f_basetype);
+  }
 # endif
 
-        if (diopts->optval [DI_OPT_DEBUG] > 1)
-        {
-          printf ("%s: %s\n", diptr->strdata [DI_DISP_MOUNTPT], diptr->strdata [DI_DISP_FSTYPE]);
-          printf ("\tbsize:%ld  frsize:%ld\n", (long) statBuf.f_bsize,
-                  (long) statBuf.f_frsize);
+  if (diopts->optval [DI_OPT_DEBUG] > 1)
+  {
+    printf ("%s: %s\n", diptr->strdata [DI_DISP_MOUNTPT], diptr->strdata [DI_DISP_FSTYPE]);
+    printf ("\tbsize:%ld  frsize:%ld\n", (long) statBuf->f_bsize,
+            (long) statBuf->f_frsize);
 # if _siz_long_long >= 8
-          printf ("\tblocks: tot:%llu free:%lld avail:%llu\n",
-              (unsigned long long) statBuf.f_blocks,
-              (long long) statBuf.f_bfree,
-              (unsigned long long) statBuf.f_bavail);
-          printf ("\tinodes: tot:%llu free:%llu avail:%llu\n",
-              (unsigned long long) statBuf.f_files,
-              (unsigned long long) statBuf.f_ffree,
-              (unsigned long long) statBuf.f_favail);
+    printf ("\tblocks: tot:%llu free:%lld avail:%llu\n",
+        (unsigned long long) statBuf->f_blocks,
+        (long long) statBuf->f_bfree,
+        (unsigned long long) statBuf->f_bavail);
+    printf ("\tinodes: tot:%llu free:%llu avail:%llu\n",
+        (unsigned long long) statBuf->f_files,
+        (unsigned long long) statBuf->f_ffree,
+        (unsigned long long) statBuf->f_favail);
 # else
-          printf ("\tblocks: tot:%lu free:%lu avail:%lu\n",
-              (unsigned long) statBuf.f_blocks,
-              (unsigned long) statBuf.f_bfree,
-              (unsigned long) statBuf.f_bavail);
-          printf ("\tinodes: tot:%lu free:%lu avail:%lu\n",
-              (unsigned long) statBuf.f_files,
-              (unsigned long) statBuf.f_ffree,
-              (unsigned long) statBuf.f_favail);
+    printf ("\tblocks: tot:%lu free:%lu avail:%lu\n",
+        (unsigned long) statBuf->f_blocks,
+        (unsigned long) statBuf->f_bfree,
+        (unsigned long) statBuf->f_bavail);
+    printf ("\tinodes: tot:%lu free:%lu avail:%lu\n",
+        (unsigned long) statBuf->f_files,
+        (unsigned long) statBuf->f_ffree,
+        (unsigned long) statBuf->f_favail);
 # endif
-        }
-      }
-      else
-      {
-        diptr->printFlag = DI_PRNT_BAD;
-        if (errno != ENOENT && errno != EACCES && errno != EPERM) {
-          fprintf (stderr, "statvfs: %s ", diptr->strdata [DI_DISP_MOUNTPT]);
-          perror ("");
-        }
-      }
-    }
-  } /* for each entry */
+  }
 }
 
 #endif /* _lib_statvfs */
@@ -231,6 +688,9 @@ di_get_disk_info (di_data_t *di_data, int *diCount)
   di_disk_info_t  *diptr;
   int             i;
   struct statfs   statBuf;
+# if _lib_sysfs && _mem_struct_statfs_f_fstyp
+  char            fstype [DI_FSTYPE_LEN];
+# endif
   di_opt_t        *diopts;
 
   diopts = (di_opt_t *) di_data->options;
@@ -258,7 +718,8 @@ di_get_disk_info (di_data_t *di_data, int *diCount)
         di_save_inode_sizes (diptr, statBuf.f_files,
             statBuf.f_ffree, statBuf.f_ffree);
 # if _lib_sysfs && _mem_struct_statfs_f_fstyp
-        sysfs (GETFSTYP, statBuf.f_fstyp, diptr->strdata [DI_DISP_FSTYPE]);
+        sysfs (GETFSTYP, statBuf.f_fstyp, fstype);
+        di_set_disk_string (di_data, diptr, DI_DISP_FSTYPE, fstype);
 # endif
 
         if (diopts->optval [DI_OPT_DEBUG] > 1) {
@@ -305,53 +766,127 @@ di_get_disk_info (di_data_t *di_data, int *diCount)
 
 # define DI_GETDISKINFO_DEF 1
 
+typedef struct {
+  struct statfs   statBuf;
+  int             rc;
+  int             err;
+} di_statfs_probe_t;
+
+static void
+statfsProbe (const char *path, void *result)
+{
+  di_statfs_probe_t  *probe;
+
+  probe = (di_statfs_probe_t *) result;
+  probe->rc = statfs (path, &probe->statBuf);
+  probe->err = 0;
+  if (probe->rc != 0) {
+    probe->err = errno;
+  }
+}
+
 void
 di_get_disk_info (di_data_t *di_data, int *diCount)
 {
   di_disk_info_t     *diptr;
   int             i;
-  struct statfs   statBuf;
+  di_statfs_probe_t *probes;
+  const char      **paths;
+  int             *status;
+  struct statfs   *statBuf;
+# if _lib_sysfs && _mem_struct_statfs_f_fstyp
+  char            fstype [DI_FSTYPE_LEN];
+# endif
   di_opt_t        *diopts;
 
   diopts = (di_opt_t *) di_data->options;
 
   if (diopts->optval [DI_OPT_DEBUG] > 0) { printf ("# di_get_disk_info: bsd-statfs 2/3arg\n"); }
+  if (*diCount <= 0) {
+    return;
+  }
+
+  probes = (di_statfs_probe_t *) malloc (sizeof (di_statfs_probe_t) *
+      (Size_t) *diCount);
+  paths = (const char **) malloc (sizeof (const char *) * (Size_t) *diCount);
+  status = (int *) malloc (sizeof (int) * (Size_t) *diCount);
+  if (probes == NULL || paths == NULL || status == NULL) {
+    fprintf (stderr, "malloc failed in di_get_disk_info.  errno %d\n", errno);
+    free (probes);
+    free (paths);
+    free (status);
+    return;
+  }
+
   for (i = 0; i < *diCount; ++i) {
     diptr = di_data->diskInfo + i;
+    paths [i] = NULL;
+    probes [i].rc = -1;
+    probes [i].err = 0;
     if (diptr->printFlag == DI_PRNT_OK ||
         diptr->printFlag == DI_PRNT_SKIP ||
         diptr->printFlag == DI_PRNT_FORCE) {
-      if (statfs (diptr->strdata [DI_DISP_MOUNTPT], &statBuf) == 0) {
-        di_save_block_sizes (diptr, statBuf.f_bsize, statBuf.f_blocks,
-            statBuf.f_bfree, statBuf.f_bavail);
-        di_save_inode_sizes (diptr, statBuf.f_files,
-            statBuf.f_ffree, statBuf.f_ffree);
+      paths [i] = diptr->strdata [DI_DISP_MOUNTPT];
+    }
+  }
+
+  /* the statfs () calls may be run in parallel, and may time out */
+  di_probe_run (di_data, *diCount, paths, statfsProbe, NULL,
+      probes, sizeof (di_statfs_probe_t), status);
+
+  for (i = 0; i < *diCount; ++i) {
+    diptr = di_data->diskInfo + i;
+    if (diptr->printFlag == DI_PRNT_OK ||
+        diptr->printFlag == DI_PRNT_SKIP ||
+        diptr->printFlag == DI_PRNT_FORCE) {
+      statBuf = &probes [i].statBuf;
+      if (status [i] == DI_PROBE_TIMEOUT) {
+        diptr->printFlag = DI_PRNT_TIMEOUT;
+        fprintf (stderr, "statfs: %s timed out\n", diptr->strdata [DI_DISP_MOUNTPT]);
+      } else if (status [i] == DI_PROBE_STALE) {
+        /* the deadline passed before this mount could be sampled */
+        if (diptr->printFlag != DI_PRNT_SKIP) {
+          diptr->printFlag = DI_PRNT_STALE;
+        }
+      } else if (status [i] == DI_PROBE_DONE && probes [i].rc == 0) {
+        di_save_block_sizes (diptr, statBuf->f_bsize, statBuf->f_blocks,
+            statBuf->f_bfree, statBuf->f_bavail);
+        di_save_inode_sizes (diptr, statBuf->f_files,
+            statBuf->f_ffree, statBuf->f_ffree);
 
 # if _lib_sysfs && _mem_struct_statfs_f_fstyp
-        sysfs (GETFSTYP, statBuf.f_fstyp, diptr->strdata [DI_DISP_FSTYPE]);
+        sysfs (GETFSTYP, statBuf->f_fstyp, fstype);
+        di_set_disk_string (di_data, diptr, DI_DISP_FSTYPE, fstype);
 # endif
 
         if (diopts->optval [DI_OPT_DEBUG] > 1)
         {
           printf ("%s: %s\n", diptr->strdata [DI_DISP_MOUNTPT], diptr->strdata [DI_DISP_FSTYPE]);
-          printf ("\tbsize:%ld\n", (long) statBuf.f_bsize);
+          printf ("\tbsize:%ld\n", (long) statBuf->f_bsize);
           printf ("\tblocks: tot:%ld free:%ld avail:%ld\n",
-              (long) statBuf.f_blocks, (long) statBuf.f_bfree,
-              (long) statBuf.f_bavail);
+              (long) statBuf->f_blocks, (long) statBuf->f_bfree,
+              (long) statBuf->f_bavail);
           printf ("\tinodes: tot:%ld free:%ld\n",
-              (long) statBuf.f_files, (long) statBuf.f_ffree);
+              (long) statBuf->f_files, (long) statBuf->f_ffree);
         }
       } /* if we got the info */
       else
       {
         diptr->printFlag = DI_PRNT_BAD;
-        if (errno != ENOENT && errno != EACCES && errno != EPERM) {
-          fprintf (stderr, "statfs: %s ", diptr->strdata [DI_DISP_MOUNTPT]);
-          perror ("");
+        if (probes [i].err != 0 &&
+            probes [i].err != ENOENT &&
+            probes [i].err != EACCES &&
+            probes [i].err != EPERM) {
+          fprintf (stderr, "statfs: %s %s\n", diptr->strdata [DI_DISP_MOUNTPT],
+              strerror (probes [i].err));
         }
       }
     }
   } /* for each entry */
+
+  free (probes);
+  free (paths);
+  free (status);
 }
 
 #endif /* _args_statfs == 2 or 3 */
@@ -403,12 +938,8 @@ di_get_disk_info (di_data_t *di_data, int *diCount)
       rc = GetVolumeInformation (diptr->strdata [DI_DISP_MOUNTPT],
           volName, MSDOS_BUFFER_SIZE, &serialNo, &maxCompLen,
           &fsFlags, fsName, MSDOS_BUFFER_SIZE);
-      stpecpy (diptr->strdata [DI_DISP_FSTYPE],
-          diptr->strdata [DI_DISP_FSTYPE] + DI_FSTYPE_LEN,
-          fsName);
-      stpecpy (diptr->strdata [DI_DISP_FILESYSTEM],
-          diptr->strdata [DI_DISP_FILESYSTEM] + DI_FILESYSTEM_LEN,
-          volName);
+      di_set_disk_string (di_data, diptr, DI_DISP_FSTYPE, fsName);
+      di_set_disk_string (di_data, diptr, DI_DISP_FILESYSTEM, volName);
 
 # if _lib_GetDiskFreeSpaceEx
       {
@@ -496,3 +1027,25 @@ di_get_disk_info (di_data_t *di_data, int *diCount)
   return;
 }
 #endif
+
+#if ! defined (DI_PATHINFO_DEF)
+/* the disk space is fetched along with the mount table */
+int
+di_get_disk_info_path (di_data_t *di_data, di_disk_info_t *diptr, const char *path)
+{
+  (void) di_data;
+  (void) diptr;
+  (void) path;
+  return 1;
+}
+#endif
+
+#if ! defined (DI_HELDINFO_DEF)
+/* there are no held descriptors, every sample is a full sample */
+int
+di_get_held_disk_info (di_data_t *di_data)
+{
+  (void) di_data;
+  return -1;
+}
+#endif
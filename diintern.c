@@ -0,0 +1,212 @@
+/* Copyright 2026 Brad Lanam Pleasant Hill CA */
+
+/*
+ *
+ *    String interning.
+ *
+ *    The file system type, mount options and special device names
+ *    repeat across the mount entries.  Each distinct string is
+ *    stored once in the arena and is given a small integer id.
+ *    Two entries have the same string if and only if they have
+ *    the same id.
+ *
+ *    di_intern_init ()
+ *        initialize an empty intern table.
+ *    di_intern ()
+ *        return the id for a string, adding it if necessary.
+ *    di_intern_lookup ()
+ *        return the id for a string, or -1 if it is not present.
+ *    di_intern_free ()
+ *        release the intern table.  The strings are in the arena.
+ *
+ */
+
+#include "config.h"
+
+#if _hdr_stdio
+# include <stdio.h>
+#endif
+#if _hdr_stdlib
+# include <stdlib.h>
+#endif
+#if _hdr_string
+# include <string.h>
+#endif
+#if _hdr_strings
+# include <strings.h>
+#endif
+#if _hdr_memory
+# include <memory.h>
+#endif
+#if _hdr_malloc
+# include <malloc.h>
+#endif
+#if _hdr_errno
+# include <errno.h>
+#endif
+
+#include "di.h"
+#include "disystem.h"
+#include "diinternal.h"
+#include "distrutils.h"
+
+#define DI_INTERN_MIN_ALLOC   32
+
+static unsigned long internHash (const char *str);
+static int  *internFind (di_intern_t *intern, const char *str, unsigned long hash);
+static int  internGrow (di_intern_t *intern);
+
+void
+di_intern_init (di_intern_t *intern)
+{
+  intern->strs = NULL;
+  intern->fsclass = NULL;
+  intern->slots = NULL;
+  intern->tsize = 0;
+  intern->count = 0;
+  intern->alloc = 0;
+}
+
+int
+di_intern (di_data_t *di_data, const char *str)
+{
+  di_intern_t   *intern;
+  int           *slot;
+  unsigned long hash;
+  char          *p;
+
+  intern = &di_data->intern;
+  hash = internHash (str);
+  if (intern->tsize > 0) {
+    slot = internFind (intern, str, hash);
+    if (*slot >= 0) {
+      return *slot;
+    }
+  }
+
+  /* keep the load factor at or below one half */
+  if (intern->count >= intern->alloc ||
+      (Size_t) (intern->count + 1) * 2 > intern->tsize) {
+    if (internGrow (intern) < 0) {
+      return -1;
+    }
+  }
+
+  p = di_arena_strdup (&di_data->arena, str);
+  if (p == NULL) {
+    return -1;
+  }
+
+  slot = internFind (intern, str, hash);
+  intern->strs [intern->count] = p;
+  intern->fsclass [intern->count] = 0;
+  *slot = intern->count;
+  ++intern->count;
+  return *slot;
+}
+
+int
+di_intern_lookup (di_intern_t *intern, const char *str)
+{
+  if (intern->tsize == 0) {
+    return -1;
+  }
+  return *internFind (intern, str, internHash (str));
+}
+
+void
+di_intern_free (di_intern_t *intern)
+{
+  if (intern->strs != NULL) {
+    free (intern->strs);
+  }
+  if (intern->fsclass != NULL) {
+    free (intern->fsclass);
+  }
+  if (intern->slots != NULL) {
+    free (intern->slots);
+  }
+  di_intern_init (intern);
+}
+
+/* FNV-1a */
+static unsigned long
+internHash (const char *str)
+{
+  unsigned long   hash;
+
+  hash = 2166136261UL;
+  while (*str) {
+    hash ^= (unsigned char) *str;
+    hash *= 16777619UL;
+    ++str;
+  }
+  return hash;
+}
+
+/* returns the slot holding the string, or the empty slot to use */
+static int *
+internFind (di_intern_t *intern, const char *str, unsigned long hash)
+{
+  Size_t    idx;
+  int       *slot;
+
+  idx = (Size_t) hash & (intern->tsize - 1);
+  for (;;) {
+    slot = &intern->slots [idx];
+    if (*slot < 0 || strcmp (intern->strs [*slot], str) == 0) {
+      return slot;
+    }
+    idx = (idx + 1) & (intern->tsize - 1);
+  }
+}
+
+static int
+internGrow (di_intern_t *intern)
+{
+  char      **tstrs;
+  int       *tclass;
+  int       *tslots;
+  int       alloc;
+  Size_t    tsize;
+  Size_t    i;
+  int       j;
+
+  alloc = intern->alloc * 2;
+  if (alloc < DI_INTERN_MIN_ALLOC) {
+    alloc = DI_INTERN_MIN_ALLOC;
+  }
+  tsize = (Size_t) alloc * 2;
+
+  tstrs = (char **) di_realloc (intern->strs, sizeof (char *) * (Size_t) alloc);
+  if (tstrs == NULL) {
+    fprintf (stderr, "malloc failed in di_intern.  errno %d\n", errno);
+    return -1;
+  }
+  intern->strs = tstrs;
+  tclass = (int *) di_realloc (intern->fsclass, sizeof (int) * (Size_t) alloc);
+  if (tclass == NULL) {
+    fprintf (stderr, "malloc failed in di_intern.  errno %d\n", errno);
+    return -1;
+  }
+  intern->fsclass = tclass;
+  tslots = (int *) malloc (sizeof (int) * tsize);
+  if (tslots == NULL) {
+    fprintf (stderr, "malloc failed in di_intern.  errno %d\n", errno);
+    return -1;
+  }
+  intern->alloc = alloc;
+
+  if (intern->slots != NULL) {
+    free (intern->slots);
+  }
+  intern->slots = tslots;
+  intern->tsize = tsize;
+  for (i = 0; i < tsize; ++i) {
+    intern->slots [i] = -1;
+  }
+  for (j = 0; j < intern->count; ++j) {
+    *internFind (intern, intern->strs [j], internHash (intern->strs [j])) = j;
+  }
+  return 0;
+}
@@ -26,22 +26,220 @@ extern "C" {
 # define DI_DEFAULT_FORMAT "smbuvpT"
 #endif
 
+/* initial size of the disk info entry array */
+#define DI_DISK_INFO_MIN_ALLOC 16
+
+/* upper limit on the number of probe threads */
+#define DI_PROBE_MAX_THREADS   256
+
+/* probe status */
+#define DI_PROBE_SKIP       0
+#define DI_PROBE_DONE       1
+#define DI_PROBE_TIMEOUT    2
+#define DI_PROBE_STALE      3
+
+/* file system type classes (di_disk_info_t.fsClass) */
+#define DI_FSCLASS_VALID      0x0001    /* the class has been set   */
+#define DI_FSCLASS_POOLED     0x0002    /* zfs, advfs, apfs         */
+#define DI_FSCLASS_NULL       0x0004    /* dragonflybsd null        */
+#define DI_FSCLASS_REMOTE     0x0008    /* nfs                      */
+#define DI_FSCLASS_IGNORE     0x0010    /* not displayed by default */
+#define DI_FSCLASS_LOFS       0x0020
+#define DI_FSCLASS_NULLFS     0x0040
+#define DI_FSCLASS_NONE       0x0080
+#define DI_FSCLASS_APFS       0x0100
+#define DI_FSCLASS_BTRFS      0x0200
+#define DI_FSCLASS_EXCLUDE    0x0400    /* in the exclude list      */
+#define DI_FSCLASS_INCLUDE    0x0800    /* in the include list      */
+
+/* the filter results (di_disk_info_t.pathFilter, di_filter_match ()) */
+#define DI_FILTER_EXCL_PATH   0x0001    /* in the --exclude-path list */
+#define DI_FILTER_INCL_PATH   0x0002    /* in the --include-path list */
+#define DI_FILTER_EXCLUDE     0x0004    /* excluded                 */
+#define DI_FILTER_INCLUDE     0x0008    /* included                 */
+#define DI_FILTER_INCLIST     0x0010    /* an include list is set   */
+
+/* bitset access */
+#define DI_BIT_TEST(bits,idx)   (((bits) [(idx) >> 3] >> ((idx) & 7)) & 1)
+#define DI_BIT_SET(bits,idx)    ((bits) [(idx) >> 3] |= (unsigned char) (1 << ((idx) & 7)))
+#define DI_BIT_CLEAR(bits,idx)  ((bits) [(idx) >> 3] &= (unsigned char) ~(1 << ((idx) & 7)))
+
 #define DI_SORT_MAIN    0
 #define DI_SORT_TOTAL     1
 #define DI_SORT_MAX     2
 
 /* structures */
 
+/* milliseconds */
+#if _siz_long_long >= 8
+typedef long long di_ms_t;
+#else
+typedef long di_ms_t;
+#endif
+
+/* 64-bit mount ids (linux statmount ()) */
+#if _siz_long_long >= 8
+typedef unsigned long long di_mntid_t;
+#else
+typedef unsigned long di_mntid_t;
+#endif
+
+/* arena allocator: the chunk data follows the header */
+typedef struct di_arena_chunk
+{
+  struct di_arena_chunk *next;
+  Size_t        size;
+  Size_t        used;
+} di_arena_chunk_t;
+
+typedef struct
+{
+  di_arena_chunk_t  *head;
+  Size_t            nextsz;
+} di_arena_t;
+
+/* interned strings, by id */
+typedef struct
+{
+  char          **strs;
+  int           *fsclass;                   /* cached fstype class      */
+  int           *slots;                     /* hash table of ids        */
+  Size_t        tsize;
+  int           count;
+  int           alloc;
+} di_intern_t;
+
+/* column snapshot of the disk info values, by entry index */
+typedef struct
+{
+  di_ui_t       *values [DI_VALUE_MAX];
+  unsigned char *printable;                 /* bitset of doPrint        */
+  unsigned char *exact;                     /* bitset: the values all   */
+                                            /*   fit in a di_ui_t       */
+  int           *fsclass;
+  int           count;                      /* includes the totals      */
+  int           alloc;
+  int           valid;
+} di_columns_t;
+
+/* mount id to entry index, see dipath.c */
+typedef struct
+{
+  di_mntid_t    id;
+  int           idx;                        /* -1 if the slot is empty  */
+} di_mntid_slot_t;
+
+typedef struct
+{
+  di_mntid_slot_t *slots;                   /* the mount ids, followed  */
+                                            /*   by the unique ids      */
+  Size_t        tsize;                      /* size of each table       */
+  int           count;                      /* fscount when built       */
+  int           valid;
+} di_mntid_index_t;
+
+/* the type of mount id returned by di_path_stat () */
+#define DI_MNTID_NONE         0
+#define DI_MNTID_OLD          1
+#define DI_MNTID_UNIQUE       2
+
+/* path prefix trie, see ditrie.c */
+typedef struct
+{
+  int           value;                      /* the path and below       */
+  int           below;                      /* only below the path      */
+} di_trie_node_t;
+
+typedef struct
+{
+  int           parent;                     /* -1 if the slot is empty  */
+  int           child;
+  unsigned long hash;
+  const char    *name;                      /* the component, within    */
+  Size_t        len;                        /*   the key                */
+} di_trie_edge_t;
+
+typedef struct
+{
+  di_trie_node_t  *nodes;                   /* node 0 is the root       */
+  di_trie_edge_t  *edges;                   /* hash table               */
+  int           *stack;                     /* the lookup's nodes,      */
+                                            /*   by depth               */
+  Size_t        tsize;
+  int           nodecount;
+  int           alloc;
+  int           maxdepth;
+  int           count;                      /* fscount when built       */
+  int           valid;
+} di_trie_t;
+
+/* di_path_stat () flags */
+#define DI_PATH_NO_AUTOMOUNT  0x0001
+
+typedef struct
+{
+  unsigned long st_dev;
+  di_mntid_t    mntId;
+  int           mntIdType;
+} di_path_stat_t;
+
+/* the number of paths submitted at once by di_path_stat_batch () */
+#define DI_PATH_BATCH         128
+
+/* di_data_t.pathmode */
+#define DI_PATHMODE_NONE      0     /* di_get_all_disk_info () */
+#define DI_PATHMODE_SINGLE    1     /* the one mount from statmount () */
+#define DI_PATHMODE_TABLE     2     /* the full mount table */
+
+/* what di_get_all_disk_info () collects, see planCollection () */
+typedef struct
+{
+  int           values;                     /* statvfs () and quotas    */
+  int           options;                    /* store the mount options  */
+  int           preignore;                  /* the ignored types are    */
+                                            /*   not probed             */
+  int           sortvalues;                 /* the sort uses the values */
+  int           totsort;                    /* the totals order         */
+  int           filter;                     /* the mount table code     */
+                                            /*   drops the filtered     */
+                                            /*   mounts                 */
+} di_plan_t;
+
+/* batched path lookups, see dipath.c */
+typedef struct di_path_ring di_path_ring_t;
+
 typedef struct
 {
   char          *strdata [DI_DISP_MAX];     /* mount point           */
                                             /* special device name   */
                                             /* type of file system   */
                                             /* mount options         */
+  int           strId [DI_DISP_MAX];        /* interned string ids      */
+                                            /*   (-1 if not interned)   */
+  int           fsClass;                    /* file system type class   */
+  int           pathFilter;                 /* mount point path filter  */
+                                            /*   matches                */
   dinum_t       values [DI_VALUE_MAX];
   unsigned long st_dev;                     /* disk device number       */
   unsigned long sp_dev;                     /* special device number    */
   unsigned long sp_rdev;                    /* special rdev #           */
+  unsigned long mntId;                      /* mount id (linux)         */
+  di_mntid_t    mntUniqueId;                /* unique mount id (or 0)  */
+  unsigned long mntParentId;                /* parent mount id          */
+  int           hasMntId;                   /* are the mount ids valid? */
+  unsigned long mntDev;                     /* device number from the   */
+                                            /*   mount table            */
+  char          *mntRoot;                   /* root of the mount within */
+                                            /*   the filesystem         */
+  int           strStaged;                  /* bitmask of the strdata   */
+                                            /*   that are not yet in    */
+                                            /*   the arena              */
+  int           hasMntDev;                  /* is mntDev valid?         */
+  int           hasStDev;                   /* is st_dev valid?         */
+  int           mntFd;                      /* held O_PATH descriptor   */
+                                            /*   (or -1)                */
+  int           statRep;                    /* entry whose statvfs ()   */
+                                            /*   result is shared (-1)  */
   int           sortIndex [DI_SORT_MAX];
   int           doPrint;                    /* should this entry        */
                                             /*   be printed?            */
@@ -51,38 +249,132 @@ typedef struct
   int           isReadOnly;                 /* is this mount point      */
                                             /*   read-only?             */
   int           isLoopback;                 /* lofs or none fs type?    */
+  int           hasPrjQuota;                /* mounted with project     */
+                                            /*   quotas?                */
+  int           topHidden;                  /* not in the --top         */
+                                            /*   selection              */
+  int           whereHidden;                /* rejected by --where      */
 } di_disk_info_t;
 
 typedef struct {
   dinum_t         scale_values [DI_SCALE_MAX];
+  /* the scale values that fit in a di_ui_t, for the column fast path */
+  di_ui_t         scale_values_u [DI_SCALE_MAX];
+  int             scale_values_ulim;
   void            *options;
   di_disk_info_t  *diskInfo;
   di_disk_info_t  totals;
+  /* the strings for the disk info entries */
+  di_arena_t      arena;
+  di_intern_t     intern;
+  di_columns_t    columns;
+  di_mntid_index_t mntidx;
+  di_trie_t       mnttrie;
+  di_plan_t       plan;
   void            *zoneInfo;
   void            *pub;
   int             scale_values_init;
   /* fscount is the number of partitions */
   /* the allocation count is one greater to hold the totals bucket */
   int             fscount;
+  /* number of entries allocated in diskInfo */
+  int             fsalloc;
   int             dispcount;
+  /* number of entries hidden by --top */
+  int             tophidden;
+  /* number of entries rejected by --where, not counted in tophidden */
+  int             wherehidden;
   int             iteridx;
   int             iteropt;
   int             haspooledfs;
   int             disppooledfs;
   int             totsorted;
+  /* absolute time the data collection must be finished by, 0 if none */
+  di_ms_t         deadlineAt;
+  /* interval sampling: keep the mount point descriptors open */
+  int             holdFds;
+  /* descriptor used to watch for mount table changes, or -1 */
+  int             mntWatchFd;
+  /* di_get_path_info (): what the disk info entries hold */
+  int             pathmode;
+  /* the number of mounts dropped by di_drop_mount () */
+  int             fsdropped;
 } di_data_t;
 
+/* the probe function may be run in a separate thread */
+typedef void (*di_probe_func_t) (const char *path, void *result);
+/* releases anything held by a probe result that is not collected */
+typedef void (*di_probe_free_t) (void *result);
+
 /* digetentries.c */
 extern int  di_get_disk_entries (di_data_t *di_data, int *);
+extern int  di_get_mount_entry (di_data_t *di_data, di_disk_info_t *, di_mntid_t);
+extern int  di_mount_table_changed (di_data_t *di_data);
+extern void di_mount_table_release (di_data_t *di_data);
 
 /* digetinfo.c */
 extern void di_get_disk_info (di_data_t *di_data, int *);
+extern int  di_get_held_disk_info (di_data_t *di_data);
+extern int  di_get_disk_info_path (di_data_t *di_data, di_disk_info_t *, const char *);
+
+/* diprobe.c */
+extern void di_probe_run (di_data_t *di_data, int count, const char *paths [], di_probe_func_t probefunc, di_probe_free_t freefunc, void *results, Size_t ressz, int *status);
+extern di_ms_t di_probe_now (void);
+
+/* diarena.c */
+extern void di_arena_init (di_arena_t *);
+extern void *di_arena_alloc (di_arena_t *, Size_t);
+extern char *di_arena_strdup (di_arena_t *, const char *);
+extern void di_arena_free (di_arena_t *);
+
+/* diintern.c */
+extern void di_intern_init (di_intern_t *);
+extern int  di_intern (di_data_t *, const char *);
+extern int  di_intern_lookup (di_intern_t *, const char *);
+extern void di_intern_free (di_intern_t *);
+
+/* dicolumns.c */
+extern void di_columns_init (di_columns_t *);
+extern int  di_columns_build (di_data_t *);
+extern void di_columns_set_row (di_data_t *, int);
+extern int  di_columns_count (const di_columns_t *, int);
+extern void di_columns_free (di_columns_t *);
+
+/* dipath.c */
+extern int  di_path_stat (const char *, int, di_path_stat_t *);
+extern di_path_ring_t *di_path_ring_open (int);
+extern void di_path_stat_batch (di_path_ring_t *, int, const char **, int, di_path_stat_t *, int *);
+extern void di_path_ring_close (di_path_ring_t *);
+extern void di_mntid_index_init (di_mntid_index_t *);
+extern int  di_mntid_index_find (di_data_t *, di_mntid_t, int);
+extern void di_mntid_index_free (di_mntid_index_t *);
+
+/* ditrie.c */
+extern void di_trie_init (di_trie_t *);
+extern int  di_trie_insert (di_trie_t *, const char *, int);
+extern int  di_trie_find (di_trie_t *, const char *);
+extern void di_trie_free (di_trie_t *);
+extern int  di_mount_trie_find (di_data_t *, const char *);
+
+/* disort.c */
+extern void di_sort_disk_info (di_data_t *, const char *, int);
+extern void di_sort_top (di_data_t *, const char *, int, int);
+extern int  di_sort_uses_values (const char *);
 
 /* didiskutil.c */
+extern int  di_disk_info_reserve (di_data_t *, int);
 extern void di_initialize_disk_info (di_disk_info_t *, int);
+extern void di_initialize_disk_info_arena (di_disk_info_t *, int);
+extern void di_set_disk_string (di_data_t *, di_disk_info_t *, int, const char *);
+extern void di_compact_disk_info (di_data_t *);
+extern int  di_filter_paths (di_data_t *, const char *);
+extern int  di_filter_match (di_data_t *, int, int);
+extern int  di_drop_mount (di_data_t *, const char *, const char *);
 extern void di_free_disk_info (di_disk_info_t *);
+extern void di_release_disk_fd (di_disk_info_t *);
 extern void di_save_block_sizes (di_disk_info_t *, di_ui_t, di_ui_t, di_ui_t, di_ui_t);
 extern void di_save_inode_sizes (di_disk_info_t *, di_ui_t, di_ui_t, di_ui_t);
+extern void di_copy_disk_values (di_disk_info_t *, const di_disk_info_t *);
 #if _lib_getmntent \
     && ! _lib_getmntinfo \
     && ! _lib_getfsstat \
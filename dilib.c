@@ -84,36 +84,100 @@ extern "C" {
 
 #define DI_UNKNOWN_DEV          -1L
 
-#define DI_SORT_OPT_NONE            'n'
-#define DI_SORT_OPT_MOUNT           'm'
-#define DI_SORT_OPT_FILESYSTEM      's'
-#define DI_SORT_OPT_TOTAL           'T'
-#define DI_SORT_OPT_FREE            'f'
-#define DI_SORT_OPT_AVAIL           'a'
-#define DI_SORT_OPT_REVERSE         'r'
-#define DI_SORT_OPT_TYPE            't'
-#define DI_SORT_OPT_ASCENDING       1
-
+/* stat () probe results */
+typedef struct {
+  char          *resolved;
+  unsigned long st_dev;
+  unsigned long st_rdev;
+  int           rc;
+  int           err;
+} di_stat_probe_t;
+
+/* duplicate mount check hash table */
+typedef struct {
+  unsigned long dev;
+  const char    *root;
+  int           idx;
+  int           idxb;
+} di_dup_slot_t;
+
+/* file argument lookup, see checkFileInfo () */
+typedef struct {
+  di_dup_slot_t *table;
+  Size_t        tsize;
+  int           *ibuff;
+  int           *devNext;
+  int           *nameNext;
+  int           *pos;
+  int           *poolStart;
+  int           *matches;
+  int           *seen;
+  char          *inpool;
+  int           stamp;
+  int           skipFrom;
+  /* the paths waiting for di_path_stat_batch () */
+  di_path_ring_t  *ring;
+  const char    *paths [DI_PATH_BATCH];
+  di_path_stat_t pstat [DI_PATH_BATCH];
+  int           errs [DI_PATH_BATCH];
+  int           pathcount;
+} di_file_index_t;
+
+/* fewer paths than this are not worth setting up the batch interface */
+#define DI_PATH_RING_MIN    8
+/* the --files-from lines waiting in the batch */
+#define DI_PATH_BUFF_SZ     (32 * (DI_MAXPATH + 2))
+
+static void resetDiskInfo       (di_data_t *);
+static void releaseHeldFds      (di_data_t *);
+static void normalizeValues     (di_opt_t *, di_disk_info_t *);
 static void checkDiskInfo       (di_data_t *, int);
-static void checkDiskQuotas     (di_data_t *);
+static void checkDuplicates     (di_data_t *, int);
+static void dupIgnore           (di_data_t *, di_disk_info_t *, di_disk_info_t *);
+static void dupTableInit        (di_dup_slot_t *, Size_t);
+static di_dup_slot_t *dupTableFind (di_dup_slot_t *, Size_t, unsigned long, const char *);
+static void checkDiskQuotas     (di_data_t *, int, int);
+static int  hasFileArgs         (di_opt_t *);
 static int  checkFileInfo       (di_data_t *);
+static int  checkFilesFrom      (di_data_t *, di_file_index_t *, const char *);
+static int  checkFileFlush      (di_data_t *, di_file_index_t *);
+static void checkFilePath       (di_data_t *, di_file_index_t *, const char *, di_path_stat_t *);
+static int  fileIndexInit       (di_data_t *, di_file_index_t *);
+static void fileIndexFree       (di_file_index_t *);
 static int  getDiskSpecialInfo  (di_data_t *, int);
 static void getDiskStatInfo     (di_data_t *);
+static void statProbe           (const char *, void *);
+static void specialProbe        (const char *, void *);
+static void statProbeFree       (void *);
 static void preCheckDiskInfo    (di_data_t *);
-
-static void checkExcludeList    (di_data_t *di_data, di_disk_info_t *, di_strarr_t *);
-static void checkIncludeList    (di_data_t *, di_disk_info_t *, di_strarr_t *);
-static int  isIgnoreFSType      (const char *);
+static void planInit            (di_plan_t *);
+static void planCollection      (di_data_t *);
+static int  planNeedsValues     (di_data_t *);
+static int  planHasLoopback     (di_data_t *);
+static void preIgnoreDiskInfo   (di_data_t *);
+static void checkWhere          (di_data_t *);
+static int  whereEval           (di_data_t *, const di_where_t *, int);
+static int  pathMountEntry      (di_data_t *, const di_path_stat_t *);
+static int  pathMountTable      (di_data_t *);
+static int  pathFindEntry       (di_data_t *, const di_path_stat_t *);
+static void setPubInfo          (di_pub_disk_info_t *, const di_disk_info_t *, int);
+
+static void checkFilters        (di_data_t *, di_disk_info_t *);
+static void checkIncludeFilter  (di_data_t *, di_disk_info_t *, int);
+static int  hasIncludeFilter    (di_opt_t *);
 static int  isIgnoreFilesystem (const char *);
-static int  isIgnoreFS (const char *, const char *);
+static int  isIgnoreFS (const di_disk_info_t *);
 static int  checkForUUID        (const char *);
-static int  di_sort_compare           (const di_opt_t *, const char *sortType, const di_disk_info_t *, int, int);
+static int  hasTableDev         (const di_disk_info_t *);
+static int  isRemoteSkipped     (di_data_t *, const di_disk_info_t *);
 static void checkZone (di_disk_info_t *, di_zone_info_t *, di_opt_t *);
-static void di_sort_disk_info (di_opt_t *, di_disk_info_t *, int, const char *, int);
+static int  isShown             (const di_data_t *, int);
 static void init_scale_values (di_data_t *, di_opt_t *);
 static void di_calc_space (di_data_t *di_data, int infoidx, int validxA, int validxB, int validxC, dinum_t *val);
 static double di_calc_perc (di_data_t *di_data, int infoidx, int validxA, int validxB, int validxC, int validxD, int validxE);
+static int  di_calc_space_u (di_data_t *di_data, int infoidx, int validxA, int validxB, int validxC, di_ui_t *val);
 static void processTotals (di_data_t *di_data);
+static int  processTotalsColumns (di_data_t *di_data);
 static void addTotals (di_data_t *di_data, const di_disk_info_t *dinfo, di_disk_info_t *totals, int inpool);
 static const char *getPrintFlagText (int);
 
@@ -128,13 +192,27 @@ di_initialize (void)
 
   di_data->scale_values_init = false;
   di_data->fscount = 0;
+  di_data->fsalloc = 0;
   di_data->dispcount = 0;
+  di_data->tophidden = 0;
+  di_data->wherehidden = 0;
   di_data->haspooledfs = false;
   di_data->disppooledfs = false;
   di_data->totsorted = false;
   di_data->zoneInfo = (di_zone_info_t *) NULL;
+  di_data->deadlineAt = 0;
+  di_data->holdFds = false;
+  di_data->mntWatchFd = -1;
+  di_data->pathmode = DI_PATHMODE_NONE;
+  di_data->fsdropped = 0;
 
   di_data->diskInfo = (di_disk_info_t *) NULL;
+  di_arena_init (&di_data->arena);
+  di_intern_init (&di_data->intern);
+  di_columns_init (&di_data->columns);
+  di_mntid_index_init (&di_data->mntidx);
+  di_trie_init (&di_data->mnttrie);
+  planInit (&di_data->plan);
 
   /* options defaults */
   di_data->options = di_init_options ();
@@ -167,6 +245,11 @@ di_cleanup (void *tdi_data)
     }
     free (di_data->diskInfo);
   }
+  di_intern_free (&di_data->intern);
+  di_arena_free (&di_data->arena);
+  di_columns_free (&di_data->columns);
+  di_mntid_index_free (&di_data->mntidx);
+  di_trie_free (&di_data->mnttrie);
 
   if (di_data->pub != NULL) {
     free (di_data->pub);
@@ -178,6 +261,8 @@ di_cleanup (void *tdi_data)
   zinfo = (di_zone_info_t *) di_data->zoneInfo;
   di_free_zones (zinfo);
 
+  di_mount_table_release (di_data);
+
   if (di_data->scale_values_init) {
     for (i = 0; i < DI_SCALE_MAX; ++i) {
       dinum_clear (&di_data->scale_values [i]);
@@ -290,17 +375,48 @@ di_get_all_disk_info (void *tdi_data)
   /* initialization */
   diopts = (di_opt_t *) di_data->options;
 
+  /* the entries left by di_get_path_info () are not a full sample */
+  if (di_data->pathmode != DI_PATHMODE_NONE) {
+    resetDiskInfo (di_data);
+    di_data->pathmode = DI_PATHMODE_NONE;
+  }
+
+  di_data->deadlineAt = 0;
+  if (diopts->deadline > 0) {
+    di_data->deadlineAt = di_probe_now () + diopts->deadline;
+  }
+
   di_data->zoneInfo = di_initialize_zones (diopts);
 
   if (diopts->optval [DI_OPT_DEBUG] > 0) {
     printf ("di version %s %s\n", DI_VERSION, DI_RELEASE_STATUS);
   }
 
+  /* the mount options are not stored if they are not displayed */
+  planCollection (di_data);
+
   /* main processing */
 
   if (di_get_disk_entries (di_data, &di_data->fscount) < 0) {
     return DI_EXIT_FAIL;
   }
+  di_compact_disk_info (di_data);
+
+  /* a loopback mount may be on one of the mounts that were dropped */
+  if (di_data->fsdropped > 0 &&
+      diopts->optval [DI_OPT_EXCL_LOOPBACK] &&
+      planHasLoopback (di_data)) {
+    if (diopts->optval [DI_OPT_DEBUG] > 0) {
+      printf ("# plan: loopback mounts: reading all mounts\n");
+    }
+    resetDiskInfo (di_data);
+    di_data->zoneInfo = di_initialize_zones (diopts);
+    di_data->plan.filter = false;
+    if (di_get_disk_entries (di_data, &di_data->fscount) < 0) {
+      return DI_EXIT_FAIL;
+    }
+    di_compact_disk_info (di_data);
+  }
 
   di_data->dispcount = di_data->fscount;
   if (diopts->optval [DI_OPT_DISP_TOTALS]) {
@@ -309,12 +425,14 @@ di_get_all_disk_info (void *tdi_data)
 
   hasLoop = false;
   preCheckDiskInfo (di_data);
-  if (diopts->optidx < diopts->argc ||
-      diopts->optval [DI_OPT_EXCL_LOOPBACK]) {
+  if (hasFileArgs (diopts)) {
     getDiskStatInfo (di_data);
+  }
+  if (hasFileArgs (diopts) ||
+      diopts->optval [DI_OPT_EXCL_LOOPBACK]) {
     hasLoop = getDiskSpecialInfo (di_data, diopts->optval [DI_OPT_NO_SYMLINK]);
   }
-  if (diopts->optidx < diopts->argc) {
+  if (hasFileArgs (diopts)) {
     int     rc;
 
     rc = checkFileInfo (di_data);
@@ -323,30 +441,71 @@ di_get_all_disk_info (void *tdi_data)
     }
   }
 
-  di_get_disk_info (di_data, &di_data->fscount);
+  if (di_data->plan.preignore) {
+    preIgnoreDiskInfo (di_data);
+  }
+  if (! di_data->plan.values) {
+    /* some systems only have the file system type from statvfs () */
+    di_data->plan.values = planNeedsValues (di_data);
+  }
+  if (diopts->optval [DI_OPT_DEBUG] > 0) {
+    printf ("# plan: values %d options %d preignore %d sortvalues %d totsort %d filter %d dropped %d\n",
+        di_data->plan.values, di_data->plan.options, di_data->plan.preignore,
+        di_data->plan.sortvalues, di_data->plan.totsort,
+        di_data->plan.filter, di_data->fsdropped);
+  }
+
+  if (di_data->plan.values) {
+    di_get_disk_info (di_data, &di_data->fscount);
+  }
+
+  /* The loopback check needs the device numbers.  These have  */
+  /* usually been fetched by the statvfs () probe by now, and  */
+  /* the mounts that timed out are not tried again.            */
+  if (! hasFileArgs (diopts) &&
+      diopts->optval [DI_OPT_EXCL_LOOPBACK]) {
+    getDiskStatInfo (di_data);
+  }
 
-  /* need the sort-by-filesystem before checkDiskInfo() is called */
-  if ((di_data->haspooledfs || diopts->optval [DI_OPT_DISP_TOTALS]) &&
-      ! di_data->totsorted) {
-    di_sort_disk_info (diopts, di_data->diskInfo, di_data->fscount, "s", DI_SORT_TOTAL);
+  /* only the totals use the sort-by-filesystem */
+  if (di_data->plan.totsort && ! di_data->totsorted) {
+    di_sort_disk_info (di_data, "s", DI_SORT_TOTAL);
     di_data->totsorted = true;
   }
 
-  if (strcmp (diopts->sortType, "n") != 0) {
+  /* the columns include the totals bucket */
+  di_initialize_disk_info_arena (&di_data->diskInfo [di_data->fscount], di_data->fscount);
+  di_data->diskInfo [di_data->fscount].doPrint = 0;
+  di_data->diskInfo [di_data->fscount].printFlag = DI_PRNT_SKIP;
+
+  /* the --top selection needs the print flags, and is done later */
+  if (strcmp (diopts->sortType, "n") != 0 && diopts->topCount <= 0) {
     /* user's specified sort */
-    di_sort_disk_info (diopts, di_data->diskInfo, di_data->fscount,
-        diopts->sortType, DI_SORT_MAIN);
+    if (di_data->plan.sortvalues) {
+      di_columns_build (di_data);
+    }
+    di_sort_disk_info (di_data, diopts->sortType, DI_SORT_MAIN);
   }
 
   checkDiskInfo (di_data, hasLoop);
+  if (di_data->holdFds) {
+    releaseHeldFds (di_data);
+  }
 
-  if (diopts->optval [DI_OPT_QUOTA_CHECK] == true) {
-    checkDiskQuotas (di_data);
+  if (di_data->plan.values &&
+      diopts->optval [DI_OPT_QUOTA_CHECK] == true) {
+    checkDiskQuotas (di_data, 0, di_data->fscount);
   }
 
-  di_initialize_disk_info (&di_data->diskInfo [di_data->fscount], di_data->fscount);
-  di_data->diskInfo [di_data->fscount].doPrint = 0;
-  di_data->diskInfo [di_data->fscount].printFlag = DI_PRNT_SKIP;
+  if (diopts->where.count > 0) {
+    checkWhere (di_data);
+  }
+
+  /* the values and the print flags are final */
+  di_columns_build (di_data);
+  if (diopts->topCount > 0) {
+    di_sort_top (di_data, diopts->sortType, DI_SORT_MAIN, diopts->topCount);
+  }
   if (diopts->optval [DI_OPT_DISP_TOTALS]) {
     processTotals (di_data);
   }
@@ -354,11 +513,274 @@ di_get_all_disk_info (void *tdi_data)
   return DI_EXIT_NORM;
 }
 
+/*
+ * di_refresh_disk_info
+ *
+ * Interval sampling.  The first call does a full sample with
+ * di_get_all_disk_info () and keeps the mount point descriptors
+ * of the displayed partitions open.  Later calls only re-read the
+ * disk space through the held descriptors; the mount table is not
+ * re-read and the options are not re-applied.  If the mount table
+ * has changed, or the held descriptors cannot be used, a new
+ * full sample is taken.  If the format does not need the disk
+ * space, there is nothing to re-read.
+ *
+ */
+
 int
-di_iterate_init (void *tdi_data, int iteropt)
+di_refresh_disk_info (void *tdi_data)
+{
+  di_data_t       *di_data = (di_data_t *) tdi_data;
+  di_opt_t        *diopts;
+  di_disk_info_t  *totals;
+  int             changed;
+  int             i;
+
+  if (di_data == NULL) {
+    return DI_EXIT_FAIL;
+  }
+
+  diopts = (di_opt_t *) di_data->options;
+
+  /* the first call starts the watch before the mount table is read */
+  changed = di_mount_table_changed (di_data);
+
+  /* the --top selection and the --where predicate are applied again */
+  for (i = 0; i < di_data->fscount; ++i) {
+    di_data->diskInfo [i].topHidden = false;
+    di_data->diskInfo [i].whereHidden = false;
+  }
+  di_data->tophidden = 0;
+  di_data->wherehidden = 0;
+
+  /* the held descriptors are re-read within the same deadline */
+  di_data->deadlineAt = 0;
+  if (diopts->deadline > 0) {
+    di_data->deadlineAt = di_probe_now () + diopts->deadline;
+  }
+
+  if (! di_data->holdFds || changed ||
+      di_data->pathmode != DI_PATHMODE_NONE ||
+      (di_data->plan.values && di_get_held_disk_info (di_data) < 0)) {
+    if (diopts->optval [DI_OPT_DEBUG] > 0) {
+      printf ("# refresh: full sample\n");
+    }
+    resetDiskInfo (di_data);
+    di_data->holdFds = true;
+    return di_get_all_disk_info (di_data);
+  }
+
+  for (i = 0; i < di_data->fscount; ++i) {
+    if (di_data->diskInfo [i].doPrint) {
+      normalizeValues (diopts, &di_data->diskInfo [i]);
+    }
+  }
+
+  if (di_data->plan.values &&
+      diopts->optval [DI_OPT_QUOTA_CHECK] == true) {
+    checkDiskQuotas (di_data, 0, di_data->fscount);
+  }
+
+  if (diopts->where.count > 0) {
+    checkWhere (di_data);
+  }
+
+  if (diopts->optval [DI_OPT_DISP_TOTALS]) {
+    totals = &di_data->diskInfo [di_data->fscount];
+    for (i = 0; i < DI_VALUE_MAX; ++i) {
+      dinum_set_u (&totals->values [i], (di_ui_t) 0);
+    }
+  }
+
+  di_columns_build (di_data);
+
+  if (diopts->topCount > 0) {
+    di_sort_top (di_data, diopts->sortType, DI_SORT_MAIN, diopts->topCount);
+  } else if (strcmp (diopts->sortType, "n") != 0) {
+    di_sort_disk_info (di_data, diopts->sortType, DI_SORT_MAIN);
+  }
+
+  if (diopts->optval [DI_OPT_DISP_TOTALS]) {
+    processTotals (di_data);
+  }
+
+  return DI_EXIT_NORM;
+}
+
+/*
+ * di_get_path_info
+ *
+ * Reports on the filesystem that a single path is on, without
+ * processing the whole mount table.  The path is looked up once
+ * with statx () (or stat ()), and statvfs () is called on the path.
+ *
+ * Linux 6.8+: only the mount the path is on is fetched, by its
+ * unique mount id, with statmount ().  Otherwise the mount table is
+ * read on the first call, and is only read again if it has changed.
+ *
+ * The include/exclude and local options are applied.  Pooled
+ * filesystems are not combined, and there are no totals.
+ * pub->index may be passed to di_get_scaled () and the other
+ * value routines.  The strings in pub are valid until the next
+ * call.  This may not be mixed with di_iterate ().
+ *
+ */
+
+int
+di_get_path_info (void *tdi_data, const char *path, di_pub_disk_info_t *pub)
 {
   di_data_t       *di_data = (di_data_t *) tdi_data;
+  di_opt_t        *diopts;
   di_disk_info_t  *dinfo;
+  di_path_stat_t  ps;
+  int             changed;
+  int             loaded;
+  int             idx;
+  int             rc;
+
+  if (di_data == NULL || path == NULL || pub == NULL) {
+    return DI_EXIT_FAIL;
+  }
+
+  diopts = (di_opt_t *) di_data->options;
+
+  if (di_path_stat (path,
+      diopts->noAutomount ? DI_PATH_NO_AUTOMOUNT : 0, &ps) != 0) {
+    if (errno != ENOENT && errno != EACCES && errno != EPERM) {
+      fprintf (stderr, "stat: %s ", path);
+      perror ("");
+    }
+    return DI_EXIT_WARN;
+  }
+
+  di_data->deadlineAt = 0;
+  if (diopts->deadline > 0) {
+    di_data->deadlineAt = di_probe_now () + diopts->deadline;
+  }
+  /* the single entry is always complete */
+  planInit (&di_data->plan);
+
+  /* the first call starts the watch before the mount table is read */
+  changed = di_mount_table_changed (di_data);
+  loaded = false;
+  idx = -1;
+
+  if (di_data->pathmode == DI_PATHMODE_SINGLE && ! changed &&
+      di_data->diskInfo [0].mntUniqueId == ps.mntId &&
+      ps.mntIdType == DI_MNTID_UNIQUE) {
+    idx = 0;
+  } else if (di_data->pathmode != DI_PATHMODE_TABLE &&
+      ps.mntIdType == DI_MNTID_UNIQUE) {
+    idx = pathMountEntry (di_data, &ps);
+    if (idx < 0 && errno == ENOENT) {
+      /* unmounted after the lookup */
+      return DI_EXIT_WARN;
+    }
+  }
+
+  if (idx < 0) {
+    if (di_data->pathmode != DI_PATHMODE_TABLE || changed) {
+      if (pathMountTable (di_data) < 0) {
+        return DI_EXIT_FAIL;
+      }
+      loaded = true;
+    }
+    idx = pathFindEntry (di_data, &ps);
+  }
+  if (idx < 0) {
+    return DI_EXIT_WARN;
+  }
+
+  dinfo = &di_data->diskInfo [idx];
+  rc = di_get_disk_info_path (di_data, dinfo, path);
+  if (rc > 0) {
+    /* the disk space is only available from a full read */
+    if (! loaded && pathMountTable (di_data) < 0) {
+      return DI_EXIT_FAIL;
+    }
+    di_get_disk_info (di_data, &di_data->fscount);
+    idx = pathFindEntry (di_data, &ps);
+    if (idx < 0) {
+      return DI_EXIT_WARN;
+    }
+    dinfo = &di_data->diskInfo [idx];
+    rc = 0;
+  }
+  if (rc < 0) {
+    if (errno != ENOENT && errno != EACCES && errno != EPERM) {
+      fprintf (stderr, "statvfs: %s %s\n", path, strerror (errno));
+    }
+    return DI_EXIT_WARN;
+  }
+
+  if (diopts->optval [DI_OPT_DEBUG] > 0) {
+    printf ("# di_get_path_info: %s: %s\n", path, dinfo->strdata [DI_DISP_MOUNTPT]);
+  }
+
+  normalizeValues (diopts, dinfo);
+  dinfo->isLoopback = di_isLoopbackFs (dinfo);
+
+  /* the same as a file argument */
+  if (dinfo->printFlag == DI_PRNT_OK &&
+      (dinfo->fsClass & DI_FSCLASS_IGNORE) != DI_FSCLASS_IGNORE) {
+    dinfo->printFlag = DI_PRNT_FORCE;
+  }
+  dinfo->doPrint = dinfo->printFlag == DI_PRNT_FORCE ||
+      (dinfo->printFlag == DI_PRNT_IGNORE && diopts->optval [DI_OPT_DISP_ALL]);
+
+  if (diopts->optval [DI_OPT_QUOTA_CHECK] == true) {
+    checkDiskQuotas (di_data, idx, idx + 1);
+  }
+
+  setPubInfo (pub, dinfo, idx);
+  return DI_EXIT_NORM;
+}
+
+/*
+ * di_get_path_mounts
+ *
+ * Finds the mount point that each of the paths is on, by the longest
+ * matching mount point.  The paths are not resolved, and there are
+ * no system calls: symbolic links are not followed, and relative
+ * paths are not found.  The entries from the last call to
+ * di_get_all_disk_info () or di_refresh_disk_info () are used.
+ *
+ * indexes [i] is set to the index of the entry for paths [i] (as in
+ * pub->index), or -1.  Returns the number of paths found.
+ *
+ */
+
+int
+di_get_path_mounts (void *tdi_data, int count, const char *paths [], int indexes [])
+{
+  di_data_t   *di_data = (di_data_t *) tdi_data;
+  int         i;
+  int         found;
+
+  if (di_data == NULL) {
+    return -1;
+  }
+
+  found = 0;
+  for (i = 0; i < count; ++i) {
+    indexes [i] = -1;
+    /* di_get_path_info () may only have the one mount, and the */
+    /* path may be on one of the mounts that were dropped       */
+    if (di_data->pathmode != DI_PATHMODE_SINGLE &&
+        di_data->fsdropped == 0) {
+      indexes [i] = di_mount_trie_find (di_data, paths [i]);
+    }
+    if (indexes [i] >= 0) {
+      ++found;
+    }
+  }
+  return found;
+}
+
+int
+di_iterate_init (void *tdi_data, int iteropt)
+{
+  di_data_t       *di_data = (di_data_t *) tdi_data;
   int             i;
   int             count;
 
@@ -368,13 +790,18 @@ di_iterate_init (void *tdi_data, int iteropt)
   di_data->iteridx = 0;
   di_data->iteropt = iteropt;
 
-  count = di_data->dispcount;
+  count = di_data->dispcount - di_data->tophidden - di_data->wherehidden;
   if (iteropt == DI_ITER_PRINTABLE) {
-    count = 0;
-    for (i = 0; i < di_data->dispcount; ++i) {
-      dinfo = &di_data->diskInfo [i];
-      if (dinfo->doPrint) {
-        ++count;
+    if (di_data->columns.valid) {
+      count = di_columns_count (&di_data->columns, di_data->dispcount);
+    } else {
+      count = 0;
+      for (i = 0; i < di_data->dispcount; ++i) {
+        if (di_data->diskInfo [i].doPrint &&
+            ! di_data->diskInfo [i].topHidden &&
+            ! di_data->diskInfo [i].whereHidden) {
+          ++count;
+        }
       }
     }
   }
@@ -388,7 +815,6 @@ di_iterate (void *tdi_data)
   di_data_t           *di_data = (di_data_t *) tdi_data;
   di_pub_disk_info_t  *pub;
   di_disk_info_t      *dinfo;
-  int                 i;
   int                 sortidx;
 
   if (di_data == NULL) {
@@ -407,8 +833,11 @@ di_iterate (void *tdi_data)
   sortidx = di_data->diskInfo [di_data->iteridx].sortIndex [DI_SORT_MAIN];
   dinfo = & (di_data->diskInfo [sortidx]);
 
-  if (di_data->iteropt == DI_ITER_PRINTABLE) {
-    while (! dinfo->doPrint) {
+  /* entries outside of the --top selection, or rejected by */
+  /* --where, are never returned                             */
+  if (di_data->iteropt == DI_ITER_PRINTABLE ||
+      di_data->tophidden > 0 || di_data->wherehidden > 0) {
+    while (! isShown (di_data, sortidx)) {
       ++di_data->iteridx;
       if (di_data->iteridx >= di_data->dispcount) {
         break;
@@ -422,16 +851,7 @@ di_iterate (void *tdi_data)
     return NULL;
   }
 
-  /* populate pub structure */
-  pub->index = sortidx;
-  for (i = 0; i < DI_DISP_MAX; ++i) {
-    pub->strdata [i] = dinfo->strdata [i];
-  }
-  pub->doPrint = dinfo->doPrint;
-  pub->printFlag = dinfo->printFlag;
-  pub->isLocal = dinfo->isLocal;
-  pub->isReadOnly = dinfo->isReadOnly;
-  pub->isLoopback = dinfo->isLoopback;
+  setPubInfo (pub, dinfo, sortidx);
 
   ++di_data->iteridx;
 
@@ -446,6 +866,7 @@ di_get_scale_max (void *tdi_data, int infoidx,
   di_opt_t    *diopts;
   int         scaleidx;
   dinum_t     val;
+  di_ui_t     uval;
   int         i;
 
   if (di_data == NULL) {
@@ -459,6 +880,18 @@ di_get_scale_max (void *tdi_data, int infoidx,
   diopts = (di_opt_t *) di_data->options;
   init_scale_values (di_data, diopts);
 
+  if (di_calc_space_u (di_data, infoidx, validxA, validxB, validxC, &uval)) {
+    /* the scale values past the limit are all larger */
+    scaleidx = di_data->scale_values_ulim - 1;
+    for (i = DI_SCALE_KILO; i < di_data->scale_values_ulim; ++i) {
+      if (uval < di_data->scale_values_u [i]) {
+        scaleidx = i - 1;
+        break;
+      }
+    }
+    return scaleidx;
+  }
+
   dinum_init (&val);
   di_calc_space (di_data, infoidx, validxA, validxB, validxC, &val);
 
@@ -582,202 +1015,644 @@ di_disp_perc (void *tdi_data, char *buff, long sz, int infoidx,
 
 /* internal routines */
 
+static int
+hasFileArgs (di_opt_t *diopts)
+{
+  return diopts->optidx < diopts->argc || diopts->filesFrom != NULL;
+}
+
+static int
+hasIncludeFilter (di_opt_t *diopts)
+{
+  return diopts->include_list.count > 0 || diopts->include_path_list.count > 0;
+}
+
+/*
+ * checkFileInfo
+ *
+ * Find the mount for each of the files specified on the command
+ * line or read from the --files-from file.
+ *
+ * The device numbers and the file system names are hashed once,
+ * and the pool state (whether the entry is part of a pool, and where
+ * that pool starts) is computed once in the DI_SORT_TOTAL order, as
+ * it does not depend upon the file.  Each file is then a lookup
+ * rather than a scan of the entire mount table.
+ *
+ */
+
 static int
 checkFileInfo (di_data_t *di_data)
 {
   int                 rc;
   int                 i;
-  int                 j;
-  struct stat         statBuf;
   di_opt_t            *diopts;
-  di_disk_info_t      *diskInfo;
+  di_file_index_t     findex;
 
 
   rc = 0;
   diopts = (di_opt_t *) di_data->options;
-  diskInfo = di_data->diskInfo;
+
+  if (fileIndexInit (di_data, &findex) < 0) {
+    return -1;
+  }
+  if (diopts->argc - diopts->optidx >= DI_PATH_RING_MIN ||
+      diopts->filesFrom != NULL) {
+    findex.ring = di_path_ring_open (DI_PATH_BATCH);
+  }
+  if (diopts->optval [DI_OPT_DEBUG] > 0) {
+    printf ("# checkFileInfo: %s\n",
+        findex.ring != NULL ? "batched (io_uring)" : "stat");
+  }
 
   for (i = diopts->optidx; i < diopts->argc; ++i) {
-    int     fd;
-    int     src = -1;
-    int     saveIdx;
-    int     found = false;
-    int     inpool = false;
-    Size_t  lastpoollen = 0;
-    char    lastpool [DI_FILESYSTEM_LEN];
-
-    /* do this to automount devices.                    */
-    /* stat () will not necessarily cause an automount.  */
-    fd = open (diopts->argv [i], O_RDONLY | O_NOCTTY);
-    if (fd < 0) {
-      src = stat (diopts->argv [i], &statBuf);
-    } else {
-      src = fstat (fd, &statBuf);
-    }
-    if (fd >= 0) {
-      close (fd);
+    findex.paths [findex.pathcount++] = diopts->argv [i];
+    if (findex.pathcount == DI_PATH_BATCH) {
+      if (checkFileFlush (di_data, &findex) < 0) {
+        rc = -1;
+      }
     }
+  }
+  if (checkFileFlush (di_data, &findex) < 0) {
+    rc = -1;
+  }
 
-    if (src != 0) {
-      if (errno != ENOENT && errno != EACCES && errno != EPERM) {
-        fprintf (stderr, "stat: %s ", diopts->argv [i]);
-        perror ("");
-      }
+  if (diopts->filesFrom != NULL) {
+    if (checkFilesFrom (di_data, &findex, diopts->filesFrom) < 0) {
       rc = -1;
-      continue;
     }
+  }
 
-    saveIdx = 0;  /* should get overridden below */
-    for (j = 0; j < di_data->fscount; ++j) {
-      di_disk_info_t  *dinfo;
-      int             startpool;
-      int             poolmain;
-
-      startpool = false;
-      poolmain = false;
-
-      dinfo = & (diskInfo [diskInfo [j].sortIndex [DI_SORT_TOTAL]]);
-
-      /* is it a pooled filesystem type? */
-      if (di_data->haspooledfs && di_isPooledFs (dinfo)) {
-        if (lastpoollen == 0 ||
-            strncmp (lastpool, dinfo->strdata [DI_DISP_FILESYSTEM], lastpoollen) != 0) {
-          stpecpy (lastpool, lastpool + DI_FILESYSTEM_LEN, dinfo->strdata [DI_DISP_FILESYSTEM]);
-          lastpoollen = di_mungePoolName (lastpool);
-          inpool = false;
-        }
-
-        if (strncmp (lastpool, dinfo->strdata [DI_DISP_FILESYSTEM], lastpoollen) == 0) {
-          startpool = true;
-          if (inpool == false) {
-            poolmain = true;
-          }
-        }
-      } else {
-        inpool = false;
-      }
-
-      if (poolmain) {
-        saveIdx = j;
-      }
-
-      if (found && inpool) {
-        dinfo = & (diskInfo [diskInfo [j].sortIndex [DI_SORT_TOTAL]]);
-        dinfo->printFlag = DI_PRNT_SKIP;
-        if (diopts->optval [DI_OPT_DEBUG] > 2) {
-          printf ("  inpool B: also process %s %s\n",
-                  dinfo->strdata [DI_DISP_FILESYSTEM], dinfo->strdata [DI_DISP_MOUNTPT]);
-        }
-      }
-
-      /* when the filesystem name is specified on the command line */
-      /* report for that filesystem, not devfs or / */
-      if (strcmp (dinfo->strdata [DI_DISP_FILESYSTEM],
-              diopts->argv [i]) == 0 ||
-          (dinfo->st_dev != (unsigned long) DI_UNKNOWN_DEV &&
-          (unsigned long) statBuf.st_dev == dinfo->st_dev &&
-          ! dinfo->isLoopback)) {
-        int foundnew = 0;
-
-        ++foundnew;
-        if (dinfo->printFlag == DI_PRNT_OK) {
-          ++foundnew;
-        }
-        if (! isIgnoreFSType (dinfo->strdata [DI_DISP_FSTYPE])) {
-          ++foundnew;
-        }
-        if (foundnew == 3) {
-          dinfo->printFlag = DI_PRNT_FORCE;
-          found = true;
-        }
-
-        if (diopts->optval [DI_OPT_DEBUG] > 2) {
-          printf ("file %s: found device or fs-match %ld : %d (%s %s)\n",
-              diopts->argv [i], (long) dinfo->st_dev, foundnew,
-              dinfo->strdata [DI_DISP_FILESYSTEM], dinfo->strdata [DI_DISP_MOUNTPT]);
-        }
-
-        if (inpool) {
-          int   k;
-          for (k = saveIdx; k < j; ++k) {
-            dinfo = & (diskInfo [diskInfo [k].sortIndex [DI_SORT_TOTAL]]);
-            if (dinfo->printFlag != DI_PRNT_FORCE) {
-              dinfo->printFlag = DI_PRNT_SKIP;
-            }
-            if (diopts->optval [DI_OPT_DEBUG] > 2) {
-              printf ("  inpool A: also process %s %s\n",
-                      dinfo->strdata [DI_DISP_FILESYSTEM], dinfo->strdata [DI_DISP_MOUNTPT]);
-            }
-          }
-        }
-      }
-
-      if (startpool) {
-        inpool = true;
-      }
-    }
-  } /* for each file specified on command line */
+  fileIndexFree (&findex);
 
   /* turn everything off */
-  for (j = 0; j < di_data->fscount; ++j) {
+  for (i = 0; i < di_data->fscount; ++i) {
     di_disk_info_t        *dinfo;
 
-    dinfo = &di_data->diskInfo [j];
+    dinfo = &di_data->diskInfo [i];
     if (dinfo->printFlag == DI_PRNT_OK) {
       dinfo->printFlag = DI_PRNT_IGNORE;
     }
   }
 
-  /* also turn off the -I and -x lists */
+  /* also turn off the -I and -x lists, and the path lists */
   diopts->include_list.count = 0;
   diopts->exclude_list.count = 0;
+  diopts->include_path_list.count = 0;
+  diopts->exclude_path_list.count = 0;
   return rc;
 }
 
-
-/*
- * getDiskStatInfo
- *
- * gets the disk device number for each entry.
- *
- */
-
-static void
-getDiskStatInfo (di_data_t *di_data)
+static int
+checkFilesFrom (di_data_t *di_data, di_file_index_t *findex, const char *fn)
 {
-  int         i;
-  struct stat statBuf;
-  di_opt_t     *diopts;
-
-  diopts = (di_opt_t *) di_data->options;
+  FILE      *fh;
+  int       rc;
+  int       c;
+  Size_t    len;
+  Size_t    used;
+  char      *buff;
+  char      *path;
 
-  for (i = 0; i < di_data->fscount; ++i) {
+  rc = 0;
+  buff = (char *) malloc (DI_PATH_BUFF_SZ);
+  if (buff == NULL) {
+    fprintf (stderr, "malloc failed in checkFilesFrom.  errno %d\n", errno);
+    return -1;
+  }
+
+  if (strcmp (fn, "-") == 0) {
+    fh = stdin;
+  } else {
+    fh = fopen (fn, "r");
+  }
+  if (fh == NULL) {
+    fprintf (stderr, "open: %s ", fn);
+    perror ("");
+    free (buff);
+    return -1;
+  }
+
+  used = 0;
+  path = buff;
+  while (fgets (path, DI_MAXPATH + 2, fh) != NULL) {
+    len = strlen (path);
+    if (len > 0 && path [len - 1] == '\n') {
+      path [--len] = '\0';
+    } else if (! feof (fh)) {
+      fprintf (stderr, "%s: path too long\n", fn);
+      while ((c = getc (fh)) != EOF && c != '\n') {
+        ;
+      }
+      rc = -1;
+      continue;
+    }
+    if (len > 0 && path [len - 1] == '\r') {
+      path [--len] = '\0';
+    }
+    if (len == 0) {
+      continue;
+    }
+
+    /* the paths are kept in the buffer until the batch is done */
+    findex->paths [findex->pathcount++] = path;
+    used += len + 1;
+    if (findex->pathcount == DI_PATH_BATCH ||
+        DI_PATH_BUFF_SZ - used < DI_MAXPATH + 2) {
+      if (checkFileFlush (di_data, findex) < 0) {
+        rc = -1;
+      }
+      used = 0;
+    }
+    path = buff + used;
+  }
+  if (checkFileFlush (di_data, findex) < 0) {
+    rc = -1;
+  }
+
+  if (fh != stdin) {
+    fclose (fh);
+  }
+  free (buff);
+  return rc;
+}
+
+/* look up the waiting paths, then find their mounts in order */
+static int
+checkFileFlush (di_data_t *di_data, di_file_index_t *findex)
+{
+  int         rc;
+  int         i;
+  di_opt_t    *diopts;
+
+  rc = 0;
+  diopts = (di_opt_t *) di_data->options;
+  if (findex->pathcount == 0) {
+    return rc;
+  }
+
+  di_path_stat_batch (findex->ring, findex->pathcount, findex->paths,
+      diopts->noAutomount ? DI_PATH_NO_AUTOMOUNT : 0,
+      findex->pstat, findex->errs);
+
+  for (i = 0; i < findex->pathcount; ++i) {
+    if (findex->errs [i] != 0) {
+      if (findex->errs [i] != ENOENT && findex->errs [i] != EACCES &&
+          findex->errs [i] != EPERM) {
+        fprintf (stderr, "stat: %s ", findex->paths [i]);
+        errno = findex->errs [i];
+        perror ("");
+      }
+      rc = -1;
+      continue;
+    }
+    checkFilePath (di_data, findex, findex->paths [i], &findex->pstat [i]);
+  }
+
+  findex->pathcount = 0;
+  return rc;
+}
+
+static void
+checkFilePath (di_data_t *di_data, di_file_index_t *findex,
+    const char *path, di_path_stat_t *pstat)
+{
+  int                 nmatch;
+  int                 first;
+  int                 i;
+  int                 j;
+  int                 k;
+  int                 idx;
+  di_dup_slot_t       *slot;
+  di_opt_t            *diopts;
+  di_disk_info_t      *diskInfo;
+  di_disk_info_t      *dinfo;
+
+  diopts = (di_opt_t *) di_data->options;
+  diskInfo = di_data->diskInfo;
+
+  /* collect the positions of the matching entries */
+  ++findex->stamp;
+  nmatch = 0;
+  /* the mount id is an exact match, bind mounts share the device */
+  idx = di_mntid_index_find (di_data, pstat->mntId, pstat->mntIdType);
+  if (idx >= 0) {
+    if (diopts->optval [DI_OPT_DEBUG] > 2) {
+      printf ("file %s: mount id %lu\n", path, (unsigned long) pstat->mntId);
+    }
+    findex->seen [idx] = findex->stamp;
+    findex->matches [nmatch++] = findex->pos [idx];
+  } else {
+    slot = dupTableFind (findex->table, findex->tsize, pstat->st_dev, NULL);
+    for (idx = slot->idx; idx >= 0; idx = findex->devNext [idx]) {
+      findex->seen [idx] = findex->stamp;
+      findex->matches [nmatch++] = findex->pos [idx];
+    }
+  }
+  /* when the filesystem name is specified on the command line */
+  /* report for that filesystem, not devfs or / */
+  slot = dupTableFind (findex->table, findex->tsize, 0, path);
+  for (idx = slot->idx; idx >= 0; idx = findex->nameNext [idx]) {
+    if (findex->seen [idx] != findex->stamp) {
+      findex->seen [idx] = findex->stamp;
+      findex->matches [nmatch++] = findex->pos [idx];
+    }
+  }
+
+  /* process the matches in the DI_SORT_TOTAL order */
+  for (i = 1; i < nmatch; ++i) {
+    int   tpos;
+
+    tpos = findex->matches [i];
+    for (j = i; j > 0 && findex->matches [j - 1] > tpos; --j) {
+      findex->matches [j] = findex->matches [j - 1];
+    }
+    findex->matches [j] = tpos;
+  }
+
+  first = -1;
+  for (i = 0; i < nmatch; ++i) {
+    int     foundnew = 0;
+
+    j = findex->matches [i];
+    dinfo = & (diskInfo [diskInfo [j].sortIndex [DI_SORT_TOTAL]]);
+
+    if (first >= 0 && findex->inpool [j]) {
+      dinfo->printFlag = DI_PRNT_SKIP;
+      if (diopts->optval [DI_OPT_DEBUG] > 2) {
+        printf ("  inpool B: also process %s %s\n",
+                dinfo->strdata [DI_DISP_FILESYSTEM], dinfo->strdata [DI_DISP_MOUNTPT]);
+      }
+    }
+
+    ++foundnew;
+    if (dinfo->printFlag == DI_PRNT_OK) {
+      ++foundnew;
+    }
+    if ((dinfo->fsClass & DI_FSCLASS_IGNORE) != DI_FSCLASS_IGNORE) {
+      ++foundnew;
+    }
+    if (foundnew == 3) {
+      dinfo->printFlag = DI_PRNT_FORCE;
+      if (first < 0) {
+        first = j;
+      }
+    }
+
+    if (diopts->optval [DI_OPT_DEBUG] > 2) {
+      printf ("file %s: found device or fs-match %ld : %d (%s %s)\n",
+          path, (long) dinfo->st_dev, foundnew,
+          dinfo->strdata [DI_DISP_FILESYSTEM], dinfo->strdata [DI_DISP_MOUNTPT]);
+    }
+
+    if (findex->inpool [j]) {
+      for (k = findex->poolStart [j]; k < j; ++k) {
+        dinfo = & (diskInfo [diskInfo [k].sortIndex [DI_SORT_TOTAL]]);
+        if (dinfo->printFlag != DI_PRNT_FORCE) {
+          dinfo->printFlag = DI_PRNT_SKIP;
+        }
+        if (diopts->optval [DI_OPT_DEBUG] > 2) {
+          printf ("  inpool A: also process %s %s\n",
+                  dinfo->strdata [DI_DISP_FILESYSTEM], dinfo->strdata [DI_DISP_MOUNTPT]);
+        }
+      }
+    }
+  }
+
+  /* The pooled entries following the first match are skipped.      */
+  /* These only change to skipped, so the entries after an earlier  */
+  /* file's first match have already been done.                     */
+  if (first >= 0 && first < findex->skipFrom) {
+    for (j = first + 1; j <= findex->skipFrom && j < di_data->fscount; ++j) {
+      if (findex->inpool [j]) {
+        dinfo = & (diskInfo [diskInfo [j].sortIndex [DI_SORT_TOTAL]]);
+        dinfo->printFlag = DI_PRNT_SKIP;
+        if (diopts->optval [DI_OPT_DEBUG] > 2) {
+          printf ("  inpool B: also process %s %s\n",
+                  dinfo->strdata [DI_DISP_FILESYSTEM], dinfo->strdata [DI_DISP_MOUNTPT]);
+        }
+      }
+    }
+    findex->skipFrom = first;
+  }
+}
+
+static int
+fileIndexInit (di_data_t *di_data, di_file_index_t *findex)
+{
+  int             j;
+  int             idx;
+  int             count;
+  int             inpool;
+  int             poolStart;
+  Size_t          lastpoollen;
+  char            lastpool [DI_FILESYSTEM_LEN];
+  di_dup_slot_t   *slot;
+  di_disk_info_t  *diskInfo;
+  di_disk_info_t  *dinfo;
+
+  diskInfo = di_data->diskInfo;
+  count = di_data->fscount;
+  findex->ring = NULL;
+  findex->pathcount = 0;
+
+  findex->tsize = 16;
+  while (findex->tsize < (Size_t) count * 4) {
+    findex->tsize *= 2;
+  }
+  findex->table = (di_dup_slot_t *) malloc (sizeof (di_dup_slot_t) * findex->tsize);
+  /* devNext, nameNext, pos, poolStart, matches, seen */
+  findex->ibuff = (int *) malloc (sizeof (int) * (Size_t) (count + 1) * 6);
+  findex->inpool = (char *) malloc ((Size_t) count + 1);
+  if (findex->table == NULL || findex->ibuff == NULL || findex->inpool == NULL) {
+    fprintf (stderr, "malloc failed in checkFileInfo.  errno %d\n", errno);
+    fileIndexFree (findex);
+    return -1;
+  }
+  findex->devNext = findex->ibuff;
+  findex->nameNext = findex->devNext + count + 1;
+  findex->pos = findex->nameNext + count + 1;
+  findex->poolStart = findex->pos + count + 1;
+  findex->matches = findex->poolStart + count + 1;
+  findex->seen = findex->matches + count + 1;
+  findex->stamp = 0;
+  findex->skipFrom = count;
+  dupTableInit (findex->table, findex->tsize);
+
+  /* the chains are built in reverse so that they are in index order */
+  for (idx = count - 1; idx >= 0; --idx) {
+    dinfo = &diskInfo [idx];
+    findex->seen [idx] = 0;
+
+    findex->devNext [idx] = -1;
+    if (dinfo->st_dev != (unsigned long) DI_UNKNOWN_DEV &&
+        ! dinfo->isLoopback) {
+      slot = dupTableFind (findex->table, findex->tsize, dinfo->st_dev, NULL);
+      if (slot->idx < 0) {
+        slot->dev = dinfo->st_dev;
+      }
+      findex->devNext [idx] = slot->idx;
+      slot->idx = idx;
+    }
+
+    slot = dupTableFind (findex->table, findex->tsize, 0,
+        dinfo->strdata [DI_DISP_FILESYSTEM]);
+    if (slot->idx < 0) {
+      slot->root = dinfo->strdata [DI_DISP_FILESYSTEM];
+    }
+    findex->nameNext [idx] = slot->idx;
+    slot->idx = idx;
+  }
+
+  /* the pool state in the DI_SORT_TOTAL order */
+  inpool = false;
+  poolStart = 0;
+  lastpoollen = 0;
+  for (j = 0; j < count; ++j) {
+    int     startpool;
+
+    startpool = false;
+    dinfo = & (diskInfo [diskInfo [j].sortIndex [DI_SORT_TOTAL]]);
+    findex->pos [diskInfo [j].sortIndex [DI_SORT_TOTAL]] = j;
+
+    /* is it a pooled filesystem type? */
+    if (di_data->haspooledfs && di_isPooledFs (dinfo)) {
+      if (lastpoollen == 0 ||
+          strncmp (lastpool, dinfo->strdata [DI_DISP_FILESYSTEM], lastpoollen) != 0) {
+        stpecpy (lastpool, lastpool + DI_FILESYSTEM_LEN, dinfo->strdata [DI_DISP_FILESYSTEM]);
+        lastpoollen = di_mungePoolName (lastpool);
+        inpool = false;
+      }
+
+      if (strncmp (lastpool, dinfo->strdata [DI_DISP_FILESYSTEM], lastpoollen) == 0) {
+        startpool = true;
+        if (inpool == false) {
+          poolStart = j;
+        }
+      }
+    } else {
+      inpool = false;
+    }
+
+    findex->inpool [j] = (char) inpool;
+    findex->poolStart [j] = poolStart;
+
+    if (startpool) {
+      inpool = true;
+    }
+  }
+
+  return 0;
+}
+
+static void
+fileIndexFree (di_file_index_t *findex)
+{
+  if (findex->table != NULL) {
+    free (findex->table);
+  }
+  if (findex->ibuff != NULL) {
+    free (findex->ibuff);
+  }
+  if (findex->inpool != NULL) {
+    free (findex->inpool);
+  }
+  di_path_ring_close (findex->ring);
+  findex->ring = NULL;
+  findex->table = NULL;
+  findex->ibuff = NULL;
+  findex->inpool = NULL;
+}
+
+
+/*
+ * statProbe
+ *
+ * the stat () for the mount point or special device.
+ * this may be run in a separate thread.
+ *
+ */
+
+static void
+statProbe (const char *path, void *result)
+{
+  di_stat_probe_t *probe;
+  struct stat     statBuf;
+
+  probe = (di_stat_probe_t *) result;
+  probe->resolved = NULL;
+  probe->st_dev = 0;
+  probe->st_rdev = 0;
+  probe->err = 0;
+  probe->rc = stat (path, &statBuf);
+  if (probe->rc == 0) {
+    probe->st_dev = (unsigned long) statBuf.st_dev;
+    probe->st_rdev = (unsigned long) statBuf.st_rdev;
+  } else {
+    probe->err = errno;
+  }
+}
+
+/*
+ * specialProbe
+ *
+ * the stat () for the special device.  resolves the symlink for
+ * special devices with a trailing UUID.
+ * this may be run in a separate thread.
+ *
+ */
+
+static void
+specialProbe (const char *path, void *result)
+{
+  di_stat_probe_t *probe;
+
+  statProbe (path, result);
+  probe = (di_stat_probe_t *) result;
+
+#if _lib_realpath && _define_S_ISLNK && _lib_lstat
+  if (probe->rc == 0 && checkForUUID (path)) {
+    int           rc;
+    struct stat   tstatBuf;
+
+    rc = lstat (path, &tstatBuf);
+    if (rc == 0 && S_ISLNK (tstatBuf.st_mode)) {
+      char tspecial [DI_FILESYSTEM_LEN];
+
+      if (realpath (path, tspecial) != (char *) NULL) {
+        probe->resolved = strdup (tspecial);
+      }
+    }
+  }
+#endif
+}
+
+/* a resolved name that is not collected */
+static void
+statProbeFree (void *result)
+{
+  di_stat_probe_t *probe;
+
+  probe = (di_stat_probe_t *) result;
+  free (probe->resolved);
+  probe->resolved = NULL;
+}
+
+/*
+ * getDiskStatInfo
+ *
+ * gets the disk device number for each entry.
+ *
+ */
+
+static void
+getDiskStatInfo (di_data_t *di_data)
+{
+  int             i;
+  const char      **paths;
+  int             *status;
+  di_stat_probe_t *probes;
+  di_opt_t        *diopts;
+
+  diopts = (di_opt_t *) di_data->options;
+
+  if (di_data->fscount <= 0) {
+    return;
+  }
+
+  probes = (di_stat_probe_t *) malloc (sizeof (di_stat_probe_t) *
+      (Size_t) di_data->fscount);
+  paths = (const char **) malloc (sizeof (const char *) * (Size_t) di_data->fscount);
+  status = (int *) malloc (sizeof (int) * (Size_t) di_data->fscount);
+  if (probes == NULL || paths == NULL || status == NULL) {
+    fprintf (stderr, "malloc failed in getDiskStatInfo.  errno %d\n", errno);
+    free (probes);
+    free (paths);
+    free (status);
+    return;
+  }
+
+  for (i = 0; i < di_data->fscount; ++i) {
     di_disk_info_t        *dinfo;
 
     dinfo = &di_data->diskInfo [i];
+    paths [i] = NULL;
+
+    /* already fetched by the statvfs () probe */
+    if (dinfo->hasStDev) {
+      continue;
+    }
 
     /* don't try to stat devices that are not accessible */
     if (dinfo->printFlag == DI_PRNT_EXCLUDE ||
         dinfo->printFlag == DI_PRNT_BAD ||
+        dinfo->printFlag == DI_PRNT_TIMEOUT ||
+        dinfo->printFlag == DI_PRNT_STALE ||
         dinfo->printFlag == DI_PRNT_OUTOFZONE) {
       continue;
     }
+    if (isRemoteSkipped (di_data, dinfo)) {
+      continue;
+    }
+
+    /* the mount table already has the device number */
+    if (hasTableDev (dinfo)) {
+      dinfo->st_dev = dinfo->mntDev;
+      dinfo->hasStDev = true;
+      if (diopts->optval [DI_OPT_DEBUG] > 2) {
+        printf ("dev: %s: %ld (mount table)\n", dinfo->strdata [DI_DISP_MOUNTPT],
+            (long) dinfo->st_dev);
+      }
+      continue;
+    }
 
     dinfo->st_dev = (unsigned long) DI_UNKNOWN_DEV;
+    paths [i] = dinfo->strdata [DI_DISP_MOUNTPT];
+  }
+
+  di_probe_run (di_data, di_data->fscount, paths, statProbe, NULL,
+      probes, sizeof (di_stat_probe_t), status);
+
+  for (i = 0; i < di_data->fscount; ++i) {
+    di_disk_info_t        *dinfo;
+
+    dinfo = &di_data->diskInfo [i];
 
-    if (stat (dinfo->strdata [DI_DISP_MOUNTPT], &statBuf) == 0) {
-      dinfo->st_dev = (unsigned long) statBuf.st_dev;
+    if (status [i] == DI_PROBE_TIMEOUT) {
+      dinfo->printFlag = DI_PRNT_TIMEOUT;
+      fprintf (stderr, "stat: %s timed out\n", dinfo->strdata [DI_DISP_MOUNTPT]);
+      continue;
+    }
+    if (status [i] == DI_PROBE_STALE) {
+      if (dinfo->printFlag != DI_PRNT_SKIP) {
+        dinfo->printFlag = DI_PRNT_STALE;
+      }
+      continue;
+    }
+    if (status [i] != DI_PROBE_DONE) {
+      continue;
+    }
+
+    if (probes [i].rc == 0) {
+      dinfo->st_dev = probes [i].st_dev;
+      dinfo->hasStDev = true;
       if (diopts->optval [DI_OPT_DEBUG] > 2) {
         printf ("dev: %s: %ld\n", dinfo->strdata [DI_DISP_MOUNTPT],
             (long) dinfo->st_dev);
       }
     } else {
-      if (errno != ENOENT && errno != EACCES && errno != EPERM) {
-        fprintf (stderr, "stat: %s ", dinfo->strdata [DI_DISP_MOUNTPT]);
-        perror ("");
+      if (probes [i].err != ENOENT &&
+          probes [i].err != EACCES &&
+          probes [i].err != EPERM) {
+        fprintf (stderr, "stat: %s %s\n", dinfo->strdata [DI_DISP_MOUNTPT],
+            strerror (probes [i].err));
       }
     }
   }
+
+  free (probes);
+  free (paths);
+  free (status);
 }
 
 /*
@@ -787,71 +1662,221 @@ getDiskStatInfo (di_data_t *di_data)
  *
  */
 
+/* discard the previous sample before a full sample is taken */
+static void
+resetDiskInfo (di_data_t *di_data)
+{
+  int             i;
+  di_zone_info_t  *zinfo;
+
+  if (di_data->diskInfo != (di_disk_info_t *) NULL) {
+    /* the totals bucket is at di_data->fscount */
+    for (i = 0; i <= di_data->fscount; ++i) {
+      di_free_disk_info (&di_data->diskInfo [i]);
+    }
+    free (di_data->diskInfo);
+    di_data->diskInfo = (di_disk_info_t *) NULL;
+  }
+  di_intern_free (&di_data->intern);
+  di_arena_free (&di_data->arena);
+  /* the column allocation is re-used */
+  di_data->columns.valid = false;
+  di_data->mntidx.valid = false;
+  di_data->mnttrie.valid = false;
+  di_data->fscount = 0;
+  di_data->fsalloc = 0;
+  di_data->dispcount = 0;
+  di_data->tophidden = 0;
+  di_data->wherehidden = 0;
+  di_data->haspooledfs = false;
+  di_data->disppooledfs = false;
+  di_data->totsorted = false;
+  di_data->fsdropped = 0;
+
+  zinfo = (di_zone_info_t *) di_data->zoneInfo;
+  di_free_zones (zinfo);
+  di_data->zoneInfo = NULL;
+}
+
+/* only the descriptors of the displayed partitions are kept, */
+/* and of the partitions whose statvfs () result they share    */
+static void
+releaseHeldFds (di_data_t *di_data)
+{
+  int             i;
+  di_disk_info_t  *dinfo;
+  int             *needed;
+
+  needed = (int *) calloc ((Size_t) di_data->fscount + 1, sizeof (int));
+  if (needed == NULL) {
+    return;
+  }
+  for (i = 0; i < di_data->fscount; ++i) {
+    dinfo = &di_data->diskInfo [i];
+    if (dinfo->doPrint) {
+      needed [i] = true;
+      if (dinfo->statRep >= 0) {
+        needed [dinfo->statRep] = true;
+      }
+    }
+  }
+  for (i = 0; i < di_data->fscount; ++i) {
+    if (! needed [i]) {
+      di_release_disk_fd (&di_data->diskInfo [i]);
+    }
+  }
+  free (needed);
+}
+
+static void
+normalizeValues (di_opt_t *diopts, di_disk_info_t *dinfo)
+{
+  /* Solaris reports a cdrom as having no free blocks,   */
+  /* no available.  Their df doesn't always work right!  */
+  /* -1 is returned.                                     */
+  if (diopts->optval [DI_OPT_DEBUG] > 5) {
+    char  tbuff [100];
+
+    dinum_str (&dinfo->values [DI_SPACE_FREE], tbuff, sizeof (tbuff));
+    printf ("chk: %s free: %s\n", dinfo->strdata [DI_DISP_MOUNTPT], tbuff);
+  }
+  if (dinum_cmp_s (&dinfo->values [DI_SPACE_FREE], (di_si_t) -1) == 0 ||
+      dinum_cmp_s (&dinfo->values [DI_SPACE_FREE], (di_si_t) -2) == 0) {
+    dinum_set_u (&dinfo->values [DI_SPACE_FREE], (di_ui_t) 0);
+  }
+  if (dinum_cmp_s (&dinfo->values [DI_SPACE_AVAIL], (di_si_t) -1) == 0 ||
+      dinum_cmp_s (&dinfo->values [DI_SPACE_AVAIL], (di_si_t) -2) == 0) {
+    dinum_set_u (&dinfo->values [DI_SPACE_AVAIL], (di_ui_t) 0);
+  }
+
+  {
+    dinum_t     temp;
+
+    dinum_init (&temp);
+
+    dinum_set_u (&temp, (di_ui_t) ~0);
+    if (dinum_cmp (&dinfo->values [DI_INODE_TOTAL], &temp) == 0) {
+      dinum_set_u (&dinfo->values [DI_INODE_TOTAL], (di_ui_t) 0);
+      dinum_set_u (&dinfo->values [DI_INODE_FREE], (di_ui_t) 0);
+      dinum_set_u (&dinfo->values [DI_INODE_AVAIL], (di_ui_t) 0);
+    }
+    dinum_clear (&temp);
+  }
+}
+
 static int
 getDiskSpecialInfo (di_data_t *di_data, int dontResolveSymlink)
 {
-  int         i;
-  struct stat statBuf;
-  int         hasLoop;
-  di_opt_t     *diopts;
+  int             i;
+  int             hasLoop;
+  const char      **paths;
+  int             *status;
+  di_stat_probe_t *probes;
+  di_probe_func_t probefunc;
+  di_opt_t        *diopts;
 
   diopts = (di_opt_t *) di_data->options;
 
   hasLoop = false;
-  for (i = 0; i < di_data->fscount; ++i)
-  {
+  if (di_data->fscount <= 0) {
+    return hasLoop;
+  }
+
+  probes = (di_stat_probe_t *) malloc (sizeof (di_stat_probe_t) *
+      (Size_t) di_data->fscount);
+  paths = (const char **) malloc (sizeof (const char *) * (Size_t) di_data->fscount);
+  status = (int *) malloc (sizeof (int) * (Size_t) di_data->fscount);
+  if (probes == NULL || paths == NULL || status == NULL) {
+    fprintf (stderr, "malloc failed in getDiskSpecialInfo.  errno %d\n", errno);
+    free (probes);
+    free (paths);
+    free (status);
+    return hasLoop;
+  }
+
+  for (i = 0; i < di_data->fscount; ++i) {
     di_disk_info_t        *dinfo;
 
     dinfo = &di_data->diskInfo [i];
+    paths [i] = NULL;
 
     /* check for initial slash; otherwise we can pick up normal files */
-    if (* (dinfo->strdata [DI_DISP_FILESYSTEM]) == '/' &&
-        stat (dinfo->strdata [DI_DISP_FILESYSTEM], &statBuf) == 0) {
-      if (! dontResolveSymlink && checkForUUID (dinfo->strdata [DI_DISP_FILESYSTEM])) {
-#if _lib_realpath && _define_S_ISLNK && _lib_lstat
-        int           rc;
-        struct stat   tstatBuf;
+    if (* (dinfo->strdata [DI_DISP_FILESYSTEM]) != '/') {
+      continue;
+    }
+    if (isRemoteSkipped (di_data, dinfo)) {
+      continue;
+    }
+    /* the device number is in the mount table, but a special */
+    /* with a trailing UUID must still be resolved             */
+    if (hasTableDev (dinfo) &&
+        (dontResolveSymlink ||
+        ! checkForUUID (dinfo->strdata [DI_DISP_FILESYSTEM]))) {
+      continue;
+    }
+    paths [i] = dinfo->strdata [DI_DISP_FILESYSTEM];
+  }
 
-        rc = lstat (dinfo->strdata [DI_DISP_FILESYSTEM], &tstatBuf);
-        if (rc == 0 && S_ISLNK (tstatBuf.st_mode)) {
-          char tspecial [DI_FILESYSTEM_LEN];
+  probefunc = specialProbe;
+  if (dontResolveSymlink) {
+    probefunc = statProbe;
+  }
+  di_probe_run (di_data, di_data->fscount, paths, probefunc, statProbeFree,
+      probes, sizeof (di_stat_probe_t), status);
 
-          if (realpath (dinfo->strdata [DI_DISP_FILESYSTEM], tspecial) != (char *) NULL) {
-            stpecpy (dinfo->strdata [DI_DISP_FILESYSTEM],
-                dinfo->strdata [DI_DISP_FILESYSTEM] + DI_FILESYSTEM_LEN,
-                tspecial);
-          }
-        }
-#endif
-      }
-      dinfo->sp_dev = (unsigned long) statBuf.st_dev;
-      dinfo->sp_rdev = (unsigned long) statBuf.st_rdev;
-
-      /* Solaris's loopback device is "lofs"            */
-      /* linux loopback device is "none"                */
-      /* linux has rdev = 0                             */
-      /* DragonFlyBSD's loopback device is "null"       */
-      /*   but not with special = /.../@@-               */
-      /* DragonFlyBSD has rdev = -1                     */
-      /* solaris is more consistent; rdev != 0 for lofs */
-      /* solaris makes sense.                           */
-      if (di_isLoopbackFs (dinfo)) {
-        dinfo->isLoopback = true;
-        hasLoop = true;
-      }
-      if (diopts->optval [DI_OPT_DEBUG] > 2) {
-        printf ("special dev: %s %s: %ld rdev: %ld loopback: %d\n",
-            dinfo->strdata [DI_DISP_FILESYSTEM],
-            dinfo->strdata [DI_DISP_MOUNTPT],
-            (long) dinfo->sp_dev,
-            (long) dinfo->sp_rdev, dinfo->isLoopback);
+  for (i = 0; i < di_data->fscount; ++i)
+  {
+    di_disk_info_t        *dinfo;
+
+    dinfo = &di_data->diskInfo [i];
+
+    if (status [i] == DI_PROBE_TIMEOUT) {
+      fprintf (stderr, "stat: %s timed out\n", dinfo->strdata [DI_DISP_FILESYSTEM]);
+    }
+
+    if (status [i] == DI_PROBE_DONE && probes [i].rc == 0) {
+      if (probes [i].resolved != NULL) {
+        di_set_disk_string (di_data, dinfo, DI_DISP_FILESYSTEM,
+            probes [i].resolved);
+        free (probes [i].resolved);
       }
+      dinfo->sp_dev = probes [i].st_dev;
+      dinfo->sp_rdev = probes [i].st_rdev;
+    } else if (paths [i] == NULL && hasTableDev (dinfo) &&
+        * (dinfo->strdata [DI_DISP_FILESYSTEM]) == '/') {
+      dinfo->sp_dev = dinfo->mntDev;
+      dinfo->sp_rdev = dinfo->mntDev;
     } else {
       dinfo->sp_dev = 0;
       dinfo->sp_rdev = 0;
+      continue;
+    }
+
+    /* Solaris's loopback device is "lofs"            */
+    /* linux loopback device is "none"                */
+    /* linux has rdev = 0                             */
+    /* DragonFlyBSD's loopback device is "null"       */
+    /*   but not with special = /.../@@-               */
+    /* DragonFlyBSD has rdev = -1                     */
+    /* solaris is more consistent; rdev != 0 for lofs */
+    /* solaris makes sense.                           */
+    if (di_isLoopbackFs (dinfo)) {
+      dinfo->isLoopback = true;
+      hasLoop = true;
+    }
+    if (diopts->optval [DI_OPT_DEBUG] > 2) {
+      printf ("special dev: %s %s: %ld rdev: %ld loopback: %d\n",
+          dinfo->strdata [DI_DISP_FILESYSTEM],
+          dinfo->strdata [DI_DISP_MOUNTPT],
+          (long) dinfo->sp_dev,
+          (long) dinfo->sp_rdev, dinfo->isLoopback);
     }
   }
 
+  free (probes);
+  free (paths);
+  free (status);
+
   return hasLoop;
 }
 
@@ -866,7 +1891,6 @@ static void
 checkDiskInfo (di_data_t *di_data, int hasLoop)
 {
   int             i;
-  int             j;
   di_opt_t     *diopts;
 
   diopts = (di_opt_t *) di_data->options;
@@ -880,6 +1904,7 @@ checkDiskInfo (di_data_t *di_data, int hasLoop)
     /* these are never printed... */
     if (dinfo->printFlag == DI_PRNT_EXCLUDE ||
         dinfo->printFlag == DI_PRNT_BAD ||
+        dinfo->printFlag == DI_PRNT_TIMEOUT ||
         dinfo->printFlag == DI_PRNT_OUTOFZONE) {
       if (diopts->optval [DI_OPT_DEBUG] > 2) {
         printf ("chk: skipping (%s):%s\n",
@@ -899,39 +1924,12 @@ checkDiskInfo (di_data_t *di_data, int hasLoop)
       dinfo->doPrint = diopts->optval [DI_OPT_DISP_ALL];
     }
 
-    /* Solaris reports a cdrom as having no free blocks,   */
-    /* no available.  Their df doesn't always work right!  */
-    /* -1 is returned.                                     */
-    if (diopts->optval [DI_OPT_DEBUG] > 5) {
-      char  tbuff [100];
+    normalizeValues (diopts, dinfo);
 
-      dinum_str (&dinfo->values [DI_SPACE_FREE], tbuff, sizeof (tbuff));
-      printf ("chk: %s free: %s\n", dinfo->strdata [DI_DISP_MOUNTPT], tbuff);
-    }
-    if (dinum_cmp_s (&dinfo->values [DI_SPACE_FREE], (di_si_t) -1) == 0 ||
-        dinum_cmp_s (&dinfo->values [DI_SPACE_FREE], (di_si_t) -2) == 0) {
-      dinum_set_u (&dinfo->values [DI_SPACE_FREE], (di_ui_t) 0);
-    }
-    if (dinum_cmp_s (&dinfo->values [DI_SPACE_AVAIL], (di_si_t) -1) == 0 ||
-        dinum_cmp_s (&dinfo->values [DI_SPACE_AVAIL], (di_si_t) -2) == 0) {
-      dinum_set_u (&dinfo->values [DI_SPACE_AVAIL], (di_ui_t) 0);
-    }
-
-    {
-      dinum_t     temp;
-
-      dinum_init (&temp);
-
-      dinum_set_u (&temp, (di_ui_t) ~0);
-      if (dinum_cmp (&dinfo->values [DI_INODE_TOTAL], &temp) == 0) {
-        dinum_set_u (&dinfo->values [DI_INODE_TOTAL], (di_ui_t) 0);
-        dinum_set_u (&dinfo->values [DI_INODE_FREE], (di_ui_t) 0);
-        dinum_set_u (&dinfo->values [DI_INODE_AVAIL], (di_ui_t) 0);
-      }
-      dinum_clear (&temp);
-    }
-
-    if (dinfo->printFlag == DI_PRNT_OK) {
+    /* a stale entry was not sampled before the deadline, */
+    /* but is otherwise displayed as usual                */
+    if (dinfo->printFlag == DI_PRNT_OK ||
+        dinfo->printFlag == DI_PRNT_STALE) {
       if (diopts->optval [DI_OPT_DEBUG] > 5) {
         char    tbuff [100];
 
@@ -939,7 +1937,7 @@ checkDiskInfo (di_data_t *di_data, int hasLoop)
         printf ("chk: %s total: %s\n", dinfo->strdata [DI_DISP_MOUNTPT], tbuff);
       }
 
-      if (isIgnoreFSType (dinfo->strdata [DI_DISP_FSTYPE])) {
+      if ((dinfo->fsClass & DI_FSCLASS_IGNORE) == DI_FSCLASS_IGNORE) {
         dinfo->printFlag = DI_PRNT_IGNORE;
         dinfo->doPrint = diopts->optval [DI_OPT_DISP_ALL];
         if (diopts->optval [DI_OPT_DEBUG] > 2) {
@@ -953,7 +1951,7 @@ checkDiskInfo (di_data_t *di_data, int hasLoop)
           printf ("chk: ignore-filesystem: %s\n", dinfo->strdata [DI_DISP_FILESYSTEM]);
         }
       }
-      if (isIgnoreFS (dinfo->strdata [DI_DISP_FSTYPE], dinfo->strdata [DI_DISP_MOUNTPT])) {
+      if (isIgnoreFS (dinfo)) {
         dinfo->printFlag = DI_PRNT_IGNORE;
         dinfo->doPrint = diopts->optval [DI_OPT_DISP_ALL];
         if (diopts->optval [DI_OPT_DEBUG] > 2) {
@@ -962,9 +1960,10 @@ checkDiskInfo (di_data_t *di_data, int hasLoop)
       }
 
       /* Some systems return a -1 or -2 as an indicator */
-      if (dinum_cmp_s (&dinfo->values [DI_SPACE_TOTAL], (di_si_t) 0) == 0 ||
+      if (di_data->plan.values && dinfo->printFlag == DI_PRNT_OK && (
+          dinum_cmp_s (&dinfo->values [DI_SPACE_TOTAL], (di_si_t) 0) == 0 ||
           dinum_cmp_s (&dinfo->values [DI_SPACE_TOTAL], (di_si_t) -1) == 0 ||
-          dinum_cmp_s (&dinfo->values [DI_SPACE_TOTAL], (di_si_t) -2L) == 0) {
+          dinum_cmp_s (&dinfo->values [DI_SPACE_TOTAL], (di_si_t) -2L) == 0)) {
         dinfo->printFlag = DI_PRNT_IGNORE;
         dinfo->doPrint = diopts->optval [DI_OPT_DISP_ALL];
         if (diopts->optval [DI_OPT_DEBUG] > 2) {
@@ -975,13 +1974,134 @@ checkDiskInfo (di_data_t *di_data, int hasLoop)
     }
 
     /* make sure anything in the include list didn't get turned off */
-    checkIncludeList (di_data, dinfo, &diopts->include_list);
+    checkIncludeFilter (di_data, dinfo,
+        di_filter_match (di_data, dinfo->fsClass, dinfo->pathFilter));
   } /* for all disks */
 
-  if (hasLoop && diopts->optval [DI_OPT_EXCL_LOOPBACK]) {
-    /* this loop sets duplicate entries to be ignored. */
+  if (diopts->optval [DI_OPT_EXCL_LOOPBACK]) {
+    checkDuplicates (di_data, hasLoop);
+  }
+}
+
+/*
+ * checkDuplicates
+ *
+ * Sets duplicate entries to be ignored.  Both checks use a hash
+ * table, and are linear in the number of entries.
+ *
+ * The mount table (linux) has the device and the root of the mount
+ * within the filesystem.  A mount is a duplicate if another mount of
+ * the same device has the same root (earlier in the mount table), or
+ * has a root that contains this mount's root.  This finds the bind
+ * mounts, which have the filesystem type of the original.  The btrfs
+ * subvolumes share the device, and each subvolume's root is below
+ * the top level subvolume's root, so btrfs only uses the first test.
+ *
+ * Otherwise, a loopback mount (lofs, nullfs, none) is a duplicate
+ * if its special is on another mounted partition.
+ *
+ */
+
+static void
+checkDuplicates (di_data_t *di_data, int hasLoop)
+{
+  int             i;
+  di_opt_t        *diopts;
+  di_dup_slot_t   *table;
+  di_dup_slot_t   *slot;
+  Size_t          tsize;
+  char            *root;
+  char            *p;
+
+  diopts = (di_opt_t *) di_data->options;
+
+  tsize = 16;
+  while (tsize < (Size_t) di_data->fscount * 2) {
+    tsize *= 2;
+  }
+  table = (di_dup_slot_t *) malloc (sizeof (di_dup_slot_t) * tsize);
+  if (table == NULL) {
+    fprintf (stderr, "malloc failed in checkDuplicates.  errno %d\n", errno);
+    return;
+  }
+
+  dupTableInit (table, tsize);
+  for (i = 0; i < di_data->fscount; ++i) {
+    di_disk_info_t        *dinfo;
+
+    dinfo = &di_data->diskInfo [i];
+    if (! dinfo->hasMntDev || dinfo->mntRoot == NULL) {
+      continue;
+    }
+    slot = dupTableFind (table, tsize, dinfo->mntDev, dinfo->mntRoot);
+    if (slot->idx < 0) {
+      slot->dev = dinfo->mntDev;
+      slot->root = dinfo->mntRoot;
+      slot->idx = i;
+    }
+  }
+
+  for (i = 0; i < di_data->fscount; ++i) {
+    di_disk_info_t        *dinfo;
+
+    dinfo = &di_data->diskInfo [i];
+    if (dinfo->printFlag != DI_PRNT_OK ||
+        ! dinfo->hasMntDev || dinfo->mntRoot == NULL) {
+      continue;
+    }
+
+    slot = dupTableFind (table, tsize, dinfo->mntDev, dinfo->mntRoot);
+    if (slot->idx == i &&
+        (dinfo->fsClass & DI_FSCLASS_BTRFS) == DI_FSCLASS_BTRFS) {
+      slot = NULL;
+    } else if (slot->idx == i) {
+      slot = NULL;
+      root = strdup (dinfo->mntRoot);
+      if (root == NULL) {
+        continue;
+      }
+      /* walk up through the parent directories of the root */
+      while ( (p = strrchr (root, '/')) != NULL && root [1] != '\0') {
+        if (p == root) {
+          ++p;
+        }
+        *p = '\0';
+        slot = dupTableFind (table, tsize, dinfo->mntDev, root);
+        if (slot->idx >= 0) {
+          break;
+        }
+        slot = NULL;
+      }
+      free (root);
+    }
+
+    if (slot != NULL) {
+      dupIgnore (di_data, dinfo, &di_data->diskInfo [slot->idx]);
+    }
+  }
+
+  if (hasLoop) {
+    /* the partitions, by device */
+    dupTableInit (table, tsize);
+    for (i = 0; i < di_data->fscount; ++i) {
+      di_disk_info_t        *dinfo;
+
+      dinfo = &di_data->diskInfo [i];
+      if (dinfo->sp_dev == 0) {
+        continue;
+      }
+      slot = dupTableFind (table, tsize, dinfo->st_dev, NULL);
+      if (slot->idx < 0) {
+        slot->dev = dinfo->st_dev;
+        slot->idx = i;
+      } else if (slot->idxb < 0) {
+        slot->idxb = i;
+      }
+    }
+
     for (i = 0; i < di_data->fscount; ++i) {
       di_disk_info_t        *dinfo;
+      int                   j;
 
       dinfo = &di_data->diskInfo [i];
       if (dinfo->printFlag != DI_PRNT_OK) {
@@ -992,65 +2112,104 @@ checkDiskInfo (di_data_t *di_data, int hasLoop)
         continue;
       }
 
-      /* don't need to bother checking real partitions  */
-      if (dinfo->sp_dev != 0 && dinfo->isLoopback) {
-        unsigned long         sp_dev;
-        unsigned long         sp_rdev;
+      /* don't need to bother checking real partitions  */
+      if (dinfo->sp_dev == 0 || ! dinfo->isLoopback) {
+        if (diopts->optval [DI_OPT_DEBUG] > 2) {
+          printf ("chk: dup: not checked: %s prnt: %d dev: %ld rdev: %ld %s\n",
+              dinfo->strdata [DI_DISP_MOUNTPT], dinfo->printFlag,
+              (long) dinfo->sp_dev, (long) dinfo->sp_rdev,
+              dinfo->strdata [DI_DISP_FSTYPE]);
+        }
+        continue;
+      }
+
+      if (diopts->optval [DI_OPT_DEBUG] > 2) {
+        printf ("dup: chk: i: %s dev: %ld rdev: %ld\n",
+            dinfo->strdata [DI_DISP_MOUNTPT], (long) dinfo->sp_dev,
+            (long) dinfo->sp_rdev);
+      }
+
+      slot = dupTableFind (table, tsize, dinfo->sp_dev, NULL);
+      j = slot->idx;
+      if (j == i) {
+        j = slot->idxb;
+      }
+      if (j >= 0) {
+        dupIgnore (di_data, dinfo, &di_data->diskInfo [j]);
+      }
+    }
+  }
+
+  free (table);
+}
+
+static void
+dupIgnore (di_data_t *di_data, di_disk_info_t *dinfo, di_disk_info_t *dinfob)
+{
+  di_opt_t        *diopts;
+
+  diopts = (di_opt_t *) di_data->options;
 
-        sp_dev = dinfo->sp_dev;
-        sp_rdev = dinfo->sp_rdev;
+  dinfo->printFlag = DI_PRNT_IGNORE;
+  dinfo->doPrint = diopts->optval [DI_OPT_DISP_ALL];
+  if (diopts->optval [DI_OPT_DEBUG] > 2) {
+    printf ("dup: chk: ignore: %s duplicate of %s\n",
+        dinfo->strdata [DI_DISP_MOUNTPT],
+        dinfob->strdata [DI_DISP_MOUNTPT]);
+    printf ("dup: j: dev: %ld rdev: %ld \n",
+        (long) dinfob->sp_dev, (long) dinfob->sp_rdev);
+  }
+}
 
-        if (diopts->optval [DI_OPT_DEBUG] > 2) {
-          printf ("dup: chk: i: %s dev: %ld rdev: %ld\n",
-              dinfo->strdata [DI_DISP_MOUNTPT], (long) sp_dev, (long) sp_rdev);
-        }
+static void
+dupTableInit (di_dup_slot_t *table, Size_t tsize)
+{
+  Size_t    h;
 
-        for (j = 0; j < di_data->fscount; ++j) {
-          di_disk_info_t        *dinfob;
+  for (h = 0; h < tsize; ++h) {
+    table [h].dev = 0;
+    table [h].root = NULL;
+    table [h].idx = -1;
+    table [h].idxb = -1;
+  }
+}
 
-          if (i == j) {
-            continue;
-          }
+/* returns the matching slot, or the empty slot to fill in */
+static di_dup_slot_t *
+dupTableFind (di_dup_slot_t *table, Size_t tsize,
+    unsigned long dev, const char *root)
+{
+  Size_t          h;
+  const char      *p;
+  di_dup_slot_t   *slot;
+
+  h = (Size_t) ((dev ^ (dev >> 20)) * 2654435761UL);
+  if (root != NULL) {
+    /* fnv-1a */
+    for (p = root; *p; ++p) {
+      h ^= (unsigned char) *p;
+      h *= 16777619UL;
+    }
+  }
 
-          dinfob = &di_data->diskInfo [j];
-          if (dinfob->sp_dev != 0 &&
-              dinfob->st_dev == sp_dev) {
-            if (diopts->optval [DI_OPT_DEBUG] > 2)
-            {
-              printf ("dup: for %s %ld: found: %s %ld\n",
-                  dinfo->strdata [DI_DISP_MOUNTPT], (long) sp_dev,
-                  dinfob->strdata [DI_DISP_MOUNTPT], (long) dinfob->st_dev);
-            }
-
-            dinfo->printFlag = DI_PRNT_IGNORE;
-            dinfo->doPrint = diopts->optval [DI_OPT_DISP_ALL];
-            if (diopts->optval [DI_OPT_DEBUG] > 2)
-            {
-              printf ("dup: chk: ignore: %s duplicate of %s\n",
-                  dinfo->strdata [DI_DISP_MOUNTPT],
-                  dinfob->strdata [DI_DISP_MOUNTPT]);
-              printf ("dup: j: dev: %ld rdev: %ld \n",
-                  (long) dinfob->sp_dev, (long) dinfob->sp_rdev);
-            }
-          } /* if dup */
-        }
-      } /* if this is a loopback, non-real */
-      else
-      {
-        if (diopts->optval [DI_OPT_DEBUG] > 2)
-        {
-          printf ("chk: dup: not checked: %s prnt: %d dev: %ld rdev: %ld %s\n",
-              dinfo->strdata [DI_DISP_MOUNTPT], dinfo->printFlag,
-              (long) dinfo->sp_dev, (long) dinfo->sp_rdev,
-              dinfo->strdata [DI_DISP_FSTYPE]);
-        }
-      }
-    } /* for each disk */
-  } /* if the duplicate loopback mounts are to be excluded */
+  h &= tsize - 1;
+  for (;;) {
+    slot = &table [h];
+    if (slot->idx < 0) {
+      return slot;
+    }
+    if (slot->dev == dev &&
+        ( (root == NULL && slot->root == NULL) ||
+        (root != NULL && slot->root != NULL && strcmp (root, slot->root) == 0))) {
+      return slot;
+    }
+    h = (h + 1) & (tsize - 1);
+  }
 }
 
+/* the quotas are checked for the entries in [start, end) */
 static void
-checkDiskQuotas (di_data_t *di_data)
+checkDiskQuotas (di_data_t *di_data, int start, int end)
 {
   int           i;
   int           j;
@@ -1088,13 +2247,16 @@ checkDiskQuotas (di_data_t *di_data)
     printf ("# QUOTA: %d:%s(%d) nfs:%d\n", _has_std_quotas, str, pos, _has_std_nfs_quotas);
   }
 
-  for (i = 0; i < di_data->fscount; ++i) {
+  for (i = start; i < end; ++i) {
     di_disk_info_t        *dinfo;
 
     dinfo = &di_data->diskInfo [i];
-    if (! dinfo->doPrint) {
+    if (! dinfo->doPrint || dinfo->printFlag == DI_PRNT_STALE) {
       continue;
     }
+    if (di_data->deadlineAt > 0 && di_probe_now () >= di_data->deadlineAt) {
+      break;
+    }
 
     diqinfo.filesystem = dinfo->strdata [DI_DISP_FILESYSTEM];
     diqinfo.mountpt = dinfo->strdata [DI_DISP_MOUNTPT];
@@ -1201,116 +2363,558 @@ checkDiskQuotas (di_data_t *di_data)
 static void
 preCheckDiskInfo (di_data_t *di_data)
 {
-  int           i;
-  di_opt_t      *diopts;
+  int           i;
+  di_opt_t      *diopts;
+
+  diopts = (di_opt_t *) di_data->options;
+
+  for (i = 0; i < di_data->fscount; ++i) {
+    di_disk_info_t        *dinfo;
+
+    dinfo = &di_data->diskInfo [i];
+
+    if (diopts->optval [DI_OPT_DEBUG] > 4) {
+      printf ("## prechk:%s:\n", dinfo->strdata [DI_DISP_MOUNTPT]);
+    }
+    checkZone (dinfo, (di_zone_info_t *) di_data->zoneInfo, diopts);
+    dinfo->pathFilter = di_filter_paths (di_data,
+        dinfo->strdata [DI_DISP_MOUNTPT]);
+
+    if (di_isPooledFs (dinfo)) {
+      di_data->haspooledfs = true;
+    }
+
+    if (dinfo->printFlag == DI_PRNT_OK) {
+      /* don't bother w/this check is all flag is set. */
+      if (! diopts->optval [DI_OPT_DISP_ALL]) {
+        di_is_remote_disk (dinfo);
+
+        if (dinfo->isLocal == false && diopts->optval [DI_OPT_LOCAL_ONLY]) {
+          dinfo->printFlag = DI_PRNT_IGNORE;
+          if (diopts->optval [DI_OPT_DEBUG] > 2) {
+            printf ("prechk: ignore: remote disk; local flag set: %s\n",
+                dinfo->strdata [DI_DISP_MOUNTPT]);
+          }
+        }
+      }
+    }
+
+    if (dinfo->printFlag == DI_PRNT_OK ||
+        dinfo->printFlag == DI_PRNT_IGNORE) {
+      /* do these checks to override the all flag */
+      checkFilters (di_data, dinfo);
+    }
+  } /* for all disks */
+}
+
+/*
+ * planCollection
+ *
+ * Decides what di_get_all_disk_info () collects, from the format
+ * string, the sort type, the totals, the --where predicate and the
+ * filters.
+ *
+ * The statvfs () values (and the quotas) are not needed if they are
+ * not displayed, sorted on, totalled or tested, and the entries that are
+ * displayed do not depend upon them.  That is the case if all of
+ * the entries are displayed, or if the include list selects them.
+ * Otherwise a partition with no space, or one that cannot be read,
+ * is not displayed.
+ *
+ * The mount options are only stored if they are displayed or used
+ * by the --where predicate.  The
+ * entries that are ignored by type are not probed, unless they
+ * are going to be displayed.  The entries removed by the -x, -I
+ * and -l filters are dropped as the mount table is read.
+ *
+ */
+
+static void
+planCollection (di_data_t *di_data)
+{
+  di_opt_t    *diopts;
+  di_plan_t   *plan;
+  int         fmt;
+  int         fmtvalues;
+
+  diopts = (di_opt_t *) di_data->options;
+  plan = &di_data->plan;
+
+  fmtvalues = false;
+  plan->options = false;
+  di_opt_format_iter_init (diopts);
+  while ( (fmt = di_opt_format_iterate (diopts)) != DI_FMT_ITER_STOP) {
+    switch (fmt) {
+      case DI_FMT_MOUNT_OPTIONS: {
+        plan->options = true;
+        break;
+      }
+      case DI_FMT_BTOT:
+      case DI_FMT_BTOT_AVAIL:
+      case DI_FMT_BUSED:
+      case DI_FMT_BCUSED:
+      case DI_FMT_BFREE:
+      case DI_FMT_BAVAIL:
+      case DI_FMT_BPERC_NAVAIL:
+      case DI_FMT_BPERC_USED:
+      case DI_FMT_BPERC_BSD:
+      case DI_FMT_BPERC_AVAIL:
+      case DI_FMT_BPERC_FREE:
+      case DI_FMT_ITOT:
+      case DI_FMT_IUSED:
+      case DI_FMT_IFREE:
+      case DI_FMT_IPERC: {
+        fmtvalues = true;
+        break;
+      }
+      default: {
+        break;
+      }
+    }
+  }
+  di_opt_format_iter_init (diopts);
+
+  plan->sortvalues = false;
+  if (strcmp (diopts->sortType, "n") != 0) {
+    plan->sortvalues = di_sort_uses_values (diopts->sortType);
+  }
+  plan->totsort = diopts->optval [DI_OPT_DISP_TOTALS];
+  plan->values = fmtvalues || plan->sortvalues || plan->totsort ||
+      diopts->where.usesValues;
+  if (diopts->where.usesOptions) {
+    plan->options = true;
+  }
+  /* the file arguments turn off the include list */
+  if (! diopts->optval [DI_OPT_DISP_ALL] &&
+      (! hasIncludeFilter (diopts) || hasFileArgs (diopts))) {
+    plan->values = true;
+  }
+  plan->preignore = ! diopts->optval [DI_OPT_DISP_ALL];
+
+  /* with -a the filtered entries are still displayed */
+  plan->filter = false;
+  if (! diopts->optval [DI_OPT_DISP_ALL] && ! hasFileArgs (diopts) &&
+      (hasIncludeFilter (diopts) ||
+      diopts->exclude_list.count > 0 ||
+      diopts->exclude_path_list.count > 0 ||
+      diopts->optval [DI_OPT_LOCAL_ONLY])) {
+    plan->filter = true;
+  }
+}
+
+/* everything is collected */
+static void
+planInit (di_plan_t *plan)
+{
+  plan->values = true;
+  plan->options = true;
+  plan->preignore = false;
+  plan->sortvalues = true;
+  plan->totsort = true;
+  plan->filter = false;
+}
+
+/* an entry without a file system type needs the statvfs () probe */
+static int
+planNeedsValues (di_data_t *di_data)
+{
+  di_disk_info_t  *dinfo;
+  int             i;
+
+  for (i = 0; i < di_data->fscount; ++i) {
+    dinfo = &di_data->diskInfo [i];
+    if ((dinfo->printFlag == DI_PRNT_OK ||
+        dinfo->printFlag == DI_PRNT_FORCE) &&
+        ! *dinfo->strdata [DI_DISP_FSTYPE]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* the loopback duplicate check looks for the mount a loopback is on */
+static int
+planHasLoopback (di_data_t *di_data)
+{
+  int             i;
+  int             fsclass;
+
+  for (i = 0; i < di_data->fscount; ++i) {
+    fsclass = di_data->diskInfo [i].fsClass;
+    if ((fsclass & DI_FSCLASS_LOFS) == DI_FSCLASS_LOFS ||
+        (fsclass & DI_FSCLASS_NULLFS) == DI_FSCLASS_NULLFS ||
+        (fsclass & DI_FSCLASS_NONE) == DI_FSCLASS_NONE) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * preIgnoreDiskInfo
+ *
+ * The checks from checkDiskInfo () that only look at the file system
+ * type and name are done before the statvfs () probe, so that the
+ * entries that will not be displayed are not probed.  Not done if
+ * the include list may turn the entries back on.
+ *
+ */
+
+static void
+preIgnoreDiskInfo (di_data_t *di_data)
+{
+  di_opt_t        *diopts;
+  di_disk_info_t  *dinfo;
+  int             i;
+
+  diopts = (di_opt_t *) di_data->options;
+  if (hasIncludeFilter (diopts)) {
+    return;
+  }
+
+  for (i = 0; i < di_data->fscount; ++i) {
+    dinfo = &di_data->diskInfo [i];
+    /* statvfs () may supply the file system type */
+    if (dinfo->printFlag != DI_PRNT_OK ||
+        ! *dinfo->strdata [DI_DISP_FSTYPE]) {
+      continue;
+    }
+    if ((dinfo->fsClass & DI_FSCLASS_IGNORE) == DI_FSCLASS_IGNORE ||
+        isIgnoreFilesystem (dinfo->strdata [DI_DISP_FILESYSTEM]) ||
+        isIgnoreFS (dinfo)) {
+      dinfo->printFlag = DI_PRNT_IGNORE;
+      if (diopts->optval [DI_OPT_DEBUG] > 2) {
+        printf ("plan: ignore: %s\n", dinfo->strdata [DI_DISP_MOUNTPT]);
+      }
+    }
+  }
+}
+
+/*
+ * checkWhere
+ *
+ * Applies the --where predicate to all of the entries once the
+ * values are final, so that it also applies with -a.  The rejected
+ * entries are not formatted, and are not part of the --top
+ * selection or the totals.  The print flag is not changed, so that
+ * the predicate can be tested again by di_refresh_disk_info ().
+ *
+ */
+
+static void
+checkWhere (di_data_t *di_data)
+{
+  di_opt_t        *diopts;
+  di_disk_info_t  *dinfo;
+  int             i;
+
+  diopts = (di_opt_t *) di_data->options;
+  init_scale_values (di_data, diopts);
+
+  for (i = 0; i < di_data->fscount; ++i) {
+    dinfo = &di_data->diskInfo [i];
+    if (! whereEval (di_data, &diopts->where, i)) {
+      dinfo->whereHidden = true;
+      ++di_data->wherehidden;
+      if (diopts->optval [DI_OPT_DEBUG] > 2) {
+        printf ("where: exclude: %s\n", dinfo->strdata [DI_DISP_MOUNTPT]);
+      }
+    }
+  }
+}
+
+static int
+whereEval (di_data_t *di_data, const di_where_t *where, int idx)
+{
+  const di_where_ins_t  *ins;
+  di_disk_info_t        *dinfo;
+  dinum_t               val;
+  double                stack [DI_WHERE_STACK_MAX + 1];
+  int                   sp;
+  int                   pc;
+
+  dinfo = &di_data->diskInfo [idx];
+  sp = 0;
+  pc = 0;
+  while (pc < where->count) {
+    ins = &where->code [pc];
+    ++pc;
+    switch (ins->op) {
+      case DI_WHERE_NUM: {
+        stack [sp++] = ins->num;
+        break;
+      }
+      case DI_WHERE_SPACE: {
+        dinum_init (&val);
+        di_calc_space (di_data, idx, ins->arg [0], ins->arg [1], ins->arg [2], &val);
+        stack [sp++] = dinum_scale (&val, &di_data->scale_values [DI_SCALE_BYTE]);
+        dinum_clear (&val);
+        break;
+      }
+      case DI_WHERE_PERC: {
+        stack [sp++] = di_calc_perc (di_data, idx, ins->arg [0], ins->arg [1],
+            ins->arg [2], ins->arg [3], ins->arg [4]);
+        break;
+      }
+      case DI_WHERE_FLAG: {
+        if (ins->arg [0] == DI_WHERE_FLAG_LOCAL) {
+          di_is_remote_disk (dinfo);
+          stack [sp++] = dinfo->isLocal;
+        } else if (ins->arg [0] == DI_WHERE_FLAG_READONLY) {
+          stack [sp++] = dinfo->isReadOnly;
+        } else {
+          stack [sp++] = dinfo->isLoopback;
+        }
+        break;
+      }
+      case DI_WHERE_STREQ: {
+        stack [sp++] = strcmp (dinfo->strdata [ins->arg [0]], ins->str) == 0;
+        break;
+      }
+      case DI_WHERE_STRNE: {
+        stack [sp++] = strcmp (dinfo->strdata [ins->arg [0]], ins->str) != 0;
+        break;
+      }
+      case DI_WHERE_GLOB: {
+        stack [sp++] = di_opt_glob_match (ins->str, dinfo->strdata [ins->arg [0]]);
+        break;
+      }
+      case DI_WHERE_NGLOB: {
+        stack [sp++] = ! di_opt_glob_match (ins->str, dinfo->strdata [ins->arg [0]]);
+        break;
+      }
+      case DI_WHERE_LT: {
+        --sp;
+        stack [sp - 1] = stack [sp - 1] < stack [sp];
+        break;
+      }
+      case DI_WHERE_LE: {
+        --sp;
+        stack [sp - 1] = stack [sp - 1] <= stack [sp];
+        break;
+      }
+      case DI_WHERE_GT: {
+        --sp;
+        stack [sp - 1] = stack [sp - 1] > stack [sp];
+        break;
+      }
+      case DI_WHERE_GE: {
+        --sp;
+        stack [sp - 1] = stack [sp - 1] >= stack [sp];
+        break;
+      }
+      case DI_WHERE_EQ: {
+        --sp;
+        stack [sp - 1] = stack [sp - 1] == stack [sp];
+        break;
+      }
+      case DI_WHERE_NE: {
+        --sp;
+        stack [sp - 1] = stack [sp - 1] != stack [sp];
+        break;
+      }
+      case DI_WHERE_NOT: {
+        stack [sp - 1] = stack [sp - 1] == 0.0;
+        break;
+      }
+      /* the short circuit operators keep the result if they jump */
+      case DI_WHERE_JFALSE: {
+        if (stack [sp - 1] == 0.0) {
+          pc = ins->arg [0];
+        } else {
+          --sp;
+        }
+        break;
+      }
+      case DI_WHERE_JTRUE: {
+        if (stack [sp - 1] != 0.0) {
+          pc = ins->arg [0];
+        } else {
+          --sp;
+        }
+        break;
+      }
+      default: {
+        break;
+      }
+    }
+  }
+
+  return sp > 0 && stack [sp - 1] != 0.0;
+}
+
+/*
+ * pathMountEntry
+ *
+ * di_get_path_info (): the only entry is the mount the path is on.
+ * Returns -1 if statmount () is not available.
+ *
+ */
+
+static int
+pathMountEntry (di_data_t *di_data, const di_path_stat_t *ps)
+{
+  di_opt_t        *diopts;
+  di_disk_info_t  *dinfo;
+
+  diopts = (di_opt_t *) di_data->options;
+
+  resetDiskInfo (di_data);
+  di_data->pathmode = DI_PATHMODE_NONE;
+  di_data->zoneInfo = di_initialize_zones (diopts);
+  if (di_disk_info_reserve (di_data, 1) < 0) {
+    return -1;
+  }
+
+  dinfo = &di_data->diskInfo [0];
+  di_initialize_disk_info_arena (dinfo, 0);
+  if (di_get_mount_entry (di_data, dinfo, ps->mntId) != 0) {
+    /* the entry is released by the next reset */
+    return -1;
+  }
+  if (diopts->optval [DI_OPT_DEBUG] > 0) {
+    printf ("# di_get_path_info: statmount %llu\n",
+        (unsigned long long) ps->mntId);
+  }
+  di_data->fscount = 1;
+  di_data->dispcount = 1;
+  di_initialize_disk_info_arena (&di_data->diskInfo [1], 1);
+  di_data->diskInfo [1].doPrint = 0;
+  di_data->diskInfo [1].printFlag = DI_PRNT_SKIP;
+  preCheckDiskInfo (di_data);
+  di_data->pathmode = DI_PATHMODE_SINGLE;
+  return 0;
+}
+
+/*
+ * pathMountTable
+ *
+ * di_get_path_info (): read the full mount table.
+ * The disk space is not fetched.
+ *
+ */
+
+static int
+pathMountTable (di_data_t *di_data)
+{
+  di_opt_t        *diopts;
+  int             count;
 
   diopts = (di_opt_t *) di_data->options;
 
-  for (i = 0; i < di_data->fscount; ++i) {
-    di_disk_info_t        *dinfo;
+  if (diopts->optval [DI_OPT_DEBUG] > 0) {
+    printf ("# di_get_path_info: mount table\n");
+  }
+  resetDiskInfo (di_data);
+  di_data->pathmode = DI_PATHMODE_NONE;
+  di_data->zoneInfo = di_initialize_zones (diopts);
 
-    dinfo = &di_data->diskInfo [i];
+  if (di_get_disk_entries (di_data, &di_data->fscount) < 0) {
+    return -1;
+  }
+  di_compact_disk_info (di_data);
+  count = di_data->fscount;
+  if (di_disk_info_reserve (di_data, count) < 0) {
+    return -1;
+  }
+  di_initialize_disk_info_arena (&di_data->diskInfo [count], count);
+  di_data->diskInfo [count].doPrint = 0;
+  di_data->diskInfo [count].printFlag = DI_PRNT_SKIP;
+  di_data->dispcount = count;
 
-    if (diopts->optval [DI_OPT_DEBUG] > 4) {
-      printf ("## prechk:%s:\n", dinfo->strdata [DI_DISP_MOUNTPT]);
-    }
-    checkZone (dinfo, (di_zone_info_t *) di_data->zoneInfo, diopts);
+  preCheckDiskInfo (di_data);
+  /* the device numbers are only needed without the mount ids */
+  getDiskStatInfo (di_data);
+  di_data->pathmode = DI_PATHMODE_TABLE;
+  return 0;
+}
 
-    if (di_isPooledFs (dinfo)) {
-      di_data->haspooledfs = true;
-    }
+static int
+pathFindEntry (di_data_t *di_data, const di_path_stat_t *ps)
+{
+  di_disk_info_t  *dinfo;
+  int             idx;
 
-    if (dinfo->printFlag == DI_PRNT_OK) {
-      /* don't bother w/this check is all flag is set. */
-      if (! diopts->optval [DI_OPT_DISP_ALL]) {
-        di_is_remote_disk (dinfo);
+  idx = di_mntid_index_find (di_data, ps->mntId, ps->mntIdType);
+  if (idx >= 0) {
+    return idx;
+  }
 
-        if (dinfo->isLocal == false && diopts->optval [DI_OPT_LOCAL_ONLY]) {
-          dinfo->printFlag = DI_PRNT_IGNORE;
-          if (diopts->optval [DI_OPT_DEBUG] > 2) {
-            printf ("prechk: ignore: remote disk; local flag set: %s\n",
-                dinfo->strdata [DI_DISP_MOUNTPT]);
-          }
-        }
-      }
+  /* the last mount of the device is the one that is visible */
+  for (idx = di_data->fscount - 1; idx >= 0; --idx) {
+    dinfo = &di_data->diskInfo [idx];
+    if (dinfo->hasStDev && dinfo->st_dev == ps->st_dev) {
+      return idx;
     }
+  }
+  return -1;
+}
 
-    if (dinfo->printFlag == DI_PRNT_OK ||
-        dinfo->printFlag == DI_PRNT_IGNORE) {
-      /* do these checks to override the all flag */
-      checkExcludeList (di_data, dinfo, &diopts->exclude_list);
-      checkIncludeList (di_data, dinfo, &diopts->include_list);
-    }
-  } /* for all disks */
+static void
+setPubInfo (di_pub_disk_info_t *pub, const di_disk_info_t *dinfo, int idx)
+{
+  int     i;
+
+  pub->index = idx;
+  for (i = 0; i < DI_DISP_MAX; ++i) {
+    pub->strdata [i] = dinfo->strdata [i];
+  }
+  pub->doPrint = dinfo->doPrint;
+  pub->printFlag = dinfo->printFlag;
+  pub->isLocal = dinfo->isLocal;
+  pub->isReadOnly = dinfo->isReadOnly;
+  pub->isLoopback = dinfo->isLoopback;
 }
 
+/*
+ * The exclude and include lists are checked together.  The type lists
+ * have already been checked for this file system type, and the path
+ * lists for this mount point.
+ */
 static void
-checkExcludeList (di_data_t *di_data, di_disk_info_t *dinfo, di_strarr_t *exclude_list)
+checkFilters (di_data_t *di_data, di_disk_info_t *dinfo)
 {
-  char          *ptr;
-  Size_t        i;
   di_opt_t      *diopts;
+  int           match;
 
   diopts = (di_opt_t *) di_data->options;
+  match = di_filter_match (di_data, dinfo->fsClass, dinfo->pathFilter);
 
-  /* if the file system type is in the ignore list, skip it */
-  if (exclude_list->count > 0) {
-    for (i = 0; i < exclude_list->count; ++i) {
-      ptr = exclude_list->list [i];
-      if (diopts->optval [DI_OPT_DEBUG] > 2) {
-        printf ("chkign: test: fstype %s/%s : %s\n", ptr,
-            dinfo->strdata [DI_DISP_FSTYPE], dinfo->strdata [DI_DISP_MOUNTPT]);
-      }
-      if (strcmp (ptr, dinfo->strdata [DI_DISP_FSTYPE]) == 0 ||
-          (strcmp (ptr, "fuse") == 0 &&
-          strncmp ("fuse", dinfo->strdata [DI_DISP_FSTYPE], (Size_t) 4) == 0)) {
-        dinfo->printFlag = DI_PRNT_EXCLUDE;
-        dinfo->doPrint = false;
-        if (diopts->optval [DI_OPT_DEBUG] > 2) {
-          printf ("chkign: ignore: fstype %s match: %s\n", ptr,
-              dinfo->strdata [DI_DISP_MOUNTPT]);
-        }
-        break;
-      }
+  /* if the file system is in the exclude lists, skip it */
+  if ((match & DI_FILTER_EXCLUDE) == DI_FILTER_EXCLUDE) {
+    dinfo->printFlag = DI_PRNT_EXCLUDE;
+    dinfo->doPrint = false;
+    if (diopts->optval [DI_OPT_DEBUG] > 2) {
+      printf ("chkign: ignore: fstype %s match: %s\n",
+          dinfo->strdata [DI_DISP_FSTYPE], dinfo->strdata [DI_DISP_MOUNTPT]);
     }
-  } /* if an ignore list was specified */
+  }
+
+  checkIncludeFilter (di_data, dinfo, match);
 }
 
 static void
-checkIncludeList (di_data_t *di_data, di_disk_info_t *dinfo, di_strarr_t *include_list)
+checkIncludeFilter (di_data_t *di_data, di_disk_info_t *dinfo, int match)
 {
-  char          *ptr;
-  Size_t        i;
   di_opt_t      *diopts;
 
   diopts = (di_opt_t *) di_data->options;
 
-  /* if the file system type is not in the include list, skip it */
-  if (include_list->count > 0) {
-    for (i = 0; i < include_list->count; ++i) {
-      ptr = include_list->list [i];
+  /* if the file system is not in the include lists, skip it */
+  if ((match & DI_FILTER_INCLIST) == DI_FILTER_INCLIST) {
+    if ((match & DI_FILTER_INCLUDE) == DI_FILTER_INCLUDE) {
+      dinfo->printFlag = DI_PRNT_OK;
+      dinfo->doPrint = true;
       if (diopts->optval [DI_OPT_DEBUG] > 2) {
-        printf ("chkinc: test: fstype %s/%s : %s\n", ptr,
+        printf ("chkinc:include:fstype %s match: %s\n",
             dinfo->strdata [DI_DISP_FSTYPE], dinfo->strdata [DI_DISP_MOUNTPT]);
       }
-
-      if (strcmp (ptr, dinfo->strdata [DI_DISP_FSTYPE]) == 0 ||
-          (strcmp (ptr, "fuse") == 0 &&
-          strncmp ("fuse", dinfo->strdata [DI_DISP_FSTYPE], (Size_t) 4) == 0)) {
-        dinfo->printFlag = DI_PRNT_OK;
-        dinfo->doPrint = true;
-        if (diopts->optval [DI_OPT_DEBUG] > 2) {
-          printf ("chkinc:include:fstype %s match: %s\n", ptr,
-              dinfo->strdata [DI_DISP_MOUNTPT]);
-        }
-        break;
-      } else {
-        dinfo->printFlag = DI_PRNT_EXCLUDE;
-        dinfo->doPrint = false;
-        if (diopts->optval [DI_OPT_DEBUG] > 2) {
-          printf ("chkinc:!include:fstype %s no match: %s\n", ptr,
-              dinfo->strdata [DI_DISP_MOUNTPT]);
-        }
+    } else {
+      dinfo->printFlag = DI_PRNT_EXCLUDE;
+      dinfo->doPrint = false;
+      if (diopts->optval [DI_OPT_DEBUG] > 2) {
+        printf ("chkinc:!include:fstype %s no match: %s\n",
+            dinfo->strdata [DI_DISP_FSTYPE], dinfo->strdata [DI_DISP_MOUNTPT]);
       }
     }
   } /* if an include list was specified */
@@ -1320,8 +2924,7 @@ static void
 checkZone (di_disk_info_t *dinfo, di_zone_info_t *zoneInfo, di_opt_t *diopts)
 {
 #if _lib_zone_list && _lib_getzoneid && _lib_zone_getattr
-  int         i;
-  int         idx = -1;
+  int         idx;
 
   if (zoneInfo == NULL) {
     return;
@@ -1332,26 +2935,16 @@ checkZone (di_disk_info_t *dinfo, di_zone_info_t *zoneInfo, di_opt_t *diopts)
     return;
   }
 
-  for (i = 0; i < (int) zoneInfo->zoneCount; ++i) {
-    /* find the zone the filesystem is in, if non-global */
-    if (diopts->optval [DI_OPT_DEBUG] > 5) {
-      printf (" checkZone:%s:compare:%d:%s:\n",
-          dinfo->strdata [DI_DISP_MOUNTPT],
-          (int) zoneInfo->zones [i].rootpathlen,
-          zoneInfo->zones [i].rootpath);
-    }
-    if (strncmp (zoneInfo->zones [i].rootpath,
-        dinfo->strdata [DI_DISP_MOUNTPT], zoneInfo->zones [i].rootpathlen) == 0) {
-      if (diopts->optval [DI_OPT_DEBUG] > 4) {
-          printf (" checkZone:%s:found zone:%s:\n",
-                  dinfo->strdata [DI_DISP_MOUNTPT], zoneInfo->zones [i].name);
-      }
-      idx = i;
-      break;
-    }
-    if (idx == -1) {
-      idx = zoneInfo->globalIdx;
+  /* find the zone the filesystem is in, if non-global */
+  /* the zone with the longest root path is used         */
+  idx = di_trie_find (&zoneInfo->trie, dinfo->strdata [DI_DISP_MOUNTPT]);
+  if (idx >= 0) {
+    if (diopts->optval [DI_OPT_DEBUG] > 4) {
+        printf (" checkZone:%s:found zone:%s:\n",
+                dinfo->strdata [DI_DISP_MOUNTPT], zoneInfo->zones [idx].name);
     }
+  } else {
+    idx = zoneInfo->globalIdx;
   }
 
   /* no root access, ignore any zones     */
@@ -1420,37 +3013,58 @@ isIgnoreFilesystem (const char *filesystem)
 }
 
 static int
-isIgnoreFS (const char *fstype, const char *name)
+isIgnoreFS (const di_disk_info_t *dinfo)
 {
   static const char   *applesystem = "/System/";
 
-  if (strcmp (fstype, "apfs") == 0 &&
-       strncmp (name, applesystem, strlen (applesystem)) == 0) {
+  if ((dinfo->fsClass & DI_FSCLASS_APFS) == DI_FSCLASS_APFS &&
+       strncmp (dinfo->strdata [DI_DISP_MOUNTPT], applesystem,
+       strlen (applesystem)) == 0) {
     return true;
   }
   return false;
 }
 
+/*
+ * hasTableDev
+ *
+ * The linux mount table has the device number of each mount.
+ * A btrfs subvolume has its own anonymous device number, which
+ * is only available from stat ().
+ *
+ */
+
+static int
+hasTableDev (const di_disk_info_t *dinfo)
+{
+  if (! dinfo->hasMntDev) {
+    return false;
+  }
+  if ((dinfo->fsClass & DI_FSCLASS_BTRFS) == DI_FSCLASS_BTRFS) {
+    return false;
+  }
+  return true;
+}
+
+/* with -l, a network mount is not touched, as it may hang,  */
+/* unless it is in the include lists                          */
 static int
-isIgnoreFSType (const char *fstype)
-{
-  /* solaris: swap */
-  /* linux: devtmpfs, cgroup, tmpfs, squashfs, overlay, efivarfs */
-  if (strcmp (fstype, "rootfs") == 0 ||
-      strcmp (fstype, "procfs") == 0 ||
-      strcmp (fstype, "ptyfs") == 0 ||
-      strcmp (fstype, "kernfs") == 0 ||
-      strcmp (fstype, "devfs") == 0 ||
-      strcmp (fstype, "tmpfs") == 0 ||
-      strcmp (fstype, "swap") == 0 ||
-      strcmp (fstype, "cgroup") == 0 ||
-      strcmp (fstype, "squashfs") == 0 ||
-      strcmp (fstype, "overlay") == 0 ||
-      strcmp (fstype, "efivarfs") == 0 ||
-      strcmp (fstype, "devtmpfs") == 0) {
-    return true;
+isRemoteSkipped (di_data_t *di_data, const di_disk_info_t *dinfo)
+{
+  di_opt_t    *diopts;
+  int         match;
+
+  diopts = (di_opt_t *) di_data->options;
+  if (! diopts->optval [DI_OPT_LOCAL_ONLY] ||
+      diopts->optval [DI_OPT_DISP_ALL] ||
+      (dinfo->fsClass & DI_FSCLASS_REMOTE) != DI_FSCLASS_REMOTE) {
+    return false;
   }
-  return false;
+  match = di_filter_match (di_data, dinfo->fsClass, dinfo->pathFilter);
+  if ((match & DI_FILTER_INCLUDE) == DI_FILTER_INCLUDE) {
+    return false;
+  }
+  return true;
 }
 
 static int
@@ -1496,131 +3110,24 @@ getPrintFlagText (int pf)
       pf == DI_PRNT_EXCLUDE ? "exclude" :
       pf == DI_PRNT_OUTOFZONE ? "outofzone" :
       pf == DI_PRNT_FORCE ? "force" :
-      pf == DI_PRNT_SKIP ? "skip" : "unknown";
-}
-
-static void
-di_sort_disk_info (di_opt_t *diopts, di_disk_info_t *data, int count,
-    const char *sortType, int sidx)
-{
-  int     tempIndex;
-  int     gap;
-  int     j;
-  int     i;
-
-  if (count <= 1) {
-    return;
-  }
-
-  gap = 1;
-  while (gap < count) {
-    gap = 3 * gap + 1;
-  }
-
-  for (gap /= 3; gap > 0; gap /= 3) {
-    for (i = gap; i < count; ++i) {
-      tempIndex = data [i].sortIndex [sidx];
-      j = i - gap;
-
-      while (j >= 0 && di_sort_compare (diopts, sortType, data, data [j].sortIndex [sidx], tempIndex) > 0) {
-        data [j + gap].sortIndex [sidx] = data [j].sortIndex [sidx];
-        j -= gap;
-      }
-
-      j += gap;
-      if (j != i) {
-        data [j].sortIndex [sidx] = tempIndex;
-      }
-    }
-  }
+      pf == DI_PRNT_SKIP ? "skip" :
+      pf == DI_PRNT_TIMEOUT ? "timeout" :
+      pf == DI_PRNT_STALE ? "stale" : "unknown";
 }
 
 static int
-di_sort_compare (const di_opt_t *diopts, const char *sortType,
-    const di_disk_info_t *data, int idx1, int idx2)
+isShown (const di_data_t *di_data, int idx)
 {
-  int                   rc;
-  int                   sortOrder;
-  const char            *ptr;
-  const di_disk_info_t  *d1;
-  const di_disk_info_t  *d2;
-
-  /* reset sort order to the default start value */
-  sortOrder = DI_SORT_OPT_ASCENDING;
-  rc = 0;
-
-  d1 = & (data [idx1]);
-  d2 = & (data [idx2]);
-
-  ptr = sortType;
-  while (*ptr) {
-    switch (*ptr) {
-      case DI_SORT_OPT_NONE: {
-          break;
-      }
-
-      case DI_SORT_OPT_MOUNT: {
-          rc = strcoll (d1->strdata [DI_DISP_MOUNTPT], d2->strdata [DI_DISP_MOUNTPT]);
-          rc *= sortOrder;
-          break;
-      }
-
-      case DI_SORT_OPT_REVERSE: {
-          sortOrder *= -1;
-          break;
-      }
-
-      case DI_SORT_OPT_FILESYSTEM: {
-          rc = strcoll (d1->strdata [DI_DISP_FILESYSTEM], d2->strdata [DI_DISP_FILESYSTEM]);
-          rc *= sortOrder;
-          break;
-      }
-
-      case DI_SORT_OPT_TYPE: {
-          rc = strcoll (d1->strdata [DI_DISP_FSTYPE], d2->strdata [DI_DISP_FSTYPE]);
-          rc *= sortOrder;
-          break;
-      }
-
-      case DI_SORT_OPT_AVAIL:
-      case DI_SORT_OPT_FREE:
-      case DI_SORT_OPT_TOTAL: {
-        switch (*ptr) {
-          case DI_SORT_OPT_AVAIL: {
-            rc = dinum_cmp (&d1->values [DI_SPACE_AVAIL], &d2->values [DI_SPACE_AVAIL]);
-            break;
-          }
-          case DI_SORT_OPT_FREE: {
-            rc = dinum_cmp (&d1->values [DI_SPACE_FREE], &d2->values [DI_SPACE_FREE]);
-            break;
-          }
-          case DI_SORT_OPT_TOTAL: {
-            rc = dinum_cmp (&d1->values [DI_SPACE_TOTAL], &d2->values [DI_SPACE_TOTAL]);
-            break;
-          }
-          default: {
-            break;
-          }
-        }
-
-        rc *= sortOrder;
-        break;
-      }
-
-      default: {
-        break;
-      }
-    } /* switch on sort type */
-
-    if (rc != 0)
-    {
-      return rc;
-    }
-
-    ++ptr;
+  if (di_data->iteropt != DI_ITER_PRINTABLE) {
+    return ! di_data->diskInfo [idx].topHidden &&
+        ! di_data->diskInfo [idx].whereHidden;
   }
-
-  return rc;
+  if (di_data->columns.valid) {
+    return DI_BIT_TEST (di_data->columns.printable, idx);
+  }
+  return di_data->diskInfo [idx].doPrint &&
+      ! di_data->diskInfo [idx].topHidden &&
+      ! di_data->diskInfo [idx].whereHidden;
 }
 
 static void
@@ -1639,9 +3146,15 @@ init_scale_values (di_data_t *di_data, di_opt_t *diopts)
   dinum_init (&base);
   dinum_set_u (&base, (di_ui_t) diopts->blockSize);
   dinum_set_u (&di_data->scale_values [DI_SCALE_BYTE], (di_ui_t) 1);
+  di_data->scale_values_u [DI_SCALE_BYTE] = 1;
+  di_data->scale_values_ulim = DI_SCALE_MAX;
   for (i = DI_SCALE_KILO; i < DI_SCALE_MAX; ++i) {
     dinum_set (&di_data->scale_values [i], &base);
     dinum_mul (&di_data->scale_values [i], &di_data->scale_values [i - 1]);
+    if (di_data->scale_values_ulim == DI_SCALE_MAX &&
+        ! dinum_get_u (&di_data->scale_values [i], &di_data->scale_values_u [i])) {
+      di_data->scale_values_ulim = i;
+    }
   }
 
   di_data->scale_values_init = 1;
@@ -1675,6 +3188,43 @@ di_calc_space (di_data_t *di_data, int infoidx,
   dinum_clear (&sub);
 }
 
+/* di_calc_space () using the columns.  returns false if the  */
+/* values are not exact or the result would be negative        */
+static int
+di_calc_space_u (di_data_t *di_data, int infoidx,
+    int validxA, int validxB, int validxC, di_ui_t *val)
+{
+  di_columns_t    *cols;
+  di_ui_t         sub;
+
+  cols = &di_data->columns;
+  if (! cols->valid || infoidx >= cols->count ||
+      ! DI_BIT_TEST (cols->exact, infoidx)) {
+    return false;
+  }
+
+  *val = cols->values [validxA][infoidx];
+  if (*val == 0) {
+    return true;
+  }
+
+  sub = 0;
+  if (validxB != DI_VALUE_NONE) {
+    sub = cols->values [validxB][infoidx];
+  }
+  if (validxB != DI_VALUE_NONE && validxC != DI_VALUE_NONE) {
+    if (cols->values [validxC][infoidx] > sub) {
+      return false;
+    }
+    sub -= cols->values [validxC][infoidx];
+  }
+  if (sub > *val) {
+    return false;
+  }
+  *val -= sub;
+  return true;
+}
+
 static double
 di_calc_perc (di_data_t *di_data, int infoidx,
     int validxA, int validxB, int validxC, int validxD, int validxE)
@@ -1740,6 +3290,11 @@ processTotals (di_data_t *di_data)
   totals->doPrint = 1;
   totals->printFlag = DI_PRNT_OK;
 
+  if (processTotalsColumns (di_data)) {
+    di_columns_set_row (di_data, di_data->fscount);
+    return;
+  }
+
   for (i = 0; i < di_data->fscount; ++i) {
     di_disk_info_t  *dinfo;
     int             sortidx;
@@ -1758,7 +3313,7 @@ processTotals (di_data_t *di_data)
         lastpoollen = di_mungePoolName (lastpool);
         inpool = false;
         startpool = true;
-        if (strcmp (dinfo->strdata [DI_DISP_FSTYPE], "null") == 0 &&
+        if ((dinfo->fsClass & DI_FSCLASS_NULL) == DI_FSCLASS_NULL &&
             strcmp (dinfo->strdata [DI_DISP_FILESYSTEM] + strlen (dinfo->strdata [DI_DISP_FILESYSTEM]) - 5, "00000") != 0) {
           /* dragonflybsd doesn't have the main pool mounted */
           inpool = true;
@@ -1768,7 +3323,7 @@ processTotals (di_data_t *di_data)
       inpool = false;
     }
 
-    if (dinfo->doPrint) {
+    if (dinfo->doPrint && ! dinfo->topHidden && ! dinfo->whereHidden) {
       addTotals (di_data, dinfo, totals, inpool);
     } else {
       if (diopts->optval [DI_OPT_DEBUG] > 2) {
@@ -1780,6 +3335,64 @@ processTotals (di_data_t *di_data)
       inpool = true;
     }
   } /* for each entry */
+
+  di_columns_set_row (di_data, di_data->fscount);
+}
+
+/* With no pooled filesystems, the totals are the sums of the   */
+/* columns over the printable entries.  Returns false if the    */
+/* columns cannot be used, and nothing has been added.          */
+static int
+processTotalsColumns (di_data_t *di_data)
+{
+  di_columns_t    *cols;
+  di_disk_info_t  *totals;
+  di_opt_t        *diopts;
+  di_ui_t         sums [DI_VALUE_MAX];
+  di_ui_t         v;
+  int             i;
+  int             j;
+
+  diopts = (di_opt_t *) di_data->options;
+  cols = &di_data->columns;
+  if (! cols->valid || di_data->haspooledfs ||
+      diopts->optval [DI_OPT_DEBUG] > 2) {
+    return false;
+  }
+
+  totals = &di_data->diskInfo [di_data->fscount];
+  for (j = 0; j < DI_VALUE_MAX; ++j) {
+    if (! dinum_get_u (&totals->values [j], &sums [j])) {
+      return false;
+    }
+  }
+
+  for (i = 0; i < di_data->fscount; ++i) {
+    if (! DI_BIT_TEST (cols->printable, i)) {
+      continue;
+    }
+    if (! DI_BIT_TEST (cols->exact, i)) {
+      return false;
+    }
+  }
+
+  for (j = 0; j < DI_VALUE_MAX; ++j) {
+    for (i = 0; i < di_data->fscount; ++i) {
+      if (! DI_BIT_TEST (cols->printable, i)) {
+        continue;
+      }
+      v = cols->values [j][i];
+      if (sums [j] + v < sums [j]) {
+        return false;
+      }
+      sums [j] += v;
+    }
+  }
+
+  for (j = 0; j < DI_VALUE_MAX; ++j) {
+    dinum_set_u (&totals->values [j], sums [j]);
+  }
+  return true;
 }
 
 static void
@@ -1845,7 +3458,7 @@ addTotals (di_data_t *di_data, const di_disk_info_t *dinfo,
     if (diopts->optval [DI_OPT_DEBUG] > 2) {
       printf ("  tot:inpool:\n");
     }
-    if (strcmp (dinfo->strdata [DI_DISP_FSTYPE], "apfs") == 0) {
+    if ((dinfo->fsClass & DI_FSCLASS_APFS) == DI_FSCLASS_APFS) {
       dinum_t   tval;
 
       dinum_init (&tval);
@@ -1877,3 +3490,199 @@ addTotals (di_data_t *di_data, const di_disk_info_t *dinfo,
   }
 }
 
+
+#if defined (TEST_DILIB)
+
+typedef struct
+{
+  const char      *fstype;
+  unsigned long   dev;
+  const char      *root;
+  int             dup;
+} dilib_dup_test_t;
+
+/* in mount table order */
+static const dilib_dup_test_t dupTests [] =
+{
+  /* a bind mount of a directory, and a second mount of the same root */
+  { "ext4",   1,  "/",          false },
+  { "ext4",   1,  "/home/a",    true },
+  { "ext4",   1,  "/",          true },
+  { "ext4",   3,  "/srv",       false },
+  { "ext4",   3,  "/srv/www/a", true },
+  /* the btrfs top level subvolume and the subvolumes share the device */
+  { "btrfs",  2,  "/",          false },
+  { "btrfs",  2,  "/@home",     false },
+  { "btrfs",  2,  "/@var/log",  false },
+  { "btrfs",  2,  "/@home",     true },
+};
+
+#define DILIB_DUP_TEST_COUNT \
+    ((int) (sizeof (dupTests) / sizeof (dilib_dup_test_t)))
+
+typedef struct
+{
+  const char      *opta;
+  const char      *arga;
+  const char      *optb;
+  const char      *argb;
+  const char      *fstype;
+  const char      *mountpt;
+  int             excluded;
+} dilib_filter_test_t;
+
+static const dilib_filter_test_t filterTests [] =
+{
+  /* --exclude-path wins over the include lists */
+  { "-I", "ext4", "--exclude-path", "/", "ext4", "/", true },
+  { "-I", "ext4", "--exclude-path", "/", "ext4", "/home", false },
+  { "-I", "ext4", "--exclude-path", "/", "xfs", "/home", true },
+  { "--include-path", "/sys/*,/tmp/*", "--exclude-path", "/tmp/*",
+      "tmpfs", "/tmp/mx", true },
+  { "--include-path", "/sys/*,/tmp/*", "--exclude-path", "/tmp/*",
+      "sysfs", "/sys/kernel", false },
+  { "--include-path", "/var/*", "--exclude-path", "/var/lib/kubelet/pods/*",
+      "tmpfs", "/var/lib/kubelet/pods/a/volumes", true },
+  { "--include-path", "/var/*", "--exclude-path", "/var/lib/kubelet/pods/*",
+      "ext4", "/var/lib/docker", false },
+  /* the include lists override -x */
+  { "-I", "ext4", "-x", "ext4", "ext4", "/", false },
+  { "--include-path", "/", "-x", "ext4", "ext4", "/", false },
+  { "--include-path", "/", "-x", "ext4", "ext4", "/home", true },
+};
+
+#define DILIB_FILTER_TEST_COUNT \
+    ((int) (sizeof (filterTests) / sizeof (dilib_filter_test_t)))
+
+int
+main (int argc, char * argv [])
+{
+  di_data_t       *di_data;
+  di_disk_info_t  *dinfo;
+  char            tbuff [40];
+  int             i;
+  int             grc = 0;
+  int             testno = 0;
+
+  di_data = (di_data_t *) di_initialize ();
+  if (di_disk_info_reserve (di_data, DILIB_DUP_TEST_COUNT) < 0) {
+    return 1;
+  }
+  for (i = 0; i <= DILIB_DUP_TEST_COUNT; ++i) {
+    di_initialize_disk_info_arena (&di_data->diskInfo [i], i);
+  }
+  for (i = 0; i < DILIB_DUP_TEST_COUNT; ++i) {
+    dinfo = &di_data->diskInfo [i];
+    Snprintf1 (tbuff, sizeof (tbuff), "/mnt/%d", i);
+    di_set_disk_string (di_data, dinfo, DI_DISP_MOUNTPT, tbuff);
+    di_set_disk_string (di_data, dinfo, DI_DISP_FSTYPE, dupTests [i].fstype);
+    dinfo->mntDev = dupTests [i].dev;
+    dinfo->mntRoot = di_arena_strdup (&di_data->arena, dupTests [i].root);
+    dinfo->hasMntDev = true;
+  }
+  di_data->fscount = DILIB_DUP_TEST_COUNT;
+
+  checkDuplicates (di_data, false);
+
+  for (i = 0; i < DILIB_DUP_TEST_COUNT; ++i) {
+    ++testno;
+    dinfo = &di_data->diskInfo [i];
+    if ((dinfo->printFlag == DI_PRNT_IGNORE) != dupTests [i].dup) {
+      fprintf (stderr, "fail test %d dup: %s %lu %s\n", testno,
+          dupTests [i].fstype, dupTests [i].dev, dupTests [i].root);
+      grc = 1;
+    }
+  }
+
+  di_cleanup (di_data);
+
+  /* the filters, as the mount table is read and afterwards */
+  for (i = 0; i < DILIB_FILTER_TEST_COUNT; ++i) {
+    const char  *targv [5];
+
+    targv [0] = "di";
+    targv [1] = filterTests [i].opta;
+    targv [2] = filterTests [i].arga;
+    targv [3] = filterTests [i].optb;
+    targv [4] = filterTests [i].argb;
+    di_data = (di_data_t *) di_initialize ();
+    di_process_options (di_data, 5, targv, 1);
+    if (di_disk_info_reserve (di_data, 1) < 0) {
+      return 1;
+    }
+    di_initialize_disk_info_arena (&di_data->diskInfo [0], 0);
+    di_initialize_disk_info_arena (&di_data->diskInfo [1], 1);
+    dinfo = &di_data->diskInfo [0];
+    di_set_disk_string (di_data, dinfo, DI_DISP_MOUNTPT, filterTests [i].mountpt);
+    di_set_disk_string (di_data, dinfo, DI_DISP_FSTYPE, filterTests [i].fstype);
+    di_data->fscount = 1;
+    di_data->plan.filter = true;
+
+    ++testno;
+    if (di_drop_mount (di_data, filterTests [i].fstype,
+        filterTests [i].mountpt) != filterTests [i].excluded) {
+      fprintf (stderr, "fail test %d drop: %s %s %s %s: %s %s\n", testno,
+          filterTests [i].opta, filterTests [i].arga,
+          filterTests [i].optb, filterTests [i].argb,
+          filterTests [i].fstype, filterTests [i].mountpt);
+      grc = 1;
+    }
+
+    ++testno;
+    preCheckDiskInfo (di_data);
+    if ((dinfo->printFlag == DI_PRNT_EXCLUDE) != filterTests [i].excluded) {
+      fprintf (stderr, "fail test %d precheck: %s %s %s %s: %s %s\n", testno,
+          filterTests [i].opta, filterTests [i].arga,
+          filterTests [i].optb, filterTests [i].argb,
+          filterTests [i].fstype, filterTests [i].mountpt);
+      grc = 1;
+    }
+    di_cleanup (di_data);
+  }
+
+  /* interval sampling: the held descriptors are re-read */
+  /* within the deadline                                  */
+  di_data = (di_data_t *) di_initialize ();
+  if (di_disk_info_reserve (di_data, 1) < 0) {
+    return 1;
+  }
+  di_initialize_disk_info_arena (&di_data->diskInfo [0], 0);
+  di_initialize_disk_info_arena (&di_data->diskInfo [1], 1);
+  dinfo = &di_data->diskInfo [0];
+  di_set_disk_string (di_data, dinfo, DI_DISP_MOUNTPT, "/");
+  dinfo->doPrint = true;
+  di_data->fscount = 1;
+  di_data->holdFds = true;
+  di_get_disk_info (di_data, &di_data->fscount);
+
+  /* nothing is held if the system has no O_PATH descriptors */
+  if (dinfo->mntFd >= 0) {
+    ++testno;
+    if (di_get_held_disk_info (di_data) != 0 ||
+        dinfo->printFlag != DI_PRNT_OK) {
+      fprintf (stderr, "fail test %d held: re-read\n", testno);
+      grc = 1;
+    }
+
+    ++testno;
+    di_data->deadlineAt = di_probe_now () - 1;
+    if (di_get_held_disk_info (di_data) != 0 ||
+        dinfo->printFlag != DI_PRNT_STALE) {
+      fprintf (stderr, "fail test %d held: deadline\n", testno);
+      grc = 1;
+    }
+
+    /* the stale partition needs a full sample */
+    ++testno;
+    di_data->deadlineAt = 0;
+    if (di_get_held_disk_info (di_data) != -1) {
+      fprintf (stderr, "fail test %d held: stale\n", testno);
+      grc = 1;
+    }
+  }
+
+  di_cleanup (di_data);
+  return grc;
+}
+
+#endif /* TEST_DILIB */
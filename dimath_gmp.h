@@ -128,6 +128,33 @@ dinum_cmp_s (const dinum_t *r, di_si_t val)
   return mpz_cmp_si (*r, (long) val);
 }
 
+/* returns false if the value does not fit in a di_ui_t */
+static inline int
+dinum_get_u (const dinum_t *r, di_ui_t *val)
+{
+  mpz_t     t;
+
+  if (mpz_sgn (*r) < 0 ||
+      mpz_sizeinbase (*r, 2) > sizeof (di_ui_t) * 8) {
+    return 0;
+  }
+  if (sizeof (unsigned long) >= sizeof (di_ui_t)) {
+    *val = (di_ui_t) mpz_get_ui (*r);
+    return 1;
+  }
+
+  /* 32-bit unsigned long */
+  mpz_init (t);
+  mpz_fdiv_q_2exp (t, *r, 32);
+  *val = (di_ui_t) mpz_get_ui (t);
+  *val <<= 16;
+  *val <<= 16;
+  mpz_fdiv_r_2exp (t, *r, 32);
+  *val |= (di_ui_t) mpz_get_ui (t);
+  mpz_clear (t);
+  return 1;
+}
+
 static inline void
 dinum_mul (dinum_t *r, const dinum_t *val)
 {
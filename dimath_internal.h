@@ -156,6 +156,23 @@ dinum_cmp_s (const dinum_t *r, di_si_t val)
   return rc;
 }
 
+/* returns false if the value does not fit in a di_ui_t */
+static inline int
+dinum_get_u (const dinum_t *r, di_ui_t *val)
+{
+#if defined (DI_INTERNAL_DOUBLE)
+  di_unum_t   limit;
+
+  /* 2^bits is exact as a floating point value */
+  limit = (di_unum_t) ((di_ui_t) 1 << (sizeof (di_ui_t) * 8 - 1)) * 2;
+  if (*r < 0 || *r >= limit) {
+    return 0;
+  }
+#endif
+  *val = (di_ui_t) *r;
+  return 1;
+}
+
 static inline void
 dinum_mul (dinum_t *r, const dinum_t *val)
 {
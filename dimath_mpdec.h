@@ -183,6 +183,25 @@ dinum_cmp_s (const dinum_t *r, di_si_t val)
   return rc;
 }
 
+/* returns false if the value does not fit in a di_ui_t */
+static inline int
+dinum_get_u (const dinum_t *r, di_ui_t *val)
+{
+  uint32_t    status = 0;
+  uint64_t    tval;
+
+#if DIMATH_MPD_DEBUG
+  dimath_mpd_init_chk ("get_u");
+#endif
+  tval = mpd_qget_u64 (*r, &status);
+  if ((status & MPD_Invalid_operation) == MPD_Invalid_operation ||
+      tval > (uint64_t) (di_ui_t) ~ (di_ui_t) 0) {
+    return 0;
+  }
+  *val = (di_ui_t) tval;
+  return 1;
+}
+
 static inline void
 dinum_mul (dinum_t *r, const dinum_t *val)
 {
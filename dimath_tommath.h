@@ -115,6 +115,18 @@ dinum_cmp_s (const dinum_t *r, di_si_t val)
   return rv;
 }
 
+/* returns false if the value does not fit in a di_ui_t */
+static inline int
+dinum_get_u (const dinum_t *r, di_ui_t *val)
+{
+  if (mp_isneg (r) ||
+      mp_count_bits (r) > (int) (sizeof (di_ui_t) * 8)) {
+    return 0;
+  }
+  *val = (di_ui_t) mp_get_u64 (r);
+  return 1;
+}
+
 static inline void
 dinum_mul (dinum_t *r, const dinum_t *val)
 {
@@ -358,6 +358,41 @@ main (int argc, char *argv [])
     ++errcount;
   }
 
+  /* get_u */
+  dinum_set_u (&a, (di_ui_t) 1234567);
+  ival = 0;
+  ++testcount;
+  if (! dinum_get_u (&a, &ival) || ival != 1234567) {
+    fprintf (stderr, "%d: get-u 1234567 fail\n", testcount);
+    ++errcount;
+  }
+
+  dinum_set_u (&a, (di_ui_t) 1 << 40);
+  ival = 0;
+  ++testcount;
+  if (! dinum_get_u (&a, &ival) || ival != (di_ui_t) 1 << 40) {
+    fprintf (stderr, "%d: get-u 2^40 fail\n", testcount);
+    ++errcount;
+  }
+
+  dinum_set_s (&a, (di_si_t) -1);
+  ++testcount;
+  if (dinum_get_u (&a, &ival)) {
+    fprintf (stderr, "%d: get-u -1 fail\n", testcount);
+    ++errcount;
+  }
+
+#if _use_math != DI_INTERNAL
+  /* 2^64 does not fit */
+  dinum_set_u (&a, (di_ui_t) 1 << 32);
+  dinum_mul (&a, &a);
+  ++testcount;
+  if (dinum_get_u (&a, &ival)) {
+    fprintf (stderr, "%d: get-u 2^64 fail\n", testcount);
+    ++errcount;
+  }
+#endif
+
   dinum_clear (&a);
   dinum_clear (&b);
   dinum_clear (&r);
@@ -67,37 +67,50 @@ static di_valid_scale_t validscale [DI_SCALE_MAX] =
   { 'Q', 'q' }   /* "Quetta", "Quetti" */
 };
 
+/* in milliseconds; di_check_option () returns the interval as an int */
+#define DI_DURATION_MAX   2147483647L
+
 #define OPT_IDX_A         0
 #define OPT_IDX_a         1
 #define OPT_IDX_B         2
 #define OPT_IDX_c         3
 #define OPT_IDX_C         4
 #define OPT_IDX_d         5
-#define OPT_IDX_f         6
-#define OPT_IDX_g         7
-#define OPT_IDX_h         8
-#define OPT_IDX_H         9
-#define OPT_IDX_help      10
-#define OPT_IDX_I         11
-#define OPT_IDX_j         12
-#define OPT_IDX_k         13
-#define OPT_IDX_l         14
-#define OPT_IDX_L         15
-#define OPT_IDX_m         16
-#define OPT_IDX_n         17
-#define OPT_IDX_P         18
-#define OPT_IDX_q         19
-#define OPT_IDX_R         20
-#define OPT_IDX_s         21
-#define OPT_IDX_si        22
-#define OPT_IDX_t         23
-#define OPT_IDX_version   24
-#define OPT_IDX_x         25
-#define OPT_IDX_X         26
-#define OPT_IDX_z         27
-#define OPT_IDX_Z         28
-#define OPT_IDX_MAX_NAMED 29
-#define OPT_IDX_MAX       53
+#define OPT_IDX_deadline  6
+#define OPT_IDX_exclude_path 7
+#define OPT_IDX_f         8
+#define OPT_IDX_files_from 9
+#define OPT_IDX_g         10
+#define OPT_IDX_h         11
+#define OPT_IDX_H         12
+#define OPT_IDX_help      13
+#define OPT_IDX_I         14
+#define OPT_IDX_include_path 15
+#define OPT_IDX_interval  16
+#define OPT_IDX_j         17
+#define OPT_IDX_k         18
+#define OPT_IDX_l         19
+#define OPT_IDX_L         20
+#define OPT_IDX_m         21
+#define OPT_IDX_n         22
+#define OPT_IDX_no_automount 23
+#define OPT_IDX_P         24
+#define OPT_IDX_probe_threads 25
+#define OPT_IDX_probe_timeout 26
+#define OPT_IDX_q         27
+#define OPT_IDX_R         28
+#define OPT_IDX_s         29
+#define OPT_IDX_si        30
+#define OPT_IDX_t         31
+#define OPT_IDX_top       32
+#define OPT_IDX_version   33
+#define OPT_IDX_where     34
+#define OPT_IDX_x         35
+#define OPT_IDX_X         36
+#define OPT_IDX_z         37
+#define OPT_IDX_Z         38
+#define OPT_IDX_MAX_NAMED 39
+#define OPT_IDX_MAX       64
 
 
 static int scaleids [] =
@@ -105,7 +118,7 @@ static int scaleids [] =
 static int paidb [] =
   { OPT_IDX_a, OPT_IDX_help, OPT_IDX_P, OPT_IDX_si, OPT_IDX_version };
 static int paidv [] =
-  { OPT_IDX_B, OPT_IDX_I, OPT_IDX_s, OPT_IDX_x, OPT_IDX_X };
+  { OPT_IDX_B, OPT_IDX_deadline, OPT_IDX_exclude_path, OPT_IDX_I, OPT_IDX_include_path, OPT_IDX_interval, OPT_IDX_probe_timeout, OPT_IDX_s, OPT_IDX_x, OPT_IDX_X };
 
 #define DI_ARGV_SEP             " 	"  /* space, tab */
 #define DI_MAX_ARGV             50
@@ -114,10 +127,134 @@ static int paidv [] =
 #define DI_POSIX_FORMAT         "sbuvpm"
 #define DI_ALL_FORMAT           "mts\n\tO\n\tbuf13\n\tbcvpa\n\tBuv2\n\tiUFP"
 
+typedef struct
+{
+  di_where_t      *where;
+  char            *p;
+  const char      *err;
+  int             depth;
+  int             nest;
+  int             blockSize;
+} di_where_parse_t;
+
+/* the fields for --where; the names match the JSON output */
+typedef struct
+{
+  const char      *name;
+  int             op;                       /* DI_WHERE_STREQ: a string */
+  int             arg [5];
+} di_where_field_t;
+
+static const di_where_field_t whereFields [] =
+{
+  { "size", DI_WHERE_SPACE,
+    { DI_SPACE_TOTAL, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE } },
+  { "used", DI_WHERE_SPACE,
+    { DI_SPACE_TOTAL, DI_SPACE_FREE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE } },
+  { "free", DI_WHERE_SPACE,
+    { DI_SPACE_FREE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE } },
+  { "available", DI_WHERE_SPACE,
+    { DI_SPACE_AVAIL, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE } },
+  { "avail", DI_WHERE_SPACE,
+    { DI_SPACE_AVAIL, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE } },
+  { "percused", DI_WHERE_PERC,
+    { DI_SPACE_TOTAL, DI_SPACE_AVAIL, DI_SPACE_TOTAL, DI_VALUE_NONE, DI_VALUE_NONE } },
+  { "percfree", DI_WHERE_PERC,
+    { DI_SPACE_AVAIL, DI_VALUE_NONE, DI_SPACE_TOTAL, DI_VALUE_NONE, DI_VALUE_NONE } },
+  { "inodes", DI_WHERE_SPACE,
+    { DI_INODE_TOTAL, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE } },
+  { "inodesused", DI_WHERE_SPACE,
+    { DI_INODE_TOTAL, DI_INODE_FREE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE } },
+  { "inodesfree", DI_WHERE_SPACE,
+    { DI_INODE_FREE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE } },
+  { "percinodesused", DI_WHERE_PERC,
+    { DI_INODE_TOTAL, DI_INODE_AVAIL, DI_INODE_TOTAL, DI_VALUE_NONE, DI_VALUE_NONE } },
+  /* short names */
+  { "itotal", DI_WHERE_SPACE,
+    { DI_INODE_TOTAL, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE } },
+  { "iused", DI_WHERE_SPACE,
+    { DI_INODE_TOTAL, DI_INODE_FREE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE } },
+  { "ifree", DI_WHERE_SPACE,
+    { DI_INODE_FREE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE } },
+  { "iavail", DI_WHERE_SPACE,
+    { DI_INODE_AVAIL, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE } },
+  { "ipercused", DI_WHERE_PERC,
+    { DI_INODE_TOTAL, DI_INODE_AVAIL, DI_INODE_TOTAL, DI_VALUE_NONE, DI_VALUE_NONE } },
+  { "local", DI_WHERE_FLAG,
+    { DI_WHERE_FLAG_LOCAL, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE } },
+  { "readonly", DI_WHERE_FLAG,
+    { DI_WHERE_FLAG_READONLY, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE } },
+  { "loopback", DI_WHERE_FLAG,
+    { DI_WHERE_FLAG_LOOPBACK, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE } },
+  { "filesystem", DI_WHERE_STREQ,
+    { DI_DISP_FILESYSTEM, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE } },
+  { "mount", DI_WHERE_STREQ,
+    { DI_DISP_MOUNTPT, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE } },
+  { "fstype", DI_WHERE_STREQ,
+    { DI_DISP_FSTYPE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE } },
+  { "options", DI_WHERE_STREQ,
+    { DI_DISP_MOUNTOPT, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE, DI_VALUE_NONE } },
+};
+#define DI_WHERE_FIELD_COUNT \
+    ((int) (sizeof (whereFields) / sizeof (di_where_field_t)))
+
+static const char *sizeSuffixes = "kmgtp";
+
+/*
+ * The network filesystem types.  These are classed as remote before
+ * any of the mounts is probed, so that -l does not touch them.
+ * A trailing '*' matches any type with that prefix.  The
+ * DI_REMOTE_FSTYPES environment variable adds to this list.
+ */
+static const char *diRemoteFSTypes [] = {
+  "nfs*",
+  "cifs", "smb", "smb2", "smb3", "smbfs",
+  "afs", "coda", "ncpfs", "ncp",
+  "ceph", "fuse.ceph", "fuse.ceph-fuse",
+  "glusterfs", "fuse.glusterfs",
+  "lustre", "gpfs", "beegfs", "orangefs", "pvfs2",
+  "9p",
+  "fuse.sshfs", "sshfs", "davfs", "fuse.davfs2", "webdav",
+  "fuse.s3fs", "fuse.rclone", "fuse.gcsfuse", "fuse.juicefs",
+  "afpfs",
+};
+#define DI_REMOTE_FSTYPES_COUNT \
+    (sizeof (diRemoteFSTypes) / sizeof (const char *))
+
 static void processStringArgs (char *, di_opt_t *, int offset, char *, Size_t);
 static int  processArgs (int, const char * argv [], di_opt_t *, int offset, char *, Size_t);
 static int  parseList (di_strarr_t *, const char *);
+static int  compileFilters (di_opt_t *);
+static int  compileTypes (di_typefilter_t *, const di_strarr_t *);
+static int  compileRemoteTypes (di_opt_t *);
+static int  typesInit (di_typefilter_t *, Size_t);
+static void typesAdd (di_typefilter_t *, const char *);
+static void typesFree (di_typefilter_t *);
+static int  compilePaths (di_pathfilter_t *, const di_strarr_t *);
+static void freeList (di_strarr_t *);
+static void freeFilters (di_opt_t *);
+static int  strsetInit (di_strset_t *, Size_t);
+static void strsetAdd (di_strset_t *, const char *, Size_t);
+static int  strsetFind (const di_strset_t *, const char *, Size_t);
+static void strsetFree (di_strset_t *);
+static unsigned long strsetHash (const char *, Size_t);
+static int  isGlob (const char *, Size_t);
+static int  globMatch (const char *, const char *);
+static void whereFree (di_where_t *);
+static int  whereCompile (di_opt_t *);
+static void whereOr (di_where_parse_t *);
+static void whereAnd (di_where_parse_t *);
+static void whereUnary (di_where_parse_t *);
+static void whereCompare (di_where_parse_t *);
+static void whereValue (di_where_parse_t *, const di_where_field_t *);
+static const di_where_field_t *whereField (di_where_parse_t *);
+static int  whereRelOp (di_where_parse_t *);
+static int  whereStrOp (di_where_parse_t *);
+static char *whereString (di_where_parse_t *);
+static void whereSpace (di_where_parse_t *);
+static int  whereEmit (di_where_parse_t *, int, int);
 static void parseScaleValue (di_opt_t *diopts, const char *ptr);
+static int  parseDuration (const char *, const char *, long *);
 static void processOptions (const char *, void *);
 static void processOptionsVal (const char *, void *, const char *);
 static void setExitFlag (di_opt_t *, int);
@@ -189,13 +326,41 @@ di_init_options (void)
 
   diopts->formatString = DI_DEFAULT_FORMAT;
   diopts->formatLen = (int) strlen (diopts->formatString);
+  diopts->filesFrom = NULL;
   diopts->zoneDisplay [0] = '\0';
   diopts->exclude_list.count = 0;
   diopts->exclude_list.list = (char **) NULL;
   diopts->include_list.count = 0;
   diopts->include_list.list = (char **) NULL;
+  diopts->exclude_path_list.count = 0;
+  diopts->exclude_path_list.list = (char **) NULL;
+  diopts->include_path_list.count = 0;
+  diopts->include_path_list.list = (char **) NULL;
+  diopts->remote_list.count = 0;
+  diopts->remote_list.list = (char **) NULL;
+  typesInit (&diopts->exclude_types, 0);
+  typesInit (&diopts->include_types, 0);
+  typesInit (&diopts->remote_types, 0);
+  strsetInit (&diopts->exclude_paths.exact, 0);
+  strsetInit (&diopts->exclude_paths.below, 0);
+  diopts->exclude_paths.globs = NULL;
+  diopts->exclude_paths.globcount = 0;
+  strsetInit (&diopts->include_paths.exact, 0);
+  strsetInit (&diopts->include_paths.below, 0);
+  diopts->include_paths.globs = NULL;
+  diopts->include_paths.globcount = 0;
+  diopts->whereString = NULL;
+  diopts->where.code = NULL;
+  diopts->where.text = NULL;
+  whereFree (&diopts->where);
   diopts->scale = DI_SCALE_GIGA;
   diopts->blockSize = DI_BLKSZ_1024;
+  diopts->probeThreads = 0;
+  diopts->probeTimeout = 0;
+  diopts->deadline = 0;
+  diopts->interval = 0;
+  diopts->topCount = 0;
+  diopts->noAutomount = false;
   for (i = 0; i < DI_OPT_MAX; ++i) {
     diopts->optval [i] = false;
   }
@@ -220,17 +385,13 @@ di_opt_cleanup (di_opt_t *diopts)
     return;
   }
 
-  if (diopts->exclude_list.count > 0 &&
-      diopts->exclude_list.list != (char **) NULL) {
-    free ( (void *) diopts->exclude_list.list);
-    diopts->exclude_list.count = 0;
-  }
-
-  if (diopts->include_list.count > 0 &&
-      diopts->include_list.list != (char **) NULL) {
-    free (diopts->include_list.list);
-    diopts->include_list.count = 0;
-  }
+  freeFilters (diopts);
+  freeList (&diopts->exclude_list);
+  freeList (&diopts->include_list);
+  freeList (&diopts->exclude_path_list);
+  freeList (&diopts->include_path_list);
+  freeList (&diopts->remote_list);
+  whereFree (&diopts->where);
 
   if (diopts->diargsptr != NULL) {
     free (diopts->diargsptr);
@@ -288,6 +449,11 @@ di_get_options (int argc, const char * argv [], di_opt_t *diopts, int offset)
     processStringArgs (ptr, diopts, offset, scalestr, sizeof (scalestr));
   }
 
+  freeList (&diopts->remote_list);
+  if ( (ptr = getenv ("DI_REMOTE_FSTYPES")) != (char *) NULL) {
+    parseList (&diopts->remote_list, ptr);
+  }
+
   optidx = processArgs (argc, argv, diopts, offset, scalestr, sizeof (scalestr));
 
   parseScaleValue (diopts, scalestr);
@@ -302,6 +468,15 @@ di_get_options (int argc, const char * argv [], di_opt_t *diopts, int offset)
     printf ("\n");
     printf ("# blocksize: %d\n", diopts->blockSize);
     printf ("# scale: %s\n", scalestr);
+    printf ("# probe-threads: %d\n", diopts->probeThreads);
+    printf ("# probe-timeout: %ldms\n", diopts->probeTimeout);
+    printf ("# deadline: %ldms\n", diopts->deadline);
+    printf ("# interval: %ldms\n", diopts->interval);
+    printf ("# top: %d\n", diopts->topCount);
+    printf ("# no-automount: %d\n", diopts->noAutomount);
+    if (diopts->filesFrom != NULL) {
+      printf ("# files-from: %s\n", diopts->filesFrom);
+    }
 
     if ( (ptr = getenv ("POSIXLY_CORRECT")) != (char *) NULL) {
       printf ("# POSIXLY_CORRECT: %s\n", ptr);
@@ -318,11 +493,19 @@ di_get_options (int argc, const char * argv [], di_opt_t *diopts, int offset)
     if ( (ptr = getenv ("DI_ARGS")) != (char *) NULL) {
       printf ("# DI_ARGS: %s\n", ptr);
     }
+    if ( (ptr = getenv ("DI_REMOTE_FSTYPES")) != (char *) NULL) {
+      printf ("# DI_REMOTE_FSTYPES: %s\n", ptr);
+    }
   }
 
   diopts->formatLen = (int) strlen (diopts->formatString);
   diopts->optidx = optidx;
 
+  if (compileFilters (diopts) != 0 ||
+      whereCompile (diopts) != 0) {
+    setExitFlag (diopts, DI_EXIT_FAIL);
+  }
+
   return diopts->exitFlag;
 }
 
@@ -370,6 +553,9 @@ di_opt_check_option (di_opt_t *diopts, int optidx)
   if (optidx == DI_OPT_BLOCK_SZ) {
     return diopts->blockSize;
   }
+  if (optidx == DI_OPT_INTERVAL) {
+    return (int) diopts->interval;
+  }
 
   if (optidx < 0 || optidx >= DI_OPT_MAX) {
     return 0;
@@ -378,6 +564,74 @@ di_opt_check_option (di_opt_t *diopts, int optidx)
   return diopts->optval [optidx];
 }
 
+/*
+ * An exact match, or the "fuse" entry matches any of the fuse types.
+ * The 'name*' entries are few, and are checked one at a time.
+ */
+int
+di_opt_type_match (const di_typefilter_t *filter, const char *fstype)
+{
+  Size_t      i;
+
+  if (strsetFind (&filter->types, fstype, strlen (fstype))) {
+    return true;
+  }
+  if (filter->fuse && strncmp (fstype, "fuse", 4) == 0) {
+    return true;
+  }
+  for (i = 0; i < filter->prefixcount; ++i) {
+    if (strncmp (fstype, filter->prefixes [i],
+        strlen (filter->prefixes [i]) - 1) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * The exact paths are a single lookup, and each of the parent
+ * directories of the path is looked up in the set of "dir/<star>"
+ * patterns.  Only the other patterns are matched one at a time.
+ */
+int
+di_opt_path_match (const di_pathfilter_t *filter, const char *path)
+{
+  Size_t      len;
+  Size_t      i;
+
+  len = strlen (path);
+  while (len > 1 && path [len - 1] == '/') {
+    --len;
+  }
+  if (strsetFind (&filter->exact, path, len)) {
+    return true;
+  }
+
+  if (filter->below.count > 0 && *path == '/' && len > 1) {
+    if (strsetFind (&filter->below, path, 1)) {
+      return true;
+    }
+    for (i = 1; i < len; ++i) {
+      if (path [i] == '/' && strsetFind (&filter->below, path, i)) {
+        return true;
+      }
+    }
+  }
+
+  for (i = 0; i < filter->globcount; ++i) {
+    if (globMatch (filter->globs [i], path)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int
+di_opt_glob_match (const char *pattern, const char *str)
+{
+  return globMatch (pattern, str);
+}
+
 static int
 processArgs (int argc, const char * argv [], di_opt_t *diopts,
     int offset, char *scalestr, Size_t scalestrsz)
@@ -477,12 +731,42 @@ processOptionsVal (const char *arg, void *valptr, const char *value)
 
   if (strcmp (arg, "-B") == 0) {
     parseScaleValue (padata->diopts, value);
+  } else if (strcmp (arg, "--deadline") == 0) {
+    rc = parseDuration (arg, value, &padata->diopts->deadline);
+    if (rc != 0) {
+      setExitFlag (padata->diopts, DI_EXIT_FAIL);
+      return;
+    }
+  } else if (strcmp (arg, "--exclude-path") == 0) {
+    rc = parseList (&padata->diopts->exclude_path_list, value);
+    if (rc != 0) {
+      setExitFlag (padata->diopts, DI_EXIT_FAIL);
+      return;
+    }
   } else if (strcmp (arg, "-I") == 0) {
     rc = parseList (&padata->diopts->include_list, value);
     if (rc != 0) {
       setExitFlag (padata->diopts, DI_EXIT_FAIL);
       return;
     }
+  } else if (strcmp (arg, "--include-path") == 0) {
+    rc = parseList (&padata->diopts->include_path_list, value);
+    if (rc != 0) {
+      setExitFlag (padata->diopts, DI_EXIT_FAIL);
+      return;
+    }
+  } else if (strcmp (arg, "--interval") == 0) {
+    rc = parseDuration (arg, value, &padata->diopts->interval);
+    if (rc != 0) {
+      setExitFlag (padata->diopts, DI_EXIT_FAIL);
+      return;
+    }
+  } else if (strcmp (arg, "--probe-timeout") == 0) {
+    rc = parseDuration (arg, value, &padata->diopts->probeTimeout);
+    if (rc != 0) {
+      setExitFlag (padata->diopts, DI_EXIT_FAIL);
+      return;
+    }
   } else if (strcmp (arg, "-s") == 0) {
     char      *stend = padata->diopts->sortType + sizeof (padata->diopts->sortType);
 
@@ -569,6 +853,795 @@ parseList (di_strarr_t *list, const char *str)
 }
 
 
+/*
+ * The lists are compiled once, after all of the arguments have been
+ * processed, so that the per-mount checks do not depend on the
+ * length of the lists.  The compiled sets point into the lists.
+ */
+static int
+compileFilters (di_opt_t *diopts)
+{
+  freeFilters (diopts);
+  if (compileTypes (&diopts->exclude_types, &diopts->exclude_list) != 0 ||
+      compileTypes (&diopts->include_types, &diopts->include_list) != 0 ||
+      compileRemoteTypes (diopts) != 0 ||
+      compilePaths (&diopts->exclude_paths, &diopts->exclude_path_list) != 0 ||
+      compilePaths (&diopts->include_paths, &diopts->include_path_list) != 0) {
+    return 1;
+  }
+  return 0;
+}
+
+static int
+compileTypes (di_typefilter_t *filter, const di_strarr_t *list)
+{
+  Size_t      i;
+
+  if (typesInit (filter, list->count) != 0) {
+    return 1;
+  }
+  for (i = 0; i < list->count; ++i) {
+    typesAdd (filter, list->list [i]);
+  }
+  return 0;
+}
+
+/* the built-in remote types, and DI_REMOTE_FSTYPES */
+static int
+compileRemoteTypes (di_opt_t *diopts)
+{
+  di_typefilter_t *filter;
+  Size_t          i;
+
+  filter = &diopts->remote_types;
+  if (typesInit (filter,
+      DI_REMOTE_FSTYPES_COUNT + diopts->remote_list.count) != 0) {
+    return 1;
+  }
+  for (i = 0; i < DI_REMOTE_FSTYPES_COUNT; ++i) {
+    typesAdd (filter, diRemoteFSTypes [i]);
+  }
+  for (i = 0; i < diopts->remote_list.count; ++i) {
+    typesAdd (filter, diopts->remote_list.list [i]);
+  }
+  return 0;
+}
+
+static int
+typesInit (di_typefilter_t *filter, Size_t count)
+{
+  filter->fuse = false;
+  filter->prefixes = NULL;
+  filter->prefixcount = 0;
+  if (strsetInit (&filter->types, count) != 0) {
+    return 1;
+  }
+  if (count > 0) {
+    filter->prefixes = (const char **) malloc (sizeof (const char *) * count);
+    if (filter->prefixes == NULL) {
+      fprintf (stderr, "malloc failed in typesInit.  errno %d\n", errno);
+      strsetFree (&filter->types);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* the set points at the string, which must remain valid */
+static void
+typesAdd (di_typefilter_t *filter, const char *fstype)
+{
+  Size_t      len;
+
+  len = strlen (fstype);
+  if (len > 1 && fstype [len - 1] == '*') {
+    filter->prefixes [filter->prefixcount] = fstype;
+    ++filter->prefixcount;
+    return;
+  }
+  if (strcmp (fstype, "fuse") == 0) {
+    filter->fuse = true;
+  }
+  strsetAdd (&filter->types, fstype, len);
+}
+
+static void
+typesFree (di_typefilter_t *filter)
+{
+  strsetFree (&filter->types);
+  if (filter->prefixes != NULL) {
+    free ( (void *) filter->prefixes);
+  }
+  filter->prefixes = NULL;
+  filter->prefixcount = 0;
+  filter->fuse = false;
+}
+
+static int
+compilePaths (di_pathfilter_t *filter, const di_strarr_t *list)
+{
+  const char  *p;
+  Size_t      len;
+  Size_t      i;
+
+  if (strsetInit (&filter->exact, list->count) != 0 ||
+      strsetInit (&filter->below, list->count) != 0) {
+    return 1;
+  }
+  if (list->count > 0) {
+    filter->globs = (char **) malloc (sizeof (char *) * list->count);
+    if (filter->globs == NULL) {
+      fprintf (stderr, "malloc failed in compilePaths.  errno %d\n", errno);
+      return 1;
+    }
+  }
+
+  for (i = 0; i < list->count; ++i) {
+    p = list->list [i];
+    len = strlen (p);
+    while (len > 1 && p [len - 1] == '/') {
+      --len;
+    }
+
+    if (! isGlob (p, len)) {
+      strsetAdd (&filter->exact, p, len);
+      continue;
+    }
+
+    /* dir/<star> : a lookup of each of the parent directories */
+    if (len >= 2 && p [len - 1] == '*' && p [len - 2] == '/' &&
+        ! isGlob (p, len - 2)) {
+      len -= 2;
+      while (len > 1 && p [len - 1] == '/') {
+        --len;
+      }
+      if (len == 0) {
+        len = 1;
+      }
+      strsetAdd (&filter->below, p, len);
+      continue;
+    }
+
+    filter->globs [filter->globcount] = list->list [i];
+    ++filter->globcount;
+  }
+  return 0;
+}
+
+static void
+freeList (di_strarr_t *list)
+{
+  Size_t      i;
+
+  if (list->list != (char **) NULL) {
+    for (i = 0; i < list->count; ++i) {
+      free (list->list [i]);
+    }
+    free (list->list);
+  }
+  list->list = (char **) NULL;
+  list->count = 0;
+}
+
+static void
+freeFilters (di_opt_t *diopts)
+{
+  typesFree (&diopts->exclude_types);
+  typesFree (&diopts->include_types);
+  typesFree (&diopts->remote_types);
+  strsetFree (&diopts->exclude_paths.exact);
+  strsetFree (&diopts->exclude_paths.below);
+  strsetFree (&diopts->include_paths.exact);
+  strsetFree (&diopts->include_paths.below);
+  if (diopts->exclude_paths.globs != NULL) {
+    free (diopts->exclude_paths.globs);
+  }
+  if (diopts->include_paths.globs != NULL) {
+    free (diopts->include_paths.globs);
+  }
+  diopts->exclude_paths.globs = NULL;
+  diopts->exclude_paths.globcount = 0;
+  diopts->include_paths.globs = NULL;
+  diopts->include_paths.globcount = 0;
+}
+
+/* the table is sized for the number of keys, the load is at most one half */
+static int
+strsetInit (di_strset_t *set, Size_t count)
+{
+  Size_t      tsize;
+
+  set->slots = NULL;
+  set->lens = NULL;
+  set->tsize = 0;
+  set->count = 0;
+  if (count == 0) {
+    return 0;
+  }
+
+  tsize = 8;
+  while (tsize < count * 2) {
+    tsize *= 2;
+  }
+  set->slots = (const char **) calloc (tsize, sizeof (const char *));
+  set->lens = (Size_t *) calloc (tsize, sizeof (Size_t));
+  if (set->slots == NULL || set->lens == NULL) {
+    fprintf (stderr, "malloc failed in strsetInit.  errno %d\n", errno);
+    strsetFree (set);
+    return 1;
+  }
+  set->tsize = tsize;
+  return 0;
+}
+
+static void
+strsetAdd (di_strset_t *set, const char *str, Size_t len)
+{
+  Size_t      h;
+
+  h = (Size_t) strsetHash (str, len) & (set->tsize - 1);
+  while (set->slots [h] != NULL) {
+    if (set->lens [h] == len && memcmp (set->slots [h], str, len) == 0) {
+      return;
+    }
+    h = (h + 1) & (set->tsize - 1);
+  }
+  set->slots [h] = str;
+  set->lens [h] = len;
+  ++set->count;
+}
+
+static int
+strsetFind (const di_strset_t *set, const char *str, Size_t len)
+{
+  Size_t      h;
+
+  if (set->count == 0) {
+    return false;
+  }
+  h = (Size_t) strsetHash (str, len) & (set->tsize - 1);
+  while (set->slots [h] != NULL) {
+    if (set->lens [h] == len && memcmp (set->slots [h], str, len) == 0) {
+      return true;
+    }
+    h = (h + 1) & (set->tsize - 1);
+  }
+  return false;
+}
+
+static void
+strsetFree (di_strset_t *set)
+{
+  if (set->slots != NULL) {
+    free ( (void *) set->slots);
+  }
+  if (set->lens != NULL) {
+    free (set->lens);
+  }
+  set->slots = NULL;
+  set->lens = NULL;
+  set->tsize = 0;
+  set->count = 0;
+}
+
+/* FNV-1a */
+static unsigned long
+strsetHash (const char *str, Size_t len)
+{
+  unsigned long   hash;
+  Size_t          i;
+
+  hash = 2166136261UL;
+  for (i = 0; i < len; ++i) {
+    hash ^= (unsigned char) str [i];
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+
+static int
+isGlob (const char *p, Size_t len)
+{
+  Size_t      i;
+
+  for (i = 0; i < len; ++i) {
+    if (p [i] == '*' || p [i] == '?' || p [i] == '[' || p [i] == '\\') {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Shell style patterns: * ? [...] and backslash.  A '*' also
+ * matches a '/'.
+ */
+static int
+globMatch (const char *pat, const char *str)
+{
+  const char  *spat;
+  const char  *sstr;
+  const char  *p;
+  int         negate;
+  int         found;
+
+  spat = NULL;
+  sstr = NULL;
+  while (*str != '\0') {
+    found = false;
+    if (*pat == '*') {
+      spat = ++pat;
+      sstr = str;
+      continue;
+    }
+    if (*pat == '?') {
+      found = true;
+      ++pat;
+    } else if (*pat == '[') {
+      p = pat + 1;
+      negate = false;
+      if (*p == '!' || *p == '^') {
+        negate = true;
+        ++p;
+      }
+      /* a ']' directly after the '[' is part of the set */
+      do {
+        if (*p == '\0') {
+          break;
+        }
+        if (p [1] == '-' && p [2] != ']' && p [2] != '\0') {
+          if ((unsigned char) *str >= (unsigned char) p [0] &&
+              (unsigned char) *str <= (unsigned char) p [2]) {
+            found = true;
+          }
+          p += 3;
+        } else {
+          if (*p == *str) {
+            found = true;
+          }
+          ++p;
+        }
+      } while (*p != ']');
+      if (*p == ']') {
+        found = (found != negate);
+        pat = p + 1;
+      } else {
+        /* no closing bracket, the '[' is an ordinary character */
+        found = (*str == '[');
+        ++pat;
+      }
+    } else {
+      if (*pat == '\\' && pat [1] != '\0') {
+        ++pat;
+      }
+      if (*pat != '\0' && *pat == *str) {
+        found = true;
+        ++pat;
+      }
+    }
+
+    if (found) {
+      ++str;
+      continue;
+    }
+    if (spat == NULL) {
+      return false;
+    }
+    /* back up to the last '*' and let it match one more character */
+    pat = spat;
+    str = ++sstr;
+  }
+
+  while (*pat == '*') {
+    ++pat;
+  }
+  return *pat == '\0';
+}
+
+/*
+ * --where
+ *
+ * The predicate is compiled once into a small stack machine, and is
+ * evaluated for each entry after the disk space has been fetched
+ * (see checkWhere () in dilib.c).
+ *
+ *   expr    : and [ '||' and ] ...
+ *   and     : unary [ '&&' unary ] ...
+ *   unary   : '!' unary | '(' expr ')' | compare
+ *   compare : value [ relop value ]
+ *           | string-field ( '==' | '!=' | '=~' | '!~' ) "string"
+ *
+ * A value is a number (1e5, 10G) or a numeric field.  '=~' is a
+ * shell pattern match.
+ */
+
+static void
+whereFree (di_where_t *where)
+{
+  if (where->code != NULL) {
+    free (where->code);
+  }
+  if (where->text != NULL) {
+    free (where->text);
+  }
+  where->code = NULL;
+  where->text = NULL;
+  where->count = 0;
+  where->usesValues = false;
+  where->usesOptions = false;
+}
+
+static int
+whereCompile (di_opt_t *diopts)
+{
+  di_where_t      *where;
+  di_where_parse_t wp;
+  Size_t          len;
+
+  where = &diopts->where;
+  whereFree (where);
+  if (diopts->whereString == NULL || ! *diopts->whereString) {
+    return 0;
+  }
+
+  /* each operator and operand is at least one character long */
+  len = strlen (diopts->whereString);
+  where->text = strdup (diopts->whereString);
+  where->code = (di_where_ins_t *) malloc (sizeof (di_where_ins_t) * (len + 1));
+  if (where->text == NULL || where->code == NULL) {
+    fprintf (stderr, "malloc failed in whereCompile.  errno %d\n", errno);
+    whereFree (where);
+    return 1;
+  }
+
+  wp.where = where;
+  wp.p = where->text;
+  wp.depth = 0;
+  wp.nest = 0;
+  wp.blockSize = diopts->blockSize;
+  wp.err = NULL;
+  whereOr (&wp);
+  whereSpace (&wp);
+  if (wp.err == NULL && *wp.p) {
+    wp.err = "unexpected text";
+  }
+
+  if (wp.err != NULL) {
+    /* the error location is in the copy of the expression */
+    fprintf (stderr, "di: --where: %s at offset %d: %s\n", wp.err,
+        (int) (wp.p - where->text), diopts->whereString);
+    whereFree (where);
+    return 1;
+  }
+
+  if (diopts->optval [DI_OPT_DEBUG] > 0) {
+    printf ("# where: %s (%d instructions)\n", diopts->whereString, where->count);
+  }
+  return 0;
+}
+
+static void
+whereOr (di_where_parse_t *wp)
+{
+  int     last;
+  int     next;
+
+  /* the jumps are chained through arg [0] until the end is known */
+  last = -1;
+  whereAnd (wp);
+  whereSpace (wp);
+  while (wp->err == NULL && wp->p [0] == '|' && wp->p [1] == '|') {
+    wp->p += 2;
+    next = whereEmit (wp, DI_WHERE_JTRUE, -1);
+    wp->where->code [next].arg [0] = last;
+    last = next;
+    whereAnd (wp);
+    whereSpace (wp);
+  }
+  while (last >= 0) {
+    next = wp->where->code [last].arg [0];
+    wp->where->code [last].arg [0] = wp->where->count;
+    last = next;
+  }
+}
+
+static void
+whereAnd (di_where_parse_t *wp)
+{
+  int     last;
+  int     next;
+
+  /* the jumps are chained through arg [0] until the end is known */
+  last = -1;
+  whereUnary (wp);
+  whereSpace (wp);
+  while (wp->err == NULL && wp->p [0] == '&' && wp->p [1] == '&') {
+    wp->p += 2;
+    next = whereEmit (wp, DI_WHERE_JFALSE, -1);
+    wp->where->code [next].arg [0] = last;
+    last = next;
+    whereUnary (wp);
+    whereSpace (wp);
+  }
+  while (last >= 0) {
+    next = wp->where->code [last].arg [0];
+    wp->where->code [last].arg [0] = wp->where->count;
+    last = next;
+  }
+}
+
+static void
+whereUnary (di_where_parse_t *wp)
+{
+  whereSpace (wp);
+  if (wp->err != NULL) {
+    return;
+  }
+  if (++wp->nest > DI_WHERE_STACK_MAX) {
+    wp->err = "the expression is too complex";
+    return;
+  }
+  if (wp->p [0] == '!' && wp->p [1] != '=' && wp->p [1] != '~') {
+    ++wp->p;
+    whereUnary (wp);
+    whereEmit (wp, DI_WHERE_NOT, 0);
+    --wp->nest;
+    return;
+  }
+  if (wp->p [0] == '(') {
+    ++wp->p;
+    whereOr (wp);
+    whereSpace (wp);
+    if (wp->err != NULL) {
+      return;
+    }
+    if (*wp->p != ')') {
+      wp->err = "missing ')'";
+      return;
+    }
+    ++wp->p;
+    --wp->nest;
+    return;
+  }
+  whereCompare (wp);
+  --wp->nest;
+}
+
+static void
+whereCompare (di_where_parse_t *wp)
+{
+  const di_where_field_t  *field;
+  di_where_ins_t          *ins;
+  char                    *str;
+  int                     op;
+
+  field = whereField (wp);
+  if (wp->err != NULL) {
+    return;
+  }
+
+  if (field != NULL && field->op == DI_WHERE_STREQ) {
+    whereSpace (wp);
+    op = whereStrOp (wp);
+    if (op < 0) {
+      wp->err = "expected '==', '!=', '=~' or '!~'";
+      return;
+    }
+    whereSpace (wp);
+    str = whereString (wp);
+    if (str == NULL) {
+      return;
+    }
+    ins = &wp->where->code [whereEmit (wp, op, 1)];
+    ins->arg [0] = field->arg [0];
+    ins->str = str;
+    if (field->arg [0] == DI_DISP_MOUNTOPT) {
+      wp->where->usesOptions = true;
+    }
+    return;
+  }
+
+  whereValue (wp, field);
+  whereSpace (wp);
+  op = whereRelOp (wp);
+  if (wp->err != NULL || op < 0) {
+    return;
+  }
+  whereSpace (wp);
+  field = whereField (wp);
+  if (wp->err != NULL) {
+    return;
+  }
+  if (field != NULL && field->op == DI_WHERE_STREQ) {
+    wp->err = "a string field may only be compared to a string";
+    return;
+  }
+  whereValue (wp, field);
+  whereEmit (wp, op, -1);
+}
+
+/* a numeric field or a number */
+static void
+whereValue (di_where_parse_t *wp, const di_where_field_t *field)
+{
+  di_where_ins_t  *ins;
+  char            *end;
+  const char      *ptr;
+  double          num;
+  int             power;
+  int             i;
+
+  if (field != NULL) {
+    ins = &wp->where->code [whereEmit (wp, field->op, 1)];
+    for (i = 0; i < 5; ++i) {
+      ins->arg [i] = field->arg [i];
+    }
+    if (field->op != DI_WHERE_FLAG) {
+      wp->where->usesValues = true;
+    }
+    return;
+  }
+
+  num = strtod (wp->p, &end);
+  if (end == wp->p) {
+    wp->err = "expected a field or a number";
+    return;
+  }
+  wp->p = end;
+  /* the size suffixes use the -B / --si block size */
+  power = 0;
+  if (*wp->p && (ptr = strchr (sizeSuffixes, tolower ((unsigned char) *wp->p))) != NULL) {
+    power = (int) (ptr - sizeSuffixes) + 1;
+  }
+  if (power > 0) {
+    ++wp->p;
+  }
+  for (i = 0; i < power; ++i) {
+    num *= (double) wp->blockSize;
+  }
+  if (isalnum ((unsigned char) *wp->p) || *wp->p == '_') {
+    wp->err = "bad number";
+    return;
+  }
+  ins = &wp->where->code [whereEmit (wp, DI_WHERE_NUM, 1)];
+  ins->num = num;
+}
+
+/* returns NULL if the next token is not a field name */
+static const di_where_field_t *
+whereField (di_where_parse_t *wp)
+{
+  const char  *p;
+  Size_t      len;
+  int         i;
+
+  p = wp->p;
+  while (isalnum ((unsigned char) *p) || *p == '_') {
+    ++p;
+  }
+  len = (Size_t) (p - wp->p);
+  if (len == 0 || isdigit ((unsigned char) *wp->p)) {
+    return NULL;
+  }
+  for (i = 0; i < DI_WHERE_FIELD_COUNT; ++i) {
+    if (strlen (whereFields [i].name) == len &&
+        strncmp (whereFields [i].name, wp->p, len) == 0) {
+      wp->p += len;
+      return &whereFields [i];
+    }
+  }
+  wp->err = "unknown field";
+  return NULL;
+}
+
+static int
+whereRelOp (di_where_parse_t *wp)
+{
+  int     op;
+
+  op = -1;
+  if (wp->p [0] == '<' && wp->p [1] == '=') {
+    op = DI_WHERE_LE;
+  } else if (wp->p [0] == '>' && wp->p [1] == '=') {
+    op = DI_WHERE_GE;
+  } else if (wp->p [0] == '=' && wp->p [1] == '=') {
+    op = DI_WHERE_EQ;
+  } else if (wp->p [0] == '!' && wp->p [1] == '=') {
+    op = DI_WHERE_NE;
+  } else if (wp->p [0] == '<') {
+    op = DI_WHERE_LT;
+  } else if (wp->p [0] == '>') {
+    op = DI_WHERE_GT;
+  }
+  if (op == DI_WHERE_LT || op == DI_WHERE_GT) {
+    wp->p += 1;
+  } else if (op >= 0) {
+    wp->p += 2;
+  }
+  return op;
+}
+
+static int
+whereStrOp (di_where_parse_t *wp)
+{
+  int     op;
+
+  op = -1;
+  if (wp->p [0] == '=' && wp->p [1] == '=') {
+    op = DI_WHERE_STREQ;
+  } else if (wp->p [0] == '!' && wp->p [1] == '=') {
+    op = DI_WHERE_STRNE;
+  } else if (wp->p [0] == '=' && wp->p [1] == '~') {
+    op = DI_WHERE_GLOB;
+  } else if (wp->p [0] == '!' && wp->p [1] == '~') {
+    op = DI_WHERE_NGLOB;
+  }
+  if (op >= 0) {
+    wp->p += 2;
+  }
+  return op;
+}
+
+/* the string is un-escaped in place in the copy of the expression */
+static char *
+whereString (di_where_parse_t *wp)
+{
+  char    quote;
+  char    *str;
+  char    *d;
+
+  quote = *wp->p;
+  if (quote != '"' && quote != '\'') {
+    wp->err = "expected a quoted string";
+    return NULL;
+  }
+  ++wp->p;
+  str = wp->p;
+  d = wp->p;
+  while (*wp->p && *wp->p != quote) {
+    if (*wp->p == '\\' && wp->p [1] != '\0') {
+      ++wp->p;
+    }
+    *d++ = *wp->p++;
+  }
+  if (*wp->p != quote) {
+    wp->err = "unterminated string";
+    return NULL;
+  }
+  ++wp->p;
+  *d = '\0';
+  return str;
+}
+
+static void
+whereSpace (di_where_parse_t *wp)
+{
+  while (isspace ((unsigned char) *wp->p)) {
+    ++wp->p;
+  }
+}
+
+/* delta is the change in the stack depth */
+static int
+whereEmit (di_where_parse_t *wp, int op, int delta)
+{
+  di_where_ins_t  *ins;
+  int             i;
+
+  ins = &wp->where->code [wp->where->count];
+  ins->op = op;
+  for (i = 0; i < 5; ++i) {
+    ins->arg [i] = DI_VALUE_NONE;
+  }
+  ins->num = 0.0;
+  ins->str = NULL;
+  wp->depth += delta;
+  if (wp->depth > DI_WHERE_STACK_MAX) {
+    wp->err = "the expression is too complex";
+  }
+  return wp->where->count++;
+}
+
 static void
 parseScaleValue (di_opt_t *diopts, const char *ptr)
 {
@@ -675,6 +1748,69 @@ parseScaleValue (di_opt_t *diopts, const char *ptr)
   }
 }
 
+/* a duration is a number followed by an optional 'ms' or 's'  */
+/* the default unit is milliseconds.  a fraction is allowed,    */
+/* e.g. 1.5s; it is not parsed with strtod (), as the decimal   */
+/* point depends on the locale.  returns -1 if it is not valid. */
+static int
+parseDuration (const char *arg, const char *str, long *val)
+{
+  const char  *ptr;
+  char        *end;
+  long        whole;
+  long        frac;
+  long        fracscale;
+  long        mult;
+  int         rc;
+
+  *val = 0;
+  rc = 0;
+  mult = 1;
+  whole = 0;
+  frac = 0;
+  fracscale = 1;
+
+  if (! isdigit ((unsigned char) *str)) {
+    rc = -1;
+  } else {
+    errno = 0;
+    whole = strtol (str, &end, 10);
+    if (errno == ERANGE) {
+      rc = -1;
+    }
+    ptr = end;
+    if (*ptr == '.') {
+      ++ptr;
+      if (! isdigit ((unsigned char) *ptr)) {
+        rc = -1;
+      }
+      /* anything past a millisecond is dropped */
+      while (isdigit ((unsigned char) *ptr)) {
+        if (fracscale < 1000) {
+          frac = frac * 10 + (*ptr - '0');
+          fracscale *= 10;
+        }
+        ++ptr;
+      }
+    }
+    if (strcmp (ptr, "s") == 0) {
+      mult = 1000;
+    } else if (*ptr != '\0' && strcmp (ptr, "ms") != 0) {
+      rc = -1;
+    }
+  }
+
+  if (rc == 0 && whole > (DI_DURATION_MAX - 1000) / mult) {
+    rc = -1;
+  }
+  if (rc != 0) {
+    fprintf (stderr, "di: %s: bad duration: %s\n", arg, str);
+    return rc;
+  }
+
+  *val = whole * mult + frac * mult / fracscale;
+  return 0;
+}
 
 static void
 setExitFlag (di_opt_t *diopts, int exitFlag)
@@ -739,10 +1875,24 @@ diopt_init (di_opt_t *diopts, struct pa_tmp *padata)
   /* valptr :  scalestr  */
   /* valsiz :  scalestrsz  */
 
+  diopts->opts [OPT_IDX_deadline].option = "--deadline";
+  diopts->opts [OPT_IDX_deadline].option_type = GETOPTN_FUNC_VALUE;
+  /* valptr : padata */
+  /* valfunc : processOptionsVal */
+
+  diopts->opts [OPT_IDX_exclude_path].option = "--exclude-path";
+  diopts->opts [OPT_IDX_exclude_path].option_type = GETOPTN_FUNC_VALUE;
+  /* valptr : padata */
+  /* valfunc : processOptionsVal */
+
   diopts->opts [OPT_IDX_f].option = "-f";
   diopts->opts [OPT_IDX_f].option_type = GETOPTN_STRPTR;
   diopts->opts [OPT_IDX_f].valptr = &diopts->formatString;
 
+  diopts->opts [OPT_IDX_files_from].option = "--files-from";
+  diopts->opts [OPT_IDX_files_from].option_type = GETOPTN_STRPTR;
+  diopts->opts [OPT_IDX_files_from].valptr = &diopts->filesFrom;
+
   diopts->opts [OPT_IDX_g].option = "-g";
   diopts->opts [OPT_IDX_g].option_type = GETOPTN_STRING;
   /* valptr :  scalestr  */
@@ -770,6 +1920,16 @@ diopt_init (di_opt_t *diopts, struct pa_tmp *padata)
   /* valptr : padata */
   /* valfunc : processOptionsVal */
 
+  diopts->opts [OPT_IDX_include_path].option = "--include-path";
+  diopts->opts [OPT_IDX_include_path].option_type = GETOPTN_FUNC_VALUE;
+  /* valptr : padata */
+  /* valfunc : processOptionsVal */
+
+  diopts->opts [OPT_IDX_interval].option = "--interval";
+  diopts->opts [OPT_IDX_interval].option_type = GETOPTN_FUNC_VALUE;
+  /* valptr : padata */
+  /* valfunc : processOptionsVal */
+
   diopts->opts [OPT_IDX_j].option = "-j";
   diopts->opts [OPT_IDX_j].option_type = GETOPTN_BOOL;
   diopts->opts [OPT_IDX_j].valptr = &diopts->optval [DI_OPT_DISP_JSON];
@@ -802,11 +1962,26 @@ diopt_init (di_opt_t *diopts, struct pa_tmp *padata)
   diopts->opts [OPT_IDX_n].valptr = &diopts->optval [DI_OPT_DISP_HEADER];
   diopts->opts [OPT_IDX_n].valsiz = sizeof (diopts->optval [DI_OPT_DISP_HEADER]);
 
+  diopts->opts [OPT_IDX_no_automount].option = "--no-automount";
+  diopts->opts [OPT_IDX_no_automount].option_type = GETOPTN_BOOL;
+  diopts->opts [OPT_IDX_no_automount].valptr = &diopts->noAutomount;
+  diopts->opts [OPT_IDX_no_automount].valsiz = sizeof (diopts->noAutomount);
+
   diopts->opts [OPT_IDX_P].option = "-P";
   diopts->opts [OPT_IDX_P].option_type = GETOPTN_FUNC_BOOL;
   /* valptr : padata */
   /* boolfunc : processOptions */
 
+  diopts->opts [OPT_IDX_probe_threads].option = "--probe-threads";
+  diopts->opts [OPT_IDX_probe_threads].option_type = GETOPTN_INT;
+  diopts->opts [OPT_IDX_probe_threads].valptr = &diopts->probeThreads;
+  diopts->opts [OPT_IDX_probe_threads].valsiz = sizeof (diopts->probeThreads);
+
+  diopts->opts [OPT_IDX_probe_timeout].option = "--probe-timeout";
+  diopts->opts [OPT_IDX_probe_timeout].option_type = GETOPTN_FUNC_VALUE;
+  /* valptr : padata */
+  /* valfunc : processOptionsVal */
+
   diopts->opts [OPT_IDX_q].option = "-q";
   diopts->opts [OPT_IDX_q].option_type = GETOPTN_BOOL;
   diopts->opts [OPT_IDX_q].valptr = &diopts->optval [DI_OPT_QUOTA_CHECK];
@@ -832,19 +2007,24 @@ diopt_init (di_opt_t *diopts, struct pa_tmp *padata)
   diopts->opts [OPT_IDX_t].valptr = &diopts->optval [DI_OPT_DISP_TOTALS] ;
   diopts->opts [OPT_IDX_t].valsiz = sizeof (diopts->optval [DI_OPT_DISP_TOTALS]);
 
+  diopts->opts [OPT_IDX_top].option = "--top";
+  diopts->opts [OPT_IDX_top].option_type = GETOPTN_INT;
+  diopts->opts [OPT_IDX_top].valptr = &diopts->topCount;
+  diopts->opts [OPT_IDX_top].valsiz = sizeof (diopts->topCount);
+
   diopts->opts [OPT_IDX_version].option = "--version";
   diopts->opts [OPT_IDX_version].option_type = GETOPTN_FUNC_BOOL;
   /* boolfunc : processOptions */
 
+  diopts->opts [OPT_IDX_where].option = "--where";
+  diopts->opts [OPT_IDX_where].option_type = GETOPTN_STRPTR;
+  diopts->opts [OPT_IDX_where].valptr = &diopts->whereString;
+
   diopts->opts [OPT_IDX_x].option = "-x";
   diopts->opts [OPT_IDX_x].option_type = GETOPTN_FUNC_VALUE;
   /* valptr : padata */
   /* valfunc : processOptionsVal */
 
-  diopts->opts [50].option = "--exclude-type";
-  diopts->opts [50].option_type = GETOPTN_ALIAS;
-  diopts->opts [50].valptr = (void *) "-x";
-
   diopts->opts [OPT_IDX_X].option = "-X";
   diopts->opts [OPT_IDX_X].option_type = GETOPTN_FUNC_VALUE;
   /* valptr : padata */
@@ -898,6 +2078,11 @@ diopt_init (di_opt_t *diopts, struct pa_tmp *padata)
   diopts->opts [c].valptr = (void *) "-C";
   ++c;
 
+  diopts->opts [c].option = "--exclude-type";
+  diopts->opts [c].option_type = GETOPTN_ALIAS;
+  diopts->opts [c].valptr = (void *) "-x";
+  ++c;
+
   diopts->opts [c].option = "--format-string";
   diopts->opts [c].option_type = GETOPTN_ALIAS;
   diopts->opts [c].valptr = (void *) "-f";
@@ -983,3 +2168,396 @@ diopt_init (di_opt_t *diopts, struct pa_tmp *padata)
   }
   diopts->optinit = true;
 }
+
+#if defined (TEST_DIOPTIONS)
+
+typedef struct
+{
+  const char  *pattern;
+  const char  *str;
+  int         expect;
+} dioptions_test_t;
+
+/* the patterns are anchored at both ends */
+static const dioptions_test_t globTests [] =
+{
+  { "abc",        "abc",        true },
+  { "abc",        "abcd",       false },
+  { "bc",         "abc",        false },
+  { "",           "",           true },
+  { "",           "a",          false },
+  { "*",          "",           true },
+  { "a*",         "abc",        true },
+  { "*c",         "abc",        true },
+  { "*b",         "abc",        false },
+  { "**c",        "abc",        true },
+  { "a*b*c",      "aXbYc",      true },
+  { "a*b*c",      "aXbY",       false },
+  { "a?c",        "abc",        true },
+  { "a?c",        "ac",         false },
+  { "/mnt/*",     "/mnt/a/b",   true },
+  { "/mnt/*",     "/mnt",       false },
+  { "[a-c]x",     "bx",         true },
+  { "[a-c]x",     "dx",         false },
+  { "[!a-c]x",    "dx",         true },
+  { "[^a-c]x",    "bx",         false },
+  { "[]]",        "]",          true },
+  { "[a-]",       "-",          true },
+  { "[abc",       "[abc",       true },
+  { "a\\*",       "a*",         true },
+  { "a\\*",       "ab",         false },
+};
+
+/* -x and -I: the pattern is the comma separated list */
+static const dioptions_test_t typeTests [] =
+{
+  { "nfs,tmpfs",  "nfs",        true },
+  { "nfs,tmpfs",  "tmpfs",      true },
+  { "nfs,tmpfs",  "nfs4",       false },
+  { "nfs,tmpfs",  "",           false },
+  { "fuse",       "fuse.sshfs", true },
+  { "fuse",       "fuseblk",    true },
+  { "fuse.sshfs", "fuse.sshfs", true },
+  { "fuse.sshfs", "fuse.rclone", false },
+  { "nfs*",       "nfs4",       true },
+  { "nfs*",       "nfs",        true },
+  { "nfs*",       "xnfs",       false },
+  { "tmp*,ext4",  "ext4",       true },
+  { "",           "nfs",        false },
+};
+
+/* --exclude-path and --include-path */
+static const dioptions_test_t pathTests [] =
+{
+  { "/mnt/a",     "/mnt/a",     true },
+  { "/mnt/a",     "/mnt/a/",    true },
+  { "/mnt/a/",    "/mnt/a",     true },
+  { "/mnt/a",     "/mnt/ab",    false },
+  { "/mnt/a",     "/mnt",       false },
+  { "/mnt/*",     "/mnt/a",     true },
+  { "/mnt/*",     "/mnt/a/b",   true },
+  { "/mnt/*",     "/mnt",       false },
+  { "/mnt/*",     "/mntx/a",    false },
+  { "/*",         "/a",         true },
+  { "/*",         "/",          false },
+  { "/mnt/?",     "/mnt/a",     true },
+  { "/mnt/?",     "/mnt/ab",    false },
+  { "/mnt/a*",    "/mnt/ab",    true },
+  { "/mnt/a*",    "/x/mnt/ab",  false },
+  { "/a,/b/*",    "/b/c",       true },
+  { "/a,/b/*",    "/c",         false },
+};
+
+#define DIOPT_TEST_COUNT(t) ((int) (sizeof (t) / sizeof (dioptions_test_t)))
+
+typedef struct
+{
+  const char  *expr;
+  int         blockSize;
+  const char  *code;                        /* NULL: a syntax error     */
+} dioptions_where_test_t;
+
+/*
+ * The compiled --where code is written as text by whereDump ().
+ * Precedence shows in the jump targets.  The fields are:
+ *   f0 local  f1 readonly  f2 loopback
+ *   s0 size  s0,1 used  s1 free  p0,2,0 percused
+ *   [0] mount  [2] fstype  [3] options
+ */
+static const dioptions_where_test_t whereTests [] =
+{
+  { "",                                 1024, "" },
+  { "local",                            1024, "f0" },
+  { "  local  ",                        1024, "f0" },
+  /* && binds more tightly than || */
+  { "local || readonly && loopback",    1024, "f0 jt5 f1 jf5 f2" },
+  { "local && readonly || loopback",    1024, "f0 jf3 f1 jt5 f2" },
+  { "(local || readonly) && loopback",  1024, "f0 jt3 f1 jf5 f2" },
+  { "local || readonly || loopback",    1024, "f0 jt5 f1 jt5 f2" },
+  { "local && readonly && loopback",    1024, "f0 jf5 f1 jf5 f2" },
+  /* ! binds more tightly than && */
+  { "!local && readonly",               1024, "f0 ! jf4 f1" },
+  { "!(local && readonly)",             1024, "f0 jf3 f1 !" },
+  { "!!local",                          1024, "f0 ! !" },
+  { "((local))",                        1024, "f0" },
+  /* the comparisons bind more tightly than && */
+  { "size>1k&&used<2M",                 1024, "s0 n1024 > jf7 s0,1 n2097152 <" },
+  { "size > 1k",                        1000, "s0 n1000 >" },
+  { "size >= 1.5G",                     1024, "s0 n1610612736 >=" },
+  { "10 < size",                        1024, "n10 s0 <" },
+  { "used <= free",                     1024, "s0,1 s1 <=" },
+  { "percused == 90.5",                 1024, "p0,2,0 n90.5 ==" },
+  { "percused != 0",                    1024, "p0,2,0 n0 !=" },
+  /* quoting */
+  { "fstype == \"nfs\"",                1024, "eq2[nfs]" },
+  { "fstype != 'nfs'",                  1024, "ne2[nfs]" },
+  { "fstype == 'a\"b'",                 1024, "eq2[a\"b]" },
+  { "fstype == \"a'b\"",                1024, "eq2[a'b]" },
+  { "fstype == \"a\\\"b\"",             1024, "eq2[a\"b]" },
+  { "mount == \"a\\\\b\"",              1024, "eq0[a\\b]" },
+  { "options == ''",                    1024, "eq3[]" },
+  { "mount =~ \"/mnt/*\"",              1024, "gl0[/mnt/*]" },
+  { "mount !~ '/x'",                    1024, "ng0[/x]" },
+  { "mount == '&&' || local",           1024, "eq0[&&] jt3 f0" },
+  /* syntax errors */
+  { "size >",                           1024, NULL },
+  { "size > 10x",                       1024, NULL },
+  { "size > k",                         1024, NULL },
+  { "(local",                           1024, NULL },
+  { "local)",                           1024, NULL },
+  { "bogus > 1",                        1024, NULL },
+  { "fstype > 1",                       1024, NULL },
+  { "size == fstype",                   1024, NULL },
+  { "fstype == nfs",                    1024, NULL },
+  { "fstype == \"nfs",                  1024, NULL },
+  { "local &&",                         1024, NULL },
+  { "local & readonly",                 1024, NULL },
+  { "local | readonly",                 1024, NULL },
+  { "size > 1 > 2",                     1024, NULL },
+  { "!",                                1024, NULL },
+  { "()",                               1024, NULL },
+};
+
+#define DIOPT_WHERE_TEST_COUNT \
+    ((int) (sizeof (whereTests) / sizeof (dioptions_where_test_t)))
+
+typedef struct
+{
+  const char  *str;
+  long        val;                          /* -1: not valid            */
+} dioptions_duration_test_t;
+
+/* --deadline, --interval and --probe-timeout */
+static const dioptions_duration_test_t durationTests [] =
+{
+  { "250",          250 },
+  { "250ms",        250 },
+  { "0",            0 },
+  { "2s",           2000 },
+  { "1.5s",         1500 },
+  { "0.25s",        250 },
+  { "1.2345s",      1234 },
+  { "1.5ms",        1 },
+  { "2147482s",     2147482000 },
+  { "",             -1 },
+  { "abc",          -1 },
+  { "5x",           -1 },
+  { "1m",           -1 },
+  { "1 s",          -1 },
+  { "1sec",         -1 },
+  { "1.",           -1 },
+  { ".5s",          -1 },
+  { "-5",           -1 },
+  { "+5",           -1 },
+  { "2147483s",     -1 },
+  { "99999999999999999999", -1 },
+};
+
+#define DIOPT_DURATION_TEST_COUNT \
+    ((int) (sizeof (durationTests) / sizeof (dioptions_duration_test_t)))
+
+static void
+whereDump (const di_where_t *where, char *buff, Size_t sz)
+{
+  static const char     *relops [] = { "<", "<=", ">", ">=", "==", "!=" };
+  static const char     *strops [] = { "eq", "ne", "gl", "ng" };
+  const di_where_ins_t  *ins;
+  char                  *p;
+  char                  *end;
+  int                   i;
+  int                   j;
+
+  p = buff;
+  end = buff + sz;
+  *p = '\0';
+  for (i = 0; i < where->count; ++i) {
+    ins = &where->code [i];
+    if (i > 0) {
+      p = stpecpy (p, end, " ");
+    }
+    switch (ins->op) {
+      case DI_WHERE_NUM: {
+        p += Snprintf1 (p, (Size_t) (end - p), "n%.17g", ins->num);
+        break;
+      }
+      case DI_WHERE_SPACE:
+      case DI_WHERE_PERC: {
+        p = stpecpy (p, end, ins->op == DI_WHERE_SPACE ? "s" : "p");
+        for (j = 0; j < 5 && ins->arg [j] != DI_VALUE_NONE; ++j) {
+          p += Snprintf2 (p, (Size_t) (end - p), "%s%d",
+              j > 0 ? "," : "", ins->arg [j]);
+        }
+        break;
+      }
+      case DI_WHERE_FLAG: {
+        p += Snprintf1 (p, (Size_t) (end - p), "f%d", ins->arg [0]);
+        break;
+      }
+      case DI_WHERE_STREQ:
+      case DI_WHERE_STRNE:
+      case DI_WHERE_GLOB:
+      case DI_WHERE_NGLOB: {
+        p += Snprintf3 (p, (Size_t) (end - p), "%s%d[%s]",
+            strops [ins->op - DI_WHERE_STREQ], ins->arg [0], ins->str);
+        break;
+      }
+      case DI_WHERE_NOT: {
+        p = stpecpy (p, end, "!");
+        break;
+      }
+      case DI_WHERE_JFALSE: {
+        p += Snprintf1 (p, (Size_t) (end - p), "jf%d", ins->arg [0]);
+        break;
+      }
+      case DI_WHERE_JTRUE: {
+        p += Snprintf1 (p, (Size_t) (end - p), "jt%d", ins->arg [0]);
+        break;
+      }
+      default: {
+        p = stpecpy (p, end, relops [ins->op - DI_WHERE_LT]);
+        break;
+      }
+    }
+  }
+}
+
+int
+main (int argc, char * argv [])
+{
+  di_strarr_t       list;
+  di_typefilter_t   tfilter;
+  di_pathfilter_t   pfilter;
+  di_opt_t          *diopts;
+  char              nest [DI_WHERE_STACK_MAX * 2 + 10];
+  char              buff [200];
+  int               nerr;
+  int               rc;
+  int               i;
+  int               grc = 0;
+  int               testno = 0;
+
+  for (i = 0; i < DIOPT_TEST_COUNT (globTests); ++i) {
+    ++testno;
+    rc = di_opt_glob_match (globTests [i].pattern, globTests [i].str);
+    if (rc != globTests [i].expect) {
+      fprintf (stderr, "fail test %d glob: %s %s\n", testno,
+          globTests [i].pattern, globTests [i].str);
+      grc = 1;
+    }
+  }
+
+  for (i = 0; i < DIOPT_TEST_COUNT (typeTests); ++i) {
+    ++testno;
+    list.count = 0;
+    list.list = NULL;
+    typesInit (&tfilter, 0);
+    if (parseList (&list, typeTests [i].pattern) != 0 ||
+        compileTypes (&tfilter, &list) != 0) {
+      fprintf (stderr, "fail test %d type: compile %s\n", testno,
+          typeTests [i].pattern);
+      grc = 1;
+    } else {
+      rc = di_opt_type_match (&tfilter, typeTests [i].str);
+      if (rc != typeTests [i].expect) {
+        fprintf (stderr, "fail test %d type: %s %s\n", testno,
+            typeTests [i].pattern, typeTests [i].str);
+        grc = 1;
+      }
+    }
+    typesFree (&tfilter);
+    freeList (&list);
+  }
+
+  for (i = 0; i < DIOPT_TEST_COUNT (pathTests); ++i) {
+    ++testno;
+    list.count = 0;
+    list.list = NULL;
+    pfilter.globs = NULL;
+    pfilter.globcount = 0;
+    if (parseList (&list, pathTests [i].pattern) != 0 ||
+        compilePaths (&pfilter, &list) != 0) {
+      fprintf (stderr, "fail test %d path: compile %s\n", testno,
+          pathTests [i].pattern);
+      grc = 1;
+    } else {
+      rc = di_opt_path_match (&pfilter, pathTests [i].str);
+      if (rc != pathTests [i].expect) {
+        fprintf (stderr, "fail test %d path: %s %s\n", testno,
+            pathTests [i].pattern, pathTests [i].str);
+        grc = 1;
+      }
+    }
+    strsetFree (&pfilter.exact);
+    strsetFree (&pfilter.below);
+    if (pfilter.globs != NULL) {
+      free (pfilter.globs);
+    }
+    freeList (&list);
+  }
+
+  diopts = di_init_options ();
+  nerr = 1;
+  for (i = 0; i < DIOPT_WHERE_TEST_COUNT; ++i) {
+    if (whereTests [i].code == NULL) {
+      ++nerr;
+    }
+  }
+  fprintf (stderr, "** expect %d --where errors\n", nerr);
+
+  for (i = 0; i < DIOPT_WHERE_TEST_COUNT; ++i) {
+    ++testno;
+    diopts->blockSize = whereTests [i].blockSize;
+    diopts->whereString = whereTests [i].expr;
+    rc = whereCompile (diopts);
+    if (whereTests [i].code == NULL) {
+      if (rc == 0) {
+        fprintf (stderr, "fail test %d where: no error: %s\n", testno,
+            whereTests [i].expr);
+        grc = 1;
+      }
+      continue;
+    }
+    whereDump (&diopts->where, buff, sizeof (buff));
+    if (rc != 0 || strcmp (buff, whereTests [i].code) != 0) {
+      fprintf (stderr, "fail test %d where: %s : %s\n", testno,
+          whereTests [i].expr, buff);
+      grc = 1;
+    }
+  }
+
+  /* the nesting is limited */
+  ++testno;
+  memset (nest, '(', DI_WHERE_STACK_MAX + 1);
+  stpecpy (nest + DI_WHERE_STACK_MAX + 1, nest + sizeof (nest), "local)");
+  diopts->whereString = nest;
+  if (whereCompile (diopts) == 0) {
+    fprintf (stderr, "fail test %d where: nesting not limited\n", testno);
+    grc = 1;
+  }
+
+  nerr = 0;
+  for (i = 0; i < DIOPT_DURATION_TEST_COUNT; ++i) {
+    if (durationTests [i].val < 0) {
+      ++nerr;
+    }
+  }
+  fprintf (stderr, "** expect %d duration errors\n", nerr);
+
+  for (i = 0; i < DIOPT_DURATION_TEST_COUNT; ++i) {
+    long    val;
+
+    ++testno;
+    rc = parseDuration ("--deadline", durationTests [i].str, &val);
+    if ((rc != 0) != (durationTests [i].val < 0) ||
+        (rc == 0 && val != durationTests [i].val)) {
+      fprintf (stderr, "fail test %d duration: %s : %d %ld\n", testno,
+          durationTests [i].str, rc, val);
+      grc = 1;
+    }
+  }
+
+  di_opt_cleanup (diopts);
+  return grc;
+}
+
+#endif /* TEST_DIOPTIONS */
@@ -23,18 +23,115 @@ typedef struct
   char    **list;
 } di_strarr_t;
 
+/* a hashed set of strings, see dioptions.c */
+typedef struct
+{
+  const char  **slots;                      /* NULL is an empty slot    */
+  Size_t      *lens;
+  Size_t      tsize;
+  Size_t      count;
+} di_strset_t;
+
+/* a compiled -x or -I list, or the remote filesystem types */
+typedef struct
+{
+  di_strset_t types;
+  int         fuse;                         /* 'fuse' matches fuse*     */
+  const char  **prefixes;                   /* the 'name*' entries      */
+  Size_t      prefixcount;
+} di_typefilter_t;
+
+/* a compiled --exclude-path or --include-path list */
+typedef struct
+{
+  di_strset_t exact;                        /* the mount points         */
+  di_strset_t below;                        /* the directories, for     */
+                                            /*   the mounts below them  */
+  char        **globs;                      /* the other patterns       */
+  Size_t      globcount;
+} di_pathfilter_t;
+
+/* --where : the predicate is compiled to a small stack machine */
+#define DI_WHERE_STACK_MAX      32
+
+#define DI_WHERE_NUM            0   /* push num                     */
+#define DI_WHERE_SPACE          1   /* push a value, arg [0..2]     */
+#define DI_WHERE_PERC           2   /* push a percentage, arg [0..4] */
+#define DI_WHERE_FLAG           3   /* push a flag, arg [0]         */
+#define DI_WHERE_STREQ          4   /* push string arg [0] == str   */
+#define DI_WHERE_STRNE          5
+#define DI_WHERE_GLOB           6   /* push string arg [0] =~ str   */
+#define DI_WHERE_NGLOB          7
+#define DI_WHERE_LT             8   /* pop two, push the result     */
+#define DI_WHERE_LE             9
+#define DI_WHERE_GT             10
+#define DI_WHERE_GE             11
+#define DI_WHERE_EQ             12
+#define DI_WHERE_NE             13
+#define DI_WHERE_NOT            14
+#define DI_WHERE_JFALSE         15  /* jump to arg [0] if false,    */
+#define DI_WHERE_JTRUE          16  /*   otherwise pop              */
+
+#define DI_WHERE_FLAG_LOCAL     0
+#define DI_WHERE_FLAG_READONLY  1
+#define DI_WHERE_FLAG_LOOPBACK  2
+
+typedef struct
+{
+  int         op;
+  int         arg [5];
+  double      num;
+  const char  *str;
+} di_where_ins_t;
+
+typedef struct
+{
+  di_where_ins_t  *code;
+  char            *text;                    /* the string constants     */
+  int             count;
+  int             usesValues;
+  int             usesOptions;
+} di_where_t;
+
 typedef struct di_opt {
   getoptn_opt_t   *opts;
   const char      ** argv;
   const char      *formatString;
+  /* file of path names to report on, "-" for stdin */
+  const char      *filesFrom;
   char            *diargsptr;
   di_strarr_t     exclude_list;
   di_strarr_t     include_list;
+  di_strarr_t     exclude_path_list;
+  di_strarr_t     include_path_list;
+  /* DI_REMOTE_FSTYPES, added to the built-in remote types */
+  di_strarr_t     remote_list;
+  /* the lists above, compiled once the options are processed */
+  di_typefilter_t exclude_types;
+  di_typefilter_t include_types;
+  di_typefilter_t remote_types;
+  di_pathfilter_t exclude_paths;
+  di_pathfilter_t include_paths;
+  /* --where */
+  const char      *whereString;
+  di_where_t      where;
   char            zoneDisplay [DI_MAXPATH];
   int             optinit;
   /* will be either 1000 or 1024 */
   int             blockSize;
   int             scale;
+  /* number of threads used to fetch the disk space */
+  int             probeThreads;
+  /* per-mount probe timeout in milliseconds */
+  long            probeTimeout;
+  /* wall-clock budget for collecting all of the data, milliseconds */
+  long            deadline;
+  /* interval sampling: time between samples, milliseconds */
+  long            interval;
+  /* display only the first N entries in sort order, 0 for all */
+  int             topCount;
+  /* do not automount the file arguments */
+  int             noAutomount;
   char            sortType [DI_SORT_TYPE_MAX];
   int             optval [DI_OPT_MAX];
   int             exitFlag;
@@ -51,6 +148,9 @@ extern int di_get_options (int argc, const char * argv [], di_opt_t *diopts, int
 extern void di_opt_format_iter_init (di_opt_t *diopts);
 extern int di_opt_format_iterate (di_opt_t *diopts);
 int di_opt_check_option (di_opt_t *diopts, int optidx);
+extern int di_opt_type_match (const di_typefilter_t *filter, const char *fstype);
+extern int di_opt_path_match (const di_pathfilter_t *filter, const char *path);
+extern int di_opt_glob_match (const char *pattern, const char *str);
 
 # if defined (__cplusplus) || defined (c_plusplus)
 }
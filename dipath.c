@@ -0,0 +1,602 @@
+/* Copyright 2026 Brad Lanam Pleasant Hill CA */
+
+/*
+ *
+ *    Path to mount resolution.
+ *
+ *    On linux, statx () returns the id of the mount the path is on.
+ *    Bind mounts share the device number, and the mount id is the
+ *    only exact match.  The mountinfo and statmount () backends
+ *    save the mount ids in the disk info entries, and the index is
+ *    built from those on the first lookup.
+ *
+ *    When there are many paths, the linux io_uring interface is
+ *    used to submit the statx () calls in batches, so that each
+ *    batch is a few system calls rather than one or more per path.
+ *
+ *    di_path_stat ()
+ *        get the device number and, where available, the mount id
+ *        of a path.
+ *    di_path_ring_open ()
+ *        set up the batch interface, returns NULL if not available.
+ *    di_path_stat_batch ()
+ *        di_path_stat () for a list of paths.
+ *    di_path_ring_close ()
+ *        release the batch interface.
+ *    di_mntid_index_init ()
+ *        initialize an empty mount id index.
+ *    di_mntid_index_find ()
+ *        find the entry for a mount id.
+ *    di_mntid_index_free ()
+ *        release the mount id index.
+ *
+ */
+
+/* linux: statx () */
+#if (defined (linux) || defined (__linux__)) && ! defined (_GNU_SOURCE)
+# define _GNU_SOURCE 1
+#endif
+
+#include "config.h"
+
+#if _hdr_stdio
+# include <stdio.h>
+#endif
+#if _hdr_stdlib
+# include <stdlib.h>
+#endif
+#if _hdr_stdbool
+# include <stdbool.h>
+#endif
+#if _sys_types \
+    && ! defined (DI_INC_SYS_TYPES_H) /* xenix */
+# define DI_INC_SYS_TYPES_H
+# include <sys/types.h>
+#endif
+#if _hdr_string
+# include <string.h>
+#endif
+#if _hdr_strings
+# include <strings.h>
+#endif
+#if _hdr_memory
+# include <memory.h>
+#endif
+#if _hdr_malloc
+# include <malloc.h>
+#endif
+#if _hdr_errno
+# include <errno.h>
+#endif
+#if _hdr_unistd
+# include <unistd.h>
+#endif
+#if _sys_stat
+# include <sys/stat.h>
+#endif
+#if _sys_sysmacros
+# include <sys/sysmacros.h>
+#endif
+#if _hdr_fcntl && ! defined (DI_INC_FCNTL_H)    /* xenix */
+# include <fcntl.h>     /* O_RDONLY, O_NOCTTY, AT_FDCWD */
+#endif
+
+#include "di.h"
+#include "disystem.h"
+#include "diinternal.h"
+#include "dimath.h"
+#include "dimath_mp.h"
+
+#if _lib_statx && _mem_struct_statx_stx_mnt_id
+# define DI_USE_STATX 1
+/* linux 5.8 */
+# if ! defined (STATX_MNT_ID)
+#  define STATX_MNT_ID 0x00001000U
+# endif
+/* linux 6.8 */
+# if ! defined (STATX_MNT_ID_UNIQUE)
+#  define STATX_MNT_ID_UNIQUE 0x00004000U
+# endif
+# if ! defined (AT_NO_AUTOMOUNT)
+#  define AT_NO_AUTOMOUNT 0x800
+# endif
+#endif
+
+#if defined (DI_USE_STATX) && _hdr_linux_io_uring && _sys_mman \
+    && _lib_syscall && _sys_syscall && defined (__GNUC__)
+# include <sys/mman.h>
+# include <sys/syscall.h>
+# include <linux/io_uring.h>
+/* IORING_OP_STATX was added in linux 5.6, along with this flag */
+# if defined (IORING_FEAT_RW_CUR_POS)
+#  define DI_USE_IO_URING 1
+# endif
+# if ! defined (__NR_io_uring_setup) && ! defined (__alpha__)
+#  define __NR_io_uring_setup 425
+# endif
+# if ! defined (__NR_io_uring_enter) && ! defined (__alpha__)
+#  define __NR_io_uring_enter 426
+# endif
+# if ! defined (__NR_io_uring_setup) || ! defined (__NR_io_uring_enter)
+#  undef DI_USE_IO_URING
+# endif
+#endif
+
+#if ! defined (O_NOCTTY)
+# define O_NOCTTY 0
+#endif
+
+struct di_path_ring {
+#if defined (DI_USE_IO_URING)
+  int                 fd;
+  unsigned int        entries;
+  int                 failed;
+  int                 inflight;
+  void                *sqptr;
+  Size_t              sqsz;
+  void                *cqptr;
+  Size_t              cqsz;
+  struct io_uring_sqe *sqes;
+  Size_t              sqesz;
+  unsigned int        *sqtail;
+  unsigned int        *sqmask;
+  unsigned int        *sqarray;
+  unsigned int        *cqhead;
+  unsigned int        *cqtail;
+  unsigned int        *cqmask;
+  struct io_uring_cqe *cqes;
+  /* one result buffer for each submission queue entry */
+  struct statx        *stx;
+#else
+  int                 unused;
+#endif
+};
+
+#if defined (DI_USE_STATX)
+static int  statxFlags (int);
+static void statxResult (struct statx *, di_path_stat_t *);
+#endif
+#if defined (DI_USE_IO_URING)
+static int  ringEnter (di_path_ring_t *, unsigned int, unsigned int, unsigned int);
+static int  ringReap (di_path_ring_t *, int, const char **, int, di_path_stat_t *, int *);
+#endif
+static int  mntidIndexBuild (di_data_t *);
+static di_mntid_slot_t *mntidFind (di_mntid_slot_t *, Size_t, di_mntid_t);
+
+/*
+ * The default is to allow the path to be automounted, as the
+ * file system the user is asking about is the one that will
+ * be mounted.  With DI_PATH_NO_AUTOMOUNT, an automount point is
+ * reported as the automounter's file system.
+ */
+
+int
+di_path_stat (const char *path, int flags, di_path_stat_t *ps)
+{
+  int           rc;
+  int           fd;
+  struct stat   statBuf;
+
+  ps->st_dev = 0;
+  ps->mntId = 0;
+  ps->mntIdType = DI_MNTID_NONE;
+
+#if defined (DI_USE_STATX)
+  {
+    struct statx  stx;
+
+    /* an older kernel ignores the mask bits it does not know */
+    rc = statx (AT_FDCWD, path, statxFlags (flags),
+        STATX_MNT_ID | STATX_MNT_ID_UNIQUE, &stx);
+    if (rc == 0) {
+      statxResult (&stx, ps);
+      return 0;
+    }
+    if (errno != ENOSYS && errno != EINVAL) {
+      return rc;
+    }
+  }
+#endif
+
+  fd = -1;
+  if ((flags & DI_PATH_NO_AUTOMOUNT) != DI_PATH_NO_AUTOMOUNT) {
+    /* do this to automount devices.                    */
+    /* stat () will not necessarily cause an automount.  */
+    fd = open (path, O_RDONLY | O_NOCTTY);
+  }
+  if (fd < 0) {
+    rc = stat (path, &statBuf);
+  } else {
+    rc = fstat (fd, &statBuf);
+    close (fd);
+  }
+  if (rc == 0) {
+    ps->st_dev = (unsigned long) statBuf.st_dev;
+  }
+  return rc;
+}
+
+/* returns NULL if the batch interface is not available */
+di_path_ring_t *
+di_path_ring_open (int entries)
+{
+#if defined (DI_USE_IO_URING)
+  di_path_ring_t          *ring;
+  struct io_uring_params  params;
+  char                    *p;
+
+  ring = (di_path_ring_t *) malloc (sizeof (di_path_ring_t));
+  if (ring == NULL) {
+    return NULL;
+  }
+  memset (&params, 0, sizeof (params));
+  ring->fd = (int) syscall (__NR_io_uring_setup, (unsigned int) entries, &params);
+  if (ring->fd < 0) {
+    /* not supported, or disabled */
+    free (ring);
+    return NULL;
+  }
+  ring->entries = params.sq_entries;
+  ring->failed = false;
+  ring->inflight = false;
+  ring->sqsz = params.sq_off.array + params.sq_entries * sizeof (unsigned int);
+  ring->cqsz = params.cq_off.cqes + params.cq_entries * sizeof (struct io_uring_cqe);
+  if ((params.features & IORING_FEAT_SINGLE_MMAP) == IORING_FEAT_SINGLE_MMAP) {
+    if (ring->cqsz > ring->sqsz) {
+      ring->sqsz = ring->cqsz;
+    }
+    ring->cqsz = 0;
+  }
+  ring->sqesz = params.sq_entries * sizeof (struct io_uring_sqe);
+  ring->sqes = MAP_FAILED;
+  ring->cqptr = MAP_FAILED;
+  ring->stx = (struct statx *) malloc (sizeof (struct statx) * ring->entries);
+
+  ring->sqptr = mmap (NULL, ring->sqsz, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  if (ring->sqptr != MAP_FAILED) {
+    ring->cqptr = ring->sqptr;
+    if (ring->cqsz > 0) {
+      ring->cqptr = mmap (NULL, ring->cqsz, PROT_READ | PROT_WRITE,
+          MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    }
+    ring->sqes = (struct io_uring_sqe *) mmap (NULL, ring->sqesz,
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        ring->fd, IORING_OFF_SQES);
+  }
+  if (ring->sqptr == MAP_FAILED || ring->cqptr == MAP_FAILED ||
+      ring->sqes == MAP_FAILED || ring->stx == NULL) {
+    di_path_ring_close (ring);
+    return NULL;
+  }
+
+  p = (char *) ring->sqptr;
+  ring->sqtail = (unsigned int *) (p + params.sq_off.tail);
+  ring->sqmask = (unsigned int *) (p + params.sq_off.ring_mask);
+  ring->sqarray = (unsigned int *) (p + params.sq_off.array);
+  p = (char *) ring->cqptr;
+  ring->cqhead = (unsigned int *) (p + params.cq_off.head);
+  ring->cqtail = (unsigned int *) (p + params.cq_off.tail);
+  ring->cqmask = (unsigned int *) (p + params.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe *) (p + params.cq_off.cqes);
+  return ring;
+#else
+  return NULL;
+#endif
+}
+
+/*
+ * errs [i] is set to 0 or the errno value for each path.
+ * the ring may be NULL, and each path is done in turn.
+ */
+
+void
+di_path_stat_batch (di_path_ring_t *ring, int count, const char **paths,
+    int flags, di_path_stat_t *ps, int *errs)
+{
+  int     done;
+  int     i;
+
+  done = 0;
+
+#if defined (DI_USE_IO_URING)
+  while (ring != NULL && ! ring->failed && done < count) {
+    unsigned int        n;
+    unsigned int        tail;
+    unsigned int        idx;
+    unsigned int        submitted;
+    int                 completed;
+    int                 rc;
+    struct io_uring_sqe *sqe;
+
+    n = (unsigned int) (count - done);
+    if (n > ring->entries) {
+      n = ring->entries;
+    }
+
+    tail = *ring->sqtail;
+    for (i = 0; i < (int) n; ++i) {
+      idx = (tail + (unsigned int) i) & *ring->sqmask;
+      sqe = &ring->sqes [idx];
+      memset (sqe, 0, sizeof (struct io_uring_sqe));
+      sqe->opcode = IORING_OP_STATX;
+      sqe->fd = AT_FDCWD;
+      sqe->addr = (unsigned long) paths [done + i];
+      sqe->len = STATX_MNT_ID | STATX_MNT_ID_UNIQUE;
+      sqe->off = (unsigned long) &ring->stx [i];
+      sqe->statx_flags = (unsigned int) statxFlags (flags);
+      sqe->user_data = (unsigned int) i;
+      ring->sqarray [idx] = idx;
+    }
+    __atomic_store_n (ring->sqtail, tail + n, __ATOMIC_RELEASE);
+
+    /* the entries must all be reaped before the buffers are re-used */
+    submitted = 0;
+    completed = 0;
+    while (submitted < n) {
+      rc = ringEnter (ring, n - submitted, 0, 0);
+      if (rc <= 0) {
+        break;
+      }
+      submitted += (unsigned int) rc;
+    }
+    if (submitted < n) {
+      /* the remainder are done in turn, the ring is not used again */
+      ring->failed = true;
+    }
+    while (completed < (int) submitted) {
+      rc = ringReap (ring, done, paths, flags, ps, errs);
+      completed += rc;
+      if (rc == 0 &&
+          ringEnter (ring, 0, submitted - (unsigned int) completed,
+          IORING_ENTER_GETEVENTS) < 0 &&
+          errno != EINTR) {
+        /* should not happen; the result buffers may still be in use */
+        ring->failed = true;
+        ring->inflight = true;
+        break;
+      }
+    }
+    if (completed < (int) submitted) {
+      break;
+    }
+    done += (int) submitted;
+  }
+#endif
+
+  for (i = done; i < count; ++i) {
+    errs [i] = 0;
+    if (di_path_stat (paths [i], flags, &ps [i]) != 0) {
+      errs [i] = errno;
+    }
+  }
+}
+
+void
+di_path_ring_close (di_path_ring_t *ring)
+{
+#if defined (DI_USE_IO_URING)
+  if (ring == NULL) {
+    return;
+  }
+  if (ring->sqes != MAP_FAILED) {
+    munmap (ring->sqes, ring->sqesz);
+  }
+  if (ring->cqptr != MAP_FAILED && ring->cqptr != ring->sqptr) {
+    munmap (ring->cqptr, ring->cqsz);
+  }
+  if (ring->sqptr != MAP_FAILED) {
+    munmap (ring->sqptr, ring->sqsz);
+  }
+  /* do not free buffers the kernel may still write to */
+  if (ring->stx != NULL && ! ring->inflight) {
+    free (ring->stx);
+  }
+  close (ring->fd);
+  free (ring);
+#else
+  if (ring != NULL) {
+    free (ring);
+  }
+#endif
+}
+
+void
+di_mntid_index_init (di_mntid_index_t *mntidx)
+{
+  mntidx->slots = NULL;
+  mntidx->tsize = 0;
+  mntidx->count = 0;
+  mntidx->valid = false;
+}
+
+/* returns the entry index, or -1 */
+int
+di_mntid_index_find (di_data_t *di_data, di_mntid_t id, int idtype)
+{
+  di_mntid_index_t  *mntidx;
+  di_mntid_slot_t   *slot;
+
+  mntidx = &di_data->mntidx;
+  if (idtype == DI_MNTID_NONE) {
+    return -1;
+  }
+  if (! mntidx->valid || mntidx->count != di_data->fscount) {
+    if (mntidIndexBuild (di_data) < 0) {
+      return -1;
+    }
+  }
+
+  slot = mntidFind (mntidx->slots + (idtype == DI_MNTID_UNIQUE ? mntidx->tsize : 0),
+      mntidx->tsize, id);
+  return slot->idx;
+}
+
+void
+di_mntid_index_free (di_mntid_index_t *mntidx)
+{
+  if (mntidx->slots != NULL) {
+    free (mntidx->slots);
+  }
+  di_mntid_index_init (mntidx);
+}
+
+static int
+mntidIndexBuild (di_data_t *di_data)
+{
+  di_mntid_index_t  *mntidx;
+  di_disk_info_t    *dinfo;
+  di_mntid_slot_t   *slot;
+  Size_t            tsize;
+  Size_t            h;
+  int               i;
+
+  mntidx = &di_data->mntidx;
+
+  tsize = 16;
+  while (tsize < (Size_t) di_data->fscount * 2) {
+    tsize *= 2;
+  }
+  if (tsize != mntidx->tsize) {
+    di_mntid_index_free (mntidx);
+    mntidx->slots = (di_mntid_slot_t *) malloc (sizeof (di_mntid_slot_t) * tsize * 2);
+    if (mntidx->slots == NULL) {
+      fprintf (stderr, "malloc failed in di_mntid_index_find.  errno %d\n", errno);
+      return -1;
+    }
+    mntidx->tsize = tsize;
+  }
+  for (h = 0; h < tsize * 2; ++h) {
+    mntidx->slots [h].id = 0;
+    mntidx->slots [h].idx = -1;
+  }
+
+  for (i = 0; i < di_data->fscount; ++i) {
+    dinfo = &di_data->diskInfo [i];
+    if (! dinfo->hasMntId) {
+      continue;
+    }
+    slot = mntidFind (mntidx->slots, tsize, (di_mntid_t) dinfo->mntId);
+    if (slot->idx < 0) {
+      slot->id = (di_mntid_t) dinfo->mntId;
+      slot->idx = i;
+    }
+    if (dinfo->mntUniqueId != 0) {
+      slot = mntidFind (mntidx->slots + tsize, tsize, dinfo->mntUniqueId);
+      if (slot->idx < 0) {
+        slot->id = dinfo->mntUniqueId;
+        slot->idx = i;
+      }
+    }
+  }
+
+  mntidx->count = di_data->fscount;
+  mntidx->valid = true;
+  return 0;
+}
+
+#if defined (DI_USE_STATX)
+
+static int
+statxFlags (int flags)
+{
+  int     atflags;
+
+  atflags = AT_STATX_SYNC_AS_STAT;
+  if ((flags & DI_PATH_NO_AUTOMOUNT) == DI_PATH_NO_AUTOMOUNT) {
+    atflags |= AT_NO_AUTOMOUNT;
+  }
+  return atflags;
+}
+
+static void
+statxResult (struct statx *stx, di_path_stat_t *ps)
+{
+# if defined (makedev)
+  ps->st_dev = (unsigned long) makedev (stx->stx_dev_major, stx->stx_dev_minor);
+# else
+  ps->st_dev = ((unsigned long) stx->stx_dev_major << 8) | stx->stx_dev_minor;
+# endif
+  ps->mntId = 0;
+  ps->mntIdType = DI_MNTID_NONE;
+  if ((stx->stx_mask & STATX_MNT_ID_UNIQUE) == STATX_MNT_ID_UNIQUE) {
+    ps->mntId = (di_mntid_t) stx->stx_mnt_id;
+    ps->mntIdType = DI_MNTID_UNIQUE;
+  } else if ((stx->stx_mask & STATX_MNT_ID) == STATX_MNT_ID) {
+    ps->mntId = (di_mntid_t) stx->stx_mnt_id;
+    ps->mntIdType = DI_MNTID_OLD;
+  }
+}
+
+#endif /* DI_USE_STATX */
+
+#if defined (DI_USE_IO_URING)
+
+static int
+ringEnter (di_path_ring_t *ring, unsigned int tosubmit,
+    unsigned int mincomplete, unsigned int flags)
+{
+  int     rc;
+
+  rc = (int) syscall (__NR_io_uring_enter, ring->fd, tosubmit,
+      mincomplete, flags, NULL, 0);
+  return rc;
+}
+
+/* returns the number of completions processed */
+static int
+ringReap (di_path_ring_t *ring, int offset, const char **paths,
+    int flags, di_path_stat_t *ps, int *errs)
+{
+  unsigned int        head;
+  unsigned int        tail;
+  int                 count;
+  int                 i;
+  int                 res;
+  struct io_uring_cqe *cqe;
+
+  count = 0;
+  head = *ring->cqhead;
+  tail = __atomic_load_n (ring->cqtail, __ATOMIC_ACQUIRE);
+  while (head != tail) {
+    cqe = &ring->cqes [head & *ring->cqmask];
+    i = (int) cqe->user_data;
+    res = cqe->res;
+    errs [offset + i] = 0;
+    if (res == 0) {
+      statxResult (&ring->stx [i], &ps [offset + i]);
+    } else if (res == -EINVAL || res == -EOPNOTSUPP) {
+      /* IORING_OP_STATX is not supported */
+      ring->failed = true;
+      if (di_path_stat (paths [offset + i], flags, &ps [offset + i]) != 0) {
+        errs [offset + i] = errno;
+      }
+    } else {
+      errs [offset + i] = -res;
+    }
+    ++head;
+    ++count;
+  }
+  __atomic_store_n (ring->cqhead, head, __ATOMIC_RELEASE);
+  return count;
+}
+
+#endif /* DI_USE_IO_URING */
+
+/* returns the matching slot, or the empty slot to fill in */
+static di_mntid_slot_t *
+mntidFind (di_mntid_slot_t *table, Size_t tsize, di_mntid_t id)
+{
+  Size_t            h;
+  di_mntid_slot_t   *slot;
+
+  h = (Size_t) ((id ^ (id >> 20)) * 2654435761UL);
+  h &= tsize - 1;
+  for (;;) {
+    slot = &table [h];
+    if (slot->idx < 0 || slot->id == id) {
+      return slot;
+    }
+    h = (h + 1) & (tsize - 1);
+  }
+}
@@ -0,0 +1,536 @@
+/* Copyright 2026 Brad Lanam Pleasant Hill CA */
+
+/*
+ *
+ *    di_probe_run ()
+ *        Runs the probe function (statvfs (), stat (), etc.) for each
+ *        of the paths.  If more than one probe thread is configured,
+ *        the probes are handed out to a pool of worker threads.
+ *
+ *        If a probe timeout is configured, the probes are always
+ *        run in helper threads.  A probe that does not finish within
+ *        the timeout is abandoned and its status is set to
+ *        DI_PROBE_TIMEOUT.  A hung NFS or FUSE mount will then only
+ *        hold up its own helper thread.
+ *
+ *        If a deadline is set (di_data->deadlineAt), any probe that
+ *        has not finished by then is given up on and its status is
+ *        set to DI_PROBE_STALE.  The local file systems are probed
+ *        before the remote file systems, so that the cheap probes
+ *        are not starved by a slow network mount.
+ *
+ *        paths [i] must correspond to di_data->diskInfo [i].
+ *
+ *        results [i] is passed to the probe function as it was set
+ *        by the caller, so it may hold the input for the probe.
+ *        If a probe finishes after di_probe_run () has returned,
+ *        nobody collects its result, and freefunc (if not NULL)
+ *        is called to release whatever the result holds.
+ *
+ *        The probe function must only fill in its own result.
+ *        Any processing of the results (dinum_t values, printFlag)
+ *        is done by the caller afterwards, in partition order, so
+ *        the output order does not change.
+ *
+ */
+
+#include "config.h"
+
+#if _hdr_stdio
+# include <stdio.h>
+#endif
+#if _hdr_stdlib
+# include <stdlib.h>
+#endif
+#if _hdr_stdbool
+# include <stdbool.h>
+#endif
+#if _hdr_errno
+# include <errno.h>
+#endif
+#if _hdr_string
+# include <string.h>
+#endif
+#if _hdr_strings
+# include <strings.h>
+#endif
+#if _hdr_time
+# include <time.h>
+#endif
+#if _hdr_pthread && _lib_pthread_create
+# include <pthread.h>
+#endif
+
+#include "di.h"
+#include "disystem.h"
+#include "diinternal.h"
+#include "dioptions.h"
+
+#if _hdr_pthread && _lib_pthread_create && _lib_clock_gettime
+# define DI_PROBE_THREADS 1
+#endif
+
+#if defined (DI_PROBE_THREADS)
+
+# if _lib_pthread_condattr_setclock && defined (CLOCK_MONOTONIC)
+#  define DI_PROBE_CLOCK CLOCK_MONOTONIC
+# else
+#  define DI_PROBE_CLOCK CLOCK_REALTIME
+# endif
+
+# define DI_JOB_NONE        0
+# define DI_JOB_PENDING     1
+# define DI_JOB_RUNNING     2
+# define DI_JOB_DONE        3
+# define DI_JOB_ABANDONED   4
+/* the result was copied to the caller */
+# define DI_JOB_TAKEN       5
+/* an abandoned probe finished, its result is not used */
+# define DI_JOB_LOST        6
+
+typedef struct {
+  char              *path;
+  di_ms_t           started;
+  int               state;
+} di_probe_job_t;
+
+/* The pool is shared with the worker threads.  It is freed by */
+/* whoever drops the last reference, as an abandoned worker    */
+/* may still be running after di_probe_run () has returned.    */
+typedef struct {
+  pthread_mutex_t   lock;
+  pthread_cond_t    cond;
+  di_probe_func_t   probefunc;
+  di_probe_free_t   freefunc;
+  di_probe_job_t    *jobs;
+  int               *order;
+  char              *results;
+  Size_t            ressz;
+  int               count;
+  int               nextidx;
+  int               remaining;
+  int               refcount;
+  int               finished;
+} di_probe_pool_t;
+
+static di_probe_pool_t * probePoolAlloc (int, const char * [], const int *, di_probe_func_t, di_probe_free_t, void *, Size_t);
+static void probePoolRelease (di_probe_pool_t *);
+static int  probeStartWorker (di_probe_pool_t *);
+static void * probeWorker (void *);
+static void probeTimespec (di_ms_t, struct timespec *);
+
+#endif
+
+static int  * probeOrder (di_data_t *, int);
+
+void
+di_probe_run (di_data_t *di_data, int count, const char *paths [],
+    di_probe_func_t probefunc, di_probe_free_t freefunc,
+    void *results, Size_t ressz, int *status)
+{
+  di_opt_t    *diopts;
+  int         *order;
+  int         i;
+  int         idx;
+
+  diopts = (di_opt_t *) di_data->options;
+
+  idx = 0;
+  for (i = 0; i < count; ++i) {
+    status [i] = DI_PROBE_SKIP;
+    if (paths [i] != NULL) {
+      ++idx;
+    }
+  }
+  if (idx == 0) {
+    /* nothing to do */
+    return;
+  }
+
+  order = probeOrder (di_data, count);
+  if (order == NULL) {
+    return;
+  }
+
+#if defined (DI_PROBE_THREADS)
+  if ((diopts->probeThreads > 1 && count > 1) ||
+      diopts->probeTimeout > 0 ||
+      di_data->deadlineAt > 0) {
+    di_probe_pool_t *pool;
+    int             tcount;
+
+    tcount = diopts->probeThreads;
+    if (tcount < 1) {
+      tcount = 1;
+    }
+    if (tcount > count) {
+      tcount = count;
+    }
+    if (tcount > DI_PROBE_MAX_THREADS) {
+      tcount = DI_PROBE_MAX_THREADS;
+    }
+
+    pool = NULL;
+    if (di_data->deadlineAt <= 0 || di_probe_now () < di_data->deadlineAt) {
+      pool = probePoolAlloc (count, paths, order, probefunc, freefunc,
+          results, ressz);
+    }
+    if (pool != NULL) {
+      int     live;
+      int     expired;
+      int     rc;
+
+      if (diopts->optval [DI_OPT_DEBUG] > 0) {
+        printf ("# di_probe_run: threads: %d timeout: %ldms\n",
+            tcount, (long) diopts->probeTimeout);
+      }
+
+      pthread_mutex_lock (&pool->lock);
+      live = 0;
+      rc = 0;
+      for (i = 0; i < tcount; ++i) {
+        rc = probeStartWorker (pool);
+        if (rc != 0) {
+          break;
+        }
+        ++live;
+      }
+
+      if (rc != 0 && diopts->optval [DI_OPT_DEBUG] > 0) {
+        /* pthread_create () returns the error, errno is not set */
+        printf ("# di_probe_run: thread create failed: %s (%d started)\n",
+            strerror (rc), live);
+      }
+
+      if (live == 0) {
+        /* no threads could be started, run the probes here */
+        pthread_mutex_unlock (&pool->lock);
+        probePoolRelease (pool);
+        pool = NULL;
+      }
+
+      expired = false;
+      while (pool != NULL && live > 0 && pool->remaining > 0) {
+        di_ms_t         now;
+        di_ms_t         waituntil;
+        struct timespec ts;
+
+        if (diopts->probeTimeout <= 0 && di_data->deadlineAt <= 0) {
+          pthread_cond_wait (&pool->cond, &pool->lock);
+          continue;
+        }
+
+        now = di_probe_now ();
+        if (di_data->deadlineAt > 0 && now >= di_data->deadlineAt) {
+          if (diopts->optval [DI_OPT_DEBUG] > 0) {
+            printf ("# di_probe_run: deadline reached: %d left\n",
+                pool->remaining);
+          }
+          expired = true;
+          break;
+        }
+
+        waituntil = di_data->deadlineAt;
+        if (diopts->probeTimeout > 0 &&
+            (waituntil <= 0 || now + diopts->probeTimeout < waituntil)) {
+          waituntil = now + diopts->probeTimeout;
+        }
+        for (i = 0; diopts->probeTimeout > 0 && i < count; ++i) {
+          di_probe_job_t  *job;
+
+          job = &pool->jobs [i];
+          if (job->state != DI_JOB_RUNNING) {
+            continue;
+          }
+          if (now - job->started >= diopts->probeTimeout) {
+            job->state = DI_JOB_ABANDONED;
+            --pool->remaining;
+            --live;
+            if (diopts->optval [DI_OPT_DEBUG] > 0) {
+              printf ("# di_probe_run: timeout: %s\n", job->path);
+            }
+            /* the hung worker is lost; replace it */
+            if (pool->nextidx < pool->count) {
+              rc = probeStartWorker (pool);
+              if (rc == 0) {
+                ++live;
+              } else if (diopts->optval [DI_OPT_DEBUG] > 0) {
+                printf ("# di_probe_run: thread create failed: %s\n",
+                    strerror (rc));
+              }
+            }
+            continue;
+          }
+          if (job->started + diopts->probeTimeout < waituntil) {
+            waituntil = job->started + diopts->probeTimeout;
+          }
+        }
+
+        if (live > 0 && pool->remaining > 0) {
+          probeTimespec (waituntil, &ts);
+          pthread_cond_timedwait (&pool->cond, &pool->lock, &ts);
+        }
+      }
+
+      if (pool != NULL) {
+        pool->finished = true;
+        for (i = 0; i < count; ++i) {
+          int   state;
+
+          state = pool->jobs [i].state;
+          if (state == DI_JOB_DONE) {
+            memcpy ((char *) results + (Size_t) i * ressz,
+                pool->results + (Size_t) i * ressz, ressz);
+            pool->jobs [i].state = DI_JOB_TAKEN;
+            status [i] = DI_PROBE_DONE;
+          }
+          if (state == DI_JOB_ABANDONED) {
+            status [i] = DI_PROBE_TIMEOUT;
+          }
+          /* anything left over could not be run in time */
+          if (state == DI_JOB_PENDING || state == DI_JOB_RUNNING) {
+            status [i] = expired ? DI_PROBE_STALE : DI_PROBE_TIMEOUT;
+          }
+        }
+        pthread_mutex_unlock (&pool->lock);
+        probePoolRelease (pool);
+        free (order);
+        return;
+      }
+    }
+  }
+#endif
+
+  for (i = 0; i < count; ++i) {
+    idx = order [i];
+    if (paths [idx] == NULL) {
+      continue;
+    }
+    if (di_data->deadlineAt > 0 && di_probe_now () >= di_data->deadlineAt) {
+      status [idx] = DI_PROBE_STALE;
+      continue;
+    }
+    probefunc (paths [idx], (char *) results + (Size_t) idx * ressz);
+    status [idx] = DI_PROBE_DONE;
+  }
+
+  free (order);
+}
+
+di_ms_t
+di_probe_now (void)
+{
+#if _lib_clock_gettime
+  struct timespec   ts;
+
+# if defined (DI_PROBE_CLOCK)
+  clock_gettime (DI_PROBE_CLOCK, &ts);
+# else
+  clock_gettime (CLOCK_REALTIME, &ts);
+# endif
+  return (di_ms_t) ts.tv_sec * 1000 + (di_ms_t) (ts.tv_nsec / 1000000);
+#else
+  return (di_ms_t) time (NULL) * 1000;
+#endif
+}
+
+/* the local file systems are probed first, */
+/* otherwise the partition order is kept     */
+static int *
+probeOrder (di_data_t *di_data, int count)
+{
+  int     *order;
+  int     i;
+  int     j;
+
+  order = (int *) malloc (sizeof (int) * (Size_t) (count + 1));
+  if (order == NULL) {
+    fprintf (stderr, "malloc failed in probeOrder.  errno %d\n", errno);
+    return order;
+  }
+
+  j = 0;
+  for (i = 0; i < count; ++i) {
+    if (di_data->diskInfo [i].isLocal) {
+      order [j++] = i;
+    }
+  }
+  for (i = 0; i < count; ++i) {
+    if (! di_data->diskInfo [i].isLocal) {
+      order [j++] = i;
+    }
+  }
+
+  return order;
+}
+
+#if defined (DI_PROBE_THREADS)
+
+static di_probe_pool_t *
+probePoolAlloc (int count, const char *paths [], const int *order,
+    di_probe_func_t probefunc, di_probe_free_t freefunc,
+    void *results, Size_t ressz)
+{
+  di_probe_pool_t     *pool;
+  pthread_condattr_t  cattr;
+  int                 i;
+
+  pool = (di_probe_pool_t *) malloc (sizeof (di_probe_pool_t));
+  if (pool == NULL) {
+    fprintf (stderr, "malloc failed in probePoolAlloc.  errno %d\n", errno);
+    return pool;
+  }
+
+  pool->jobs = (di_probe_job_t *) malloc (sizeof (di_probe_job_t) * (Size_t) count);
+  pool->order = (int *) malloc (sizeof (int) * (Size_t) count);
+  pool->results = (char *) malloc (ressz * (Size_t) count);
+  if (pool->jobs == NULL || pool->order == NULL || pool->results == NULL) {
+    fprintf (stderr, "malloc failed in probePoolAlloc.  errno %d\n", errno);
+    free (pool->jobs);
+    free (pool->order);
+    free (pool->results);
+    free (pool);
+    return NULL;
+  }
+
+  pool->probefunc = probefunc;
+  pool->freefunc = freefunc;
+  memcpy (pool->order, order, sizeof (int) * (Size_t) count);
+  memcpy (pool->results, results, ressz * (Size_t) count);
+  pool->ressz = ressz;
+  pool->count = count;
+  pool->nextidx = 0;
+  pool->remaining = 0;
+  pool->refcount = 1;
+  pool->finished = false;
+
+  /* the paths are copied, an abandoned probe may outlive the caller */
+  for (i = 0; i < count; ++i) {
+    pool->jobs [i].path = NULL;
+    pool->jobs [i].started = 0;
+    pool->jobs [i].state = DI_JOB_NONE;
+    if (paths [i] != NULL) {
+      pool->jobs [i].path = strdup (paths [i]);
+      if (pool->jobs [i].path != NULL) {
+        pool->jobs [i].state = DI_JOB_PENDING;
+        ++pool->remaining;
+      }
+    }
+  }
+
+  pthread_mutex_init (&pool->lock, NULL);
+  pthread_condattr_init (&cattr);
+# if _lib_pthread_condattr_setclock && defined (CLOCK_MONOTONIC)
+  pthread_condattr_setclock (&cattr, DI_PROBE_CLOCK);
+# endif
+  pthread_cond_init (&pool->cond, &cattr);
+  pthread_condattr_destroy (&cattr);
+
+  return pool;
+}
+
+static void
+probePoolRelease (di_probe_pool_t *pool)
+{
+  int     i;
+  int     last;
+
+  pthread_mutex_lock (&pool->lock);
+  --pool->refcount;
+  last = pool->refcount == 0;
+  pthread_mutex_unlock (&pool->lock);
+
+  if (! last) {
+    return;
+  }
+
+  for (i = 0; i < pool->count; ++i) {
+    /* a result that was not copied to the caller belongs to the pool */
+    if (pool->freefunc != NULL &&
+        (pool->jobs [i].state == DI_JOB_DONE ||
+        pool->jobs [i].state == DI_JOB_LOST)) {
+      pool->freefunc (pool->results + (Size_t) i * pool->ressz);
+    }
+    free (pool->jobs [i].path);
+  }
+  pthread_mutex_destroy (&pool->lock);
+  pthread_cond_destroy (&pool->cond);
+  free (pool->jobs);
+  free (pool->order);
+  free (pool->results);
+  free (pool);
+}
+
+/* must be called with the pool locked */
+/* returns the pthread_create () error code */
+static int
+probeStartWorker (di_probe_pool_t *pool)
+{
+  pthread_t       thread;
+  pthread_attr_t  attr;
+  int             rc;
+
+  pthread_attr_init (&attr);
+  pthread_attr_setdetachstate (&attr, PTHREAD_CREATE_DETACHED);
+  ++pool->refcount;
+  rc = pthread_create (&thread, &attr, probeWorker, pool);
+  if (rc != 0) {
+    --pool->refcount;
+  }
+  pthread_attr_destroy (&attr);
+
+  return rc;
+}
+
+static void *
+probeWorker (void *arg)
+{
+  di_probe_pool_t   *pool;
+  di_probe_job_t    *job;
+  int               idx;
+
+  pool = (di_probe_pool_t *) arg;
+
+  pthread_mutex_lock (&pool->lock);
+  while (! pool->finished) {
+    while (pool->nextidx < pool->count &&
+        pool->jobs [pool->order [pool->nextidx]].state != DI_JOB_PENDING) {
+      ++pool->nextidx;
+    }
+    if (pool->nextidx >= pool->count) {
+      break;
+    }
+
+    idx = pool->order [pool->nextidx];
+    ++pool->nextidx;
+    job = &pool->jobs [idx];
+    job->state = DI_JOB_RUNNING;
+    job->started = di_probe_now ();
+    pthread_mutex_unlock (&pool->lock);
+
+    pool->probefunc (job->path, pool->results + (Size_t) idx * pool->ressz);
+
+    pthread_mutex_lock (&pool->lock);
+    if (job->state == DI_JOB_ABANDONED) {
+      /* a replacement worker has already been started */
+      job->state = DI_JOB_LOST;
+      break;
+    }
+    job->state = DI_JOB_DONE;
+    --pool->remaining;
+    pthread_cond_signal (&pool->cond);
+  }
+  pthread_mutex_unlock (&pool->lock);
+
+  probePoolRelease (pool);
+  return NULL;
+}
+
+static void
+probeTimespec (di_ms_t when, struct timespec *ts)
+{
+  ts->tv_sec = (time_t) (when / 1000);
+  ts->tv_nsec = (long) (when % 1000) * 1000000L;
+}
+
+#endif
@@ -0,0 +1,724 @@
+/* Copyright 2026 Brad Lanam Pleasant Hill CA */
+
+/*
+ *
+ *    Sorting the disk information.
+ *
+ *    The sort type string is parsed once into a list of sort fields.
+ *    A sort key is then built for each entry and field: a collation
+ *    key for the strings (strxfrm (), or the string itself in the
+ *    C locale), an integer for the space and inode values, and
+ *    a double for the percentages.  The comparisons only look at
+ *    the keys.  The sort is a stable merge sort of the sort index.
+ *
+ *    The top-N selection uses the same keys.  A bounded heap holds
+ *    the best N printable entries seen so far, with the worst of
+ *    them at the root.  Ties are broken by the previous position, so
+ *    the result is the same as the first N entries of a stable sort.
+ *
+ *    di_sort_disk_info ()
+ *        sort the disk information.
+ *    di_sort_top ()
+ *        select and sort the best N printable entries.  All of the
+ *        other entries are hidden.
+ *    di_sort_uses_values ()
+ *        does the sort type use the space or inode values?
+ *
+ */
+
+#include "config.h"
+
+#if _hdr_stdio
+# include <stdio.h>
+#endif
+#if _hdr_stdlib
+# include <stdlib.h>
+#endif
+#if _hdr_stdbool
+# include <stdbool.h>
+#endif
+#if _hdr_string
+# include <string.h>
+#endif
+#if _hdr_strings
+# include <strings.h>
+#endif
+#if _hdr_memory
+# include <memory.h>
+#endif
+#if _hdr_malloc
+# include <malloc.h>
+#endif
+#if _hdr_errno
+# include <errno.h>
+#endif
+#if _hdr_locale
+# include <locale.h>
+#endif
+
+#include "di.h"
+#include "disystem.h"
+#include "diinternal.h"
+#include "dimath.h"
+#include "dimath_mp.h"
+
+#define DI_SORT_OPT_NONE            'n'
+#define DI_SORT_OPT_MOUNT           'm'
+#define DI_SORT_OPT_FILESYSTEM      's'
+#define DI_SORT_OPT_TOTAL           'T'
+#define DI_SORT_OPT_FREE            'f'
+#define DI_SORT_OPT_AVAIL           'a'
+#define DI_SORT_OPT_REVERSE         'r'
+#define DI_SORT_OPT_TYPE            't'
+#define DI_SORT_OPT_PERC_USED       'p'
+#define DI_SORT_OPT_INODE_USED      'U'
+#define DI_SORT_OPT_INODE_FREE      'F'
+#define DI_SORT_OPT_ASCENDING       1
+
+/* below this size, the merge sort uses an insertion sort */
+#define DI_SORT_INSERTION_MAX       8
+
+#define DI_SORT_KEY_STR             0
+#define DI_SORT_KEY_VALUE           1
+#define DI_SORT_KEY_PERC            2
+
+typedef struct
+{
+  int           keytype;
+  int           stridx;                     /* DI_DISP_*                */
+  int           validx;                     /* DI_SPACE_*, DI_INODE_*   */
+  int           subidx;                     /* subtracted from validx   */
+  int           order;
+} di_sort_field_t;
+
+typedef struct
+{
+  const char    *str;
+  double        dval;
+  di_ui_t       uval;
+  int           exact;                      /* is uval valid?           */
+} di_sort_key_t;
+
+typedef struct
+{
+  di_data_t       *di_data;
+  di_sort_field_t *fields;
+  int             nfields;
+  di_sort_key_t   *keys;                    /* by entry, then field     */
+  char            *xfrm;                    /* strxfrm () data          */
+  int             *pos;                     /* tie-break, or NULL       */
+  int             usecoll;
+} di_sort_t;
+
+static int  sortParse (const char *, di_sort_field_t *);
+static int  sortIsCLocale (void);
+static int  sortBuildKeys (di_sort_t *, int);
+static void sortValueKey (di_sort_t *, int, const di_sort_field_t *, di_sort_key_t *);
+static void sortValueNum (const di_disk_info_t *, const di_sort_field_t *, dinum_t *);
+static int  sortCompare (const di_sort_t *, int, int);
+static void sortMerge (const di_sort_t *, int *, int *, int);
+static void sortHeapDown (const di_sort_t *, int *, int, int);
+
+void
+di_sort_disk_info (di_data_t *di_data, const char *sortType, int sidx)
+{
+  di_disk_info_t  *data;
+  di_sort_t       sort;
+  int             *idx;
+  int             *tmp;
+  int             count;
+  int             i;
+
+  data = di_data->diskInfo;
+  count = di_data->fscount;
+  if (count <= 1) {
+    return;
+  }
+
+  sort.di_data = di_data;
+  sort.keys = NULL;
+  sort.xfrm = NULL;
+  sort.pos = NULL;
+  sort.fields = (di_sort_field_t *) malloc (
+      sizeof (di_sort_field_t) * (strlen (sortType) + 1));
+  idx = (int *) malloc (sizeof (int) * (Size_t) count * 2);
+  if (sort.fields == NULL || idx == NULL) {
+    fprintf (stderr, "malloc failed in di_sort_disk_info.  errno %d\n", errno);
+    if (sort.fields != NULL) {
+      free (sort.fields);
+    }
+    if (idx != NULL) {
+      free (idx);
+    }
+    return;
+  }
+  tmp = idx + count;
+
+  sort.nfields = sortParse (sortType, sort.fields);
+  if (sort.nfields > 0 && sortBuildKeys (&sort, count) == 0) {
+    for (i = 0; i < count; ++i) {
+      idx [i] = data [i].sortIndex [sidx];
+    }
+    sortMerge (&sort, idx, tmp, count);
+    for (i = 0; i < count; ++i) {
+      data [i].sortIndex [sidx] = idx [i];
+    }
+  }
+
+  if (sort.keys != NULL) {
+    free (sort.keys);
+  }
+  if (sort.xfrm != NULL) {
+    free (sort.xfrm);
+  }
+  free (sort.fields);
+  free (idx);
+}
+
+void
+di_sort_top (di_data_t *di_data, const char *sortType, int sidx, int topcount)
+{
+  di_disk_info_t  *data;
+  di_sort_t       sort;
+  int             *order;
+  int             *heap;
+  char            *selected;
+  int             count;
+  int             nprint;
+  int             nheap;
+  int             idx;
+  int             t;
+  int             i;
+  int             j;
+
+  data = di_data->diskInfo;
+  count = di_data->fscount;
+
+  nprint = 0;
+  for (i = 0; i < count; ++i) {
+    if (data [i].doPrint && ! data [i].whereHidden) {
+      ++nprint;
+    }
+  }
+  if (topcount >= nprint) {
+    /* nothing is hidden */
+    di_sort_disk_info (di_data, sortType, sidx);
+    return;
+  }
+
+  sort.di_data = di_data;
+  sort.keys = NULL;
+  sort.xfrm = NULL;
+  sort.fields = (di_sort_field_t *) malloc (
+      sizeof (di_sort_field_t) * (strlen (sortType) + 1));
+  order = (int *) malloc (sizeof (int) * ((Size_t) count * 2 + (Size_t) topcount));
+  selected = (char *) malloc ((Size_t) count);
+  if (sort.fields == NULL || order == NULL || selected == NULL) {
+    fprintf (stderr, "malloc failed in di_sort_top.  errno %d\n", errno);
+    if (sort.fields != NULL) {
+      free (sort.fields);
+    }
+    if (order != NULL) {
+      free (order);
+    }
+    if (selected != NULL) {
+      free (selected);
+    }
+    return;
+  }
+  sort.pos = order + count;
+  heap = sort.pos + count;
+
+  sort.nfields = sortParse (sortType, sort.fields);
+  if (sortBuildKeys (&sort, count) == 0) {
+    for (i = 0; i < count; ++i) {
+      order [i] = data [i].sortIndex [sidx];
+      sort.pos [order [i]] = i;
+      selected [i] = false;
+    }
+
+    /* the root of the heap is the worst of the entries kept */
+    nheap = 0;
+    for (i = 0; i < count; ++i) {
+      idx = order [i];
+      if (! data [idx].doPrint || data [idx].whereHidden) {
+        continue;
+      }
+      if (nheap < topcount) {
+        j = nheap++;
+        while (j > 0 && sortCompare (&sort, heap [(j - 1) / 2], idx) < 0) {
+          heap [j] = heap [(j - 1) / 2];
+          j = (j - 1) / 2;
+        }
+        heap [j] = idx;
+      } else if (topcount > 0 && sortCompare (&sort, idx, heap [0]) < 0) {
+        heap [0] = idx;
+        sortHeapDown (&sort, heap, nheap, 0);
+      }
+    }
+
+    /* the selected entries are sorted in place, worst first out */
+    for (i = nheap - 1; i > 0; --i) {
+      t = heap [0];
+      heap [0] = heap [i];
+      heap [i] = t;
+      sortHeapDown (&sort, heap, i, 0);
+    }
+
+    for (i = 0; i < nheap; ++i) {
+      selected [heap [i]] = true;
+      data [i].sortIndex [sidx] = heap [i];
+    }
+    j = nheap;
+    for (i = 0; i < count; ++i) {
+      idx = order [i];
+      if (selected [idx]) {
+        continue;
+      }
+      data [j++].sortIndex [sidx] = idx;
+      /* already hidden, and counted in wherehidden */
+      if (data [idx].whereHidden) {
+        continue;
+      }
+      data [idx].topHidden = true;
+      di_columns_set_row (di_data, idx);
+      ++di_data->tophidden;
+    }
+  }
+
+  if (sort.keys != NULL) {
+    free (sort.keys);
+  }
+  if (sort.xfrm != NULL) {
+    free (sort.xfrm);
+  }
+  free (sort.fields);
+  free (order);
+  free (selected);
+}
+
+int
+di_sort_uses_values (const char *sortType)
+{
+  di_sort_field_t   *fields;
+  int               nfields;
+  int               rc;
+  int               i;
+
+  fields = (di_sort_field_t *) malloc (
+      sizeof (di_sort_field_t) * (strlen (sortType) + 1));
+  if (fields == NULL) {
+    /* assume the worst */
+    return true;
+  }
+
+  rc = false;
+  nfields = sortParse (sortType, fields);
+  for (i = 0; i < nfields; ++i) {
+    if (fields [i].validx != DI_VALUE_NONE) {
+      rc = true;
+    }
+  }
+  free (fields);
+  return rc;
+}
+
+/* returns the number of sort fields */
+static int
+sortParse (const char *sortType, di_sort_field_t *fields)
+{
+  const char        *ptr;
+  di_sort_field_t   *field;
+  int               sortOrder;
+  int               nfields;
+
+  /* reset sort order to the default start value */
+  sortOrder = DI_SORT_OPT_ASCENDING;
+  nfields = 0;
+
+  ptr = sortType;
+  while (*ptr) {
+    field = &fields [nfields];
+    field->keytype = DI_SORT_KEY_VALUE;
+    field->stridx = DI_DISP_MOUNTPT;
+    field->validx = DI_VALUE_NONE;
+    field->subidx = DI_VALUE_NONE;
+    field->order = sortOrder;
+
+    switch (*ptr) {
+      case DI_SORT_OPT_REVERSE: {
+        sortOrder *= -1;
+        break;
+      }
+      case DI_SORT_OPT_MOUNT: {
+        field->keytype = DI_SORT_KEY_STR;
+        field->stridx = DI_DISP_MOUNTPT;
+        ++nfields;
+        break;
+      }
+      case DI_SORT_OPT_FILESYSTEM: {
+        field->keytype = DI_SORT_KEY_STR;
+        field->stridx = DI_DISP_FILESYSTEM;
+        ++nfields;
+        break;
+      }
+      case DI_SORT_OPT_TYPE: {
+        field->keytype = DI_SORT_KEY_STR;
+        field->stridx = DI_DISP_FSTYPE;
+        ++nfields;
+        break;
+      }
+      case DI_SORT_OPT_TOTAL: {
+        field->validx = DI_SPACE_TOTAL;
+        ++nfields;
+        break;
+      }
+      case DI_SORT_OPT_FREE: {
+        field->validx = DI_SPACE_FREE;
+        ++nfields;
+        break;
+      }
+      case DI_SORT_OPT_AVAIL: {
+        field->validx = DI_SPACE_AVAIL;
+        ++nfields;
+        break;
+      }
+      case DI_SORT_OPT_PERC_USED: {
+        /* the same as the 'p' format: (tot - avail) / tot */
+        field->keytype = DI_SORT_KEY_PERC;
+        field->validx = DI_SPACE_TOTAL;
+        field->subidx = DI_SPACE_AVAIL;
+        ++nfields;
+        break;
+      }
+      case DI_SORT_OPT_INODE_USED: {
+        field->validx = DI_INODE_TOTAL;
+        field->subidx = DI_INODE_FREE;
+        ++nfields;
+        break;
+      }
+      case DI_SORT_OPT_INODE_FREE: {
+        field->validx = DI_INODE_FREE;
+        ++nfields;
+        break;
+      }
+      case DI_SORT_OPT_NONE:
+      default: {
+        break;
+      }
+    }
+
+    ++ptr;
+  }
+
+  return nfields;
+}
+
+/* in the C locale, strcoll () is strcmp () */
+static int
+sortIsCLocale (void)
+{
+#if _lib_setlocale && _hdr_locale && defined (LC_COLLATE)
+  const char  *loc;
+
+  loc = setlocale (LC_COLLATE, NULL);
+  if (loc != NULL &&
+      (strcmp (loc, "C") == 0 || strcmp (loc, "POSIX") == 0)) {
+    return true;
+  }
+  return false;
+#else
+  return false;
+#endif
+}
+
+static int
+sortBuildKeys (di_sort_t *sort, int count)
+{
+  di_disk_info_t  *dinfo;
+  di_sort_key_t   *key;
+  int             clocale;
+  int             hasstr;
+  int             i;
+  int             j;
+
+  /* one extra, as there may be no sort fields */
+  sort->keys = (di_sort_key_t *) malloc (
+      sizeof (di_sort_key_t) * ((Size_t) count * (Size_t) sort->nfields + 1));
+  if (sort->keys == NULL) {
+    fprintf (stderr, "malloc failed in di_sort_disk_info.  errno %d\n", errno);
+    return -1;
+  }
+
+  hasstr = false;
+  for (j = 0; j < sort->nfields; ++j) {
+    if (sort->fields [j].keytype == DI_SORT_KEY_STR) {
+      hasstr = true;
+    }
+  }
+  clocale = true;
+  if (hasstr) {
+    clocale = sortIsCLocale ();
+  }
+  sort->usecoll = false;
+#if ! _lib_strxfrm
+  sort->usecoll = ! clocale;
+#endif
+
+  for (i = 0; i < count; ++i) {
+    dinfo = &sort->di_data->diskInfo [i];
+    for (j = 0; j < sort->nfields; ++j) {
+      key = &sort->keys [i * sort->nfields + j];
+      key->str = NULL;
+      key->dval = 0.0;
+      key->uval = 0;
+      key->exact = false;
+      if (sort->fields [j].keytype == DI_SORT_KEY_STR) {
+        key->str = dinfo->strdata [sort->fields [j].stridx];
+      } else {
+        sortValueKey (sort, i, &sort->fields [j], key);
+      }
+    }
+  }
+
+#if _lib_strxfrm
+  if (! clocale) {
+    Size_t    total;
+    Size_t    len;
+    char      *p;
+
+    /* the first pass gets the size, the second fills in the keys */
+    total = 0;
+    for (i = 0; i < count; ++i) {
+      for (j = 0; j < sort->nfields; ++j) {
+        key = &sort->keys [i * sort->nfields + j];
+        if (key->str != NULL) {
+          total += strxfrm (NULL, key->str, 0) + 1;
+        }
+      }
+    }
+
+    sort->xfrm = (char *) malloc (total);
+    if (sort->xfrm == NULL) {
+      fprintf (stderr, "malloc failed in di_sort_disk_info.  errno %d\n", errno);
+      return -1;
+    }
+
+    p = sort->xfrm;
+    for (i = 0; i < count; ++i) {
+      for (j = 0; j < sort->nfields; ++j) {
+        key = &sort->keys [i * sort->nfields + j];
+        if (key->str != NULL) {
+          len = strxfrm (NULL, key->str, 0) + 1;
+          strxfrm (p, key->str, len);
+          key->str = p;
+          p += len;
+        }
+      }
+    }
+  }
+#endif
+
+  return 0;
+}
+
+static void
+sortValueKey (di_sort_t *sort, int idx, const di_sort_field_t *field,
+    di_sort_key_t *key)
+{
+  di_columns_t    *cols;
+  dinum_t         val;
+  dinum_t         divisor;
+  di_disk_info_t  *dinfo;
+
+  dinfo = &sort->di_data->diskInfo [idx];
+
+  if (field->keytype == DI_SORT_KEY_PERC) {
+    dinum_init (&val);
+    dinum_init (&divisor);
+    sortValueNum (dinfo, field, &val);
+    dinum_set (&divisor, &dinfo->values [field->validx]);
+    if (dinum_cmp_s (&divisor, (di_si_t) 0) == 0) {
+      key->dval = 0.0;
+    } else {
+      key->dval = dinum_perc (&val, &divisor);
+    }
+    dinum_clear (&val);
+    dinum_clear (&divisor);
+    return;
+  }
+
+  cols = &sort->di_data->columns;
+  if (cols->valid && idx < cols->count && DI_BIT_TEST (cols->exact, idx)) {
+    key->uval = cols->values [field->validx][idx];
+    key->exact = true;
+    if (field->subidx != DI_VALUE_NONE) {
+      if (cols->values [field->subidx][idx] > key->uval) {
+        key->exact = false;
+      } else {
+        key->uval -= cols->values [field->subidx][idx];
+      }
+    }
+    return;
+  }
+
+  dinum_init (&val);
+  sortValueNum (dinfo, field, &val);
+  key->exact = dinum_get_u (&val, &key->uval);
+  dinum_clear (&val);
+}
+
+static void
+sortValueNum (const di_disk_info_t *dinfo, const di_sort_field_t *field,
+    dinum_t *val)
+{
+  dinum_set (val, &dinfo->values [field->validx]);
+  if (field->subidx != DI_VALUE_NONE) {
+    dinum_sub (val, &dinfo->values [field->subidx]);
+  }
+}
+
+static int
+sortCompare (const di_sort_t *sort, int idx1, int idx2)
+{
+  const di_sort_field_t   *field;
+  const di_sort_key_t     *k1;
+  const di_sort_key_t     *k2;
+  const di_disk_info_t    *d1;
+  const di_disk_info_t    *d2;
+  int                     rc;
+  int                     j;
+
+  rc = 0;
+  k1 = &sort->keys [idx1 * sort->nfields];
+  k2 = &sort->keys [idx2 * sort->nfields];
+
+  for (j = 0; j < sort->nfields; ++j) {
+    field = &sort->fields [j];
+
+    switch (field->keytype) {
+      case DI_SORT_KEY_STR: {
+        d1 = &sort->di_data->diskInfo [idx1];
+        d2 = &sort->di_data->diskInfo [idx2];
+        /* interned strings are equal if the ids are */
+        if (d1->strId [field->stridx] >= 0 &&
+            d1->strId [field->stridx] == d2->strId [field->stridx]) {
+          rc = 0;
+        } else if (sort->usecoll) {
+          rc = strcoll (k1 [j].str, k2 [j].str);
+        } else {
+          rc = strcmp (k1 [j].str, k2 [j].str);
+        }
+        break;
+      }
+      case DI_SORT_KEY_PERC: {
+        rc = k1 [j].dval < k2 [j].dval ? -1 : k1 [j].dval > k2 [j].dval ? 1 : 0;
+        break;
+      }
+      case DI_SORT_KEY_VALUE: {
+        if (k1 [j].exact && k2 [j].exact) {
+          rc = k1 [j].uval < k2 [j].uval ? -1 : k1 [j].uval > k2 [j].uval ? 1 : 0;
+        } else {
+          dinum_t   v1;
+          dinum_t   v2;
+
+          dinum_init (&v1);
+          dinum_init (&v2);
+          sortValueNum (&sort->di_data->diskInfo [idx1], field, &v1);
+          sortValueNum (&sort->di_data->diskInfo [idx2], field, &v2);
+          rc = dinum_cmp (&v1, &v2);
+          dinum_clear (&v1);
+          dinum_clear (&v2);
+        }
+        break;
+      }
+      default: {
+        break;
+      }
+    }
+
+    if (rc != 0) {
+      return rc * field->order;
+    }
+  }
+
+  if (sort->pos != NULL) {
+    return sort->pos [idx1] < sort->pos [idx2] ? -1 :
+        sort->pos [idx1] > sort->pos [idx2] ? 1 : 0;
+  }
+  return 0;
+}
+
+/* stable: on equal keys, the left hand side is taken first */
+static void
+sortMerge (const di_sort_t *sort, int *idx, int *tmp, int count)
+{
+  int     mid;
+  int     i;
+  int     j;
+  int     k;
+  int     t;
+
+  if (count <= DI_SORT_INSERTION_MAX) {
+    for (i = 1; i < count; ++i) {
+      t = idx [i];
+      j = i - 1;
+      while (j >= 0 && sortCompare (sort, idx [j], t) > 0) {
+        idx [j + 1] = idx [j];
+        --j;
+      }
+      idx [j + 1] = t;
+    }
+    return;
+  }
+
+  mid = count / 2;
+  sortMerge (sort, idx, tmp, mid);
+  sortMerge (sort, idx + mid, tmp, count - mid);
+
+  /* already in order (e.g. a re-sort when sampling at intervals) */
+  if (sortCompare (sort, idx [mid - 1], idx [mid]) <= 0) {
+    return;
+  }
+
+  memcpy (tmp, idx, sizeof (int) * (Size_t) mid);
+  i = 0;
+  j = mid;
+  k = 0;
+  while (i < mid && j < count) {
+    if (sortCompare (sort, idx [j], tmp [i]) < 0) {
+      idx [k++] = idx [j++];
+    } else {
+      idx [k++] = tmp [i++];
+    }
+  }
+  while (i < mid) {
+    idx [k++] = tmp [i++];
+  }
+}
+
+/* the heap is ordered with the entry that sorts last at the root */
+static void
+sortHeapDown (const di_sort_t *sort, int *heap, int nheap, int j)
+{
+  int     child;
+  int     t;
+
+  t = heap [j];
+  for (;;) {
+    child = j * 2 + 1;
+    if (child >= nheap) {
+      break;
+    }
+    if (child + 1 < nheap &&
+        sortCompare (sort, heap [child], heap [child + 1]) < 0) {
+      ++child;
+    }
+    if (sortCompare (sort, t, heap [child]) >= 0) {
+      break;
+    }
+    heap [j] = heap [child];
+    j = child;
+  }
+  heap [j] = t;
+}
@@ -0,0 +1,391 @@
+/* Copyright 2026 Brad Lanam Pleasant Hill CA */
+
+/*
+ *
+ *    Path prefix trie.
+ *
+ *    Each node of the trie is a path component.  A lookup walks the
+ *    components of a path and returns the value of the deepest key
+ *    that the path is at or below.  The path is not resolved; there
+ *    are no system calls.  Empty and '.' components are skipped, and
+ *    '..' removes the previous component.
+ *
+ *    A key with a trailing slash (other than "/") only matches the
+ *    paths below it, not the key path itself.
+ *
+ *    The edges are kept in a single hash table, keyed by the parent
+ *    node and the component name.  The component names point into
+ *    the keys, which must remain valid while the trie is in use.
+ *
+ *    di_trie_init ()
+ *        initialize an empty trie.
+ *    di_trie_insert ()
+ *        add a key.  A later value for the same key replaces the
+ *        earlier one.
+ *    di_trie_find ()
+ *        return the value for a path, or -1.
+ *    di_trie_free ()
+ *        release the trie.
+ *    di_mount_trie_find ()
+ *        return the index of the mount point a path is on.  The trie
+ *        of the mount points is built as needed.
+ *
+ */
+
+#include "config.h"
+
+#if _hdr_stdio
+# include <stdio.h>
+#endif
+#if _hdr_stdlib
+# include <stdlib.h>
+#endif
+#if _hdr_stdbool
+# include <stdbool.h>
+#endif
+#if _hdr_string
+# include <string.h>
+#endif
+#if _hdr_strings
+# include <strings.h>
+#endif
+#if _hdr_memory
+# include <memory.h>
+#endif
+#if _hdr_malloc
+# include <malloc.h>
+#endif
+#if _hdr_errno
+# include <errno.h>
+#endif
+
+#include "di.h"
+#include "disystem.h"
+#include "diinternal.h"
+
+#define DI_TRIE_MIN_ALLOC   32
+
+static int  trieAddNode (di_trie_t *);
+static int  trieGrowEdges (di_trie_t *);
+static di_trie_edge_t *trieEdge (di_trie_edge_t *, Size_t, int, const char *, Size_t, unsigned long);
+static unsigned long trieHash (int, const char *, Size_t);
+static const char *trieComponent (const char **, Size_t *);
+
+void
+di_trie_init (di_trie_t *trie)
+{
+  trie->nodes = NULL;
+  trie->edges = NULL;
+  trie->stack = NULL;
+  trie->tsize = 0;
+  trie->nodecount = 0;
+  trie->alloc = 0;
+  trie->maxdepth = 0;
+  trie->count = 0;
+  trie->valid = false;
+}
+
+int
+di_trie_insert (di_trie_t *trie, const char *key, int value)
+{
+  di_trie_edge_t  *edge;
+  const char      *name;
+  const char      *p;
+  Size_t          len;
+  unsigned long   hash;
+  int             node;
+  int             depth;
+  int             *tstack;
+
+  if (*key != '/') {
+    return -1;
+  }
+  if (trie->nodecount == 0) {
+    if (trieAddNode (trie) < 0) {
+      return -1;
+    }
+  }
+
+  node = 0;
+  depth = 0;
+  p = key;
+  while ((name = trieComponent (&p, &len)) != NULL) {
+    hash = trieHash (node, name, len);
+    if (trie->tsize > 0) {
+      edge = trieEdge (trie->edges, trie->tsize, node, name, len, hash);
+      if (edge->parent >= 0) {
+        node = edge->child;
+        ++depth;
+        continue;
+      }
+    }
+
+    /* keep the load factor at or below one half */
+    if ((Size_t) trie->nodecount * 2 >= trie->tsize) {
+      if (trieGrowEdges (trie) < 0) {
+        return -1;
+      }
+    }
+    edge = trieEdge (trie->edges, trie->tsize, node, name, len, hash);
+    edge->child = trieAddNode (trie);
+    if (edge->child < 0) {
+      return -1;
+    }
+    edge->parent = node;
+    edge->hash = hash;
+    edge->name = name;
+    edge->len = len;
+    node = edge->child;
+    ++depth;
+  }
+
+  if (depth > trie->maxdepth || trie->stack == NULL) {
+    tstack = (int *) realloc (trie->stack, sizeof (int) * (Size_t) (depth + 1));
+    if (tstack == NULL) {
+      fprintf (stderr, "malloc failed in di_trie_insert.  errno %d\n", errno);
+      return -1;
+    }
+    trie->stack = tstack;
+    if (depth > trie->maxdepth) {
+      trie->maxdepth = depth;
+    }
+  }
+
+  len = strlen (key);
+  if (len > 1 && key [len - 1] == '/') {
+    trie->nodes [node].below = value;
+  } else {
+    trie->nodes [node].value = value;
+  }
+  return 0;
+}
+
+int
+di_trie_find (di_trie_t *trie, const char *path)
+{
+  di_trie_edge_t  *edge;
+  const char      *name;
+  const char      *p;
+  Size_t          len;
+  int             depth;
+  int             parent;
+  int             i;
+
+  if (trie->nodecount == 0 || trie->stack == NULL || *path != '/') {
+    return -1;
+  }
+
+  /* the nodes deeper than the trie are not kept, they do not exist */
+  depth = 0;
+  trie->stack [0] = 0;
+  p = path;
+  while ((name = trieComponent (&p, &len)) != NULL) {
+    if (len == 2 && name [0] == '.' && name [1] == '.') {
+      if (depth > 0) {
+        --depth;
+      }
+      continue;
+    }
+    ++depth;
+    if (depth > trie->maxdepth) {
+      continue;
+    }
+    parent = trie->stack [depth - 1];
+    trie->stack [depth] = -1;
+    if (parent >= 0 && trie->tsize > 0) {
+      edge = trieEdge (trie->edges, trie->tsize, parent, name, len,
+          trieHash (parent, name, len));
+      trie->stack [depth] = edge->child;
+    }
+  }
+
+  i = depth;
+  if (i > trie->maxdepth) {
+    i = trie->maxdepth;
+  }
+  for ( ; i >= 0; --i) {
+    di_trie_node_t    *tnode;
+
+    if (trie->stack [i] < 0) {
+      continue;
+    }
+    tnode = &trie->nodes [trie->stack [i]];
+    if (tnode->value >= 0) {
+      return tnode->value;
+    }
+    if (i < depth && tnode->below >= 0) {
+      return tnode->below;
+    }
+  }
+  return -1;
+}
+
+void
+di_trie_free (di_trie_t *trie)
+{
+  if (trie->nodes != NULL) {
+    free (trie->nodes);
+  }
+  if (trie->edges != NULL) {
+    free (trie->edges);
+  }
+  if (trie->stack != NULL) {
+    free (trie->stack);
+  }
+  di_trie_init (trie);
+}
+
+/* the last mount on a mount point is the one that is visible */
+int
+di_mount_trie_find (di_data_t *di_data, const char *path)
+{
+  di_trie_t   *trie;
+  int         i;
+
+  trie = &di_data->mnttrie;
+  if (! trie->valid || trie->count != di_data->fscount) {
+    di_trie_free (trie);
+    for (i = 0; i < di_data->fscount; ++i) {
+      if (di_trie_insert (trie, di_data->diskInfo [i].strdata [DI_DISP_MOUNTPT], i) < 0 &&
+          *di_data->diskInfo [i].strdata [DI_DISP_MOUNTPT] == '/') {
+        di_trie_free (trie);
+        return -1;
+      }
+    }
+    trie->count = di_data->fscount;
+    trie->valid = true;
+  }
+
+  return di_trie_find (trie, path);
+}
+
+static int
+trieAddNode (di_trie_t *trie)
+{
+  di_trie_node_t  *tnodes;
+  int             alloc;
+
+  if (trie->nodecount >= trie->alloc) {
+    alloc = trie->alloc * 2;
+    if (alloc < DI_TRIE_MIN_ALLOC) {
+      alloc = DI_TRIE_MIN_ALLOC;
+    }
+    tnodes = (di_trie_node_t *) realloc (trie->nodes,
+        sizeof (di_trie_node_t) * (Size_t) alloc);
+    if (tnodes == NULL) {
+      fprintf (stderr, "malloc failed in di_trie_insert.  errno %d\n", errno);
+      return -1;
+    }
+    trie->nodes = tnodes;
+    trie->alloc = alloc;
+  }
+
+  trie->nodes [trie->nodecount].value = -1;
+  trie->nodes [trie->nodecount].below = -1;
+  return trie->nodecount++;
+}
+
+static int
+trieGrowEdges (di_trie_t *trie)
+{
+  di_trie_edge_t  *tedges;
+  di_trie_edge_t  *edge;
+  Size_t          tsize;
+  Size_t          h;
+
+  tsize = trie->tsize * 2;
+  if (tsize < DI_TRIE_MIN_ALLOC * 2) {
+    tsize = DI_TRIE_MIN_ALLOC * 2;
+  }
+  tedges = (di_trie_edge_t *) malloc (sizeof (di_trie_edge_t) * tsize);
+  if (tedges == NULL) {
+    fprintf (stderr, "malloc failed in di_trie_insert.  errno %d\n", errno);
+    return -1;
+  }
+  for (h = 0; h < tsize; ++h) {
+    tedges [h].parent = -1;
+    tedges [h].child = -1;
+  }
+
+  for (h = 0; h < trie->tsize; ++h) {
+    if (trie->edges [h].parent < 0) {
+      continue;
+    }
+    edge = trieEdge (tedges, tsize, trie->edges [h].parent,
+        trie->edges [h].name, trie->edges [h].len, trie->edges [h].hash);
+    *edge = trie->edges [h];
+  }
+
+  if (trie->edges != NULL) {
+    free (trie->edges);
+  }
+  trie->edges = tedges;
+  trie->tsize = tsize;
+  return 0;
+}
+
+/* returns the edge, or the empty slot where it would be placed */
+static di_trie_edge_t *
+trieEdge (di_trie_edge_t *edges, Size_t tsize, int parent,
+    const char *name, Size_t len, unsigned long hash)
+{
+  di_trie_edge_t  *edge;
+  Size_t          h;
+
+  h = (Size_t) hash & (tsize - 1);
+  for (;;) {
+    edge = &edges [h];
+    if (edge->parent < 0) {
+      return edge;
+    }
+    if (edge->hash == hash && edge->parent == parent &&
+        edge->len == len && memcmp (edge->name, name, len) == 0) {
+      return edge;
+    }
+    h = (h + 1) & (tsize - 1);
+  }
+}
+
+/* FNV-1a, starting from the parent node */
+static unsigned long
+trieHash (int parent, const char *name, Size_t len)
+{
+  unsigned long   hash;
+  Size_t          i;
+
+  hash = 2166136261UL ^ ((unsigned long) parent * 2654435761UL);
+  for (i = 0; i < len; ++i) {
+    hash ^= (unsigned char) name [i];
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+
+/* the next component of a path; empty and '.' components are skipped */
+static const char *
+trieComponent (const char **pp, Size_t *lenp)
+{
+  const char  *p;
+  const char  *name;
+
+  p = *pp;
+  for (;;) {
+    while (*p == '/') {
+      ++p;
+    }
+    if (*p == '\0') {
+      *pp = p;
+      return NULL;
+    }
+    name = p;
+    while (*p != '\0' && *p != '/') {
+      ++p;
+    }
+    if (p - name == 1 && *name == '.') {
+      continue;
+    }
+    *pp = p;
+    *lenp = (Size_t) (p - name);
+    return name;
+  }
+}
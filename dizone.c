@@ -40,6 +40,7 @@ di_initialize_zones (di_opt_t *diopts)
   zinfo = (di_zone_info_t *) malloc (sizeof (di_zone_info_t));
   zinfo->zoneCount = 0;
   zinfo->zones = (di_zone_summ_t *) NULL;
+  di_trie_init (&zinfo->trie);
 
 #if _lib_zone_list && _lib_getzoneid && _lib_zone_getattr
   zinfo->uid = geteuid ();
@@ -74,6 +75,7 @@ di_initialize_zones (di_opt_t *diopts)
       int     len;
 
       zinfo->zones [i].zoneid = zids [i];
+      zinfo->zones [i].rootpath [0] = '\0';
       len = (int) zone_getattr (zids [i], ZONE_ATTR_ROOT,
           zinfo->zones [i].rootpath, DI_MAXPATH);
       /* solaris: the length returned includes the null byte */
@@ -105,6 +107,11 @@ di_initialize_zones (di_opt_t *diopts)
     }
 
     free ((void *) zids);
+
+    /* where zones share a root path, the first zone is used */
+    for (i = (int) zinfo->zoneCount - 1; i >= 0; --i) {
+      di_trie_insert (&zinfo->trie, zinfo->zones [i].rootpath, i);
+    }
   }
 
   if (diopts->optval [DI_OPT_DEBUG] > 4) {
@@ -126,5 +133,6 @@ di_free_zones (di_zone_info_t *zinfo)
   if (zinfo->zones != (di_zone_summ_t *) NULL) {
     free (zinfo->zones);
   }
+  di_trie_free (&zinfo->trie);
   free (zinfo);
 }
@@ -5,6 +5,7 @@
 
 #include "config.h"
 #include "disystem.h"
+#include "diinternal.h"
 #include "dioptions.h"
 
 #if _hdr_unistd
@@ -36,6 +37,7 @@ typedef struct {
   zoneid_t        myzoneid;
   unsigned int    zoneCount;
   int             globalIdx;
+  di_trie_t       trie;             /* zone root path to zone index */
 } di_zone_info_t;
 
 di_zone_info_t *di_initialize_zones (di_opt_t *diopts);
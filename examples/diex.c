@@ -17,13 +17,12 @@ check_space (const char *fn, double space_wanted) {
   int         targc;
   const char  *targv [10];
   int         exitflag;
-  const di_pub_disk_info_t  *pub;
+  di_pub_disk_info_t  pub;
   int         rval = NO_SPACE;
-  int         count;
+  double      dval;
 
-  targc = 1;
-  targv [0] = fn;
-  targv [1] = NULL;
+  targc = 0;
+  targv [0] = NULL;
 
   di_data = di_initialize ();
 
@@ -33,22 +32,18 @@ check_space (const char *fn, double space_wanted) {
     exit (exitflag);
   }
 
-  exitflag = di_get_all_disk_info (di_data);
+  /* only the filesystem the path is on is looked up */
+  exitflag = di_get_path_info (di_data, fn, &pub);
   if (exitflag != DI_EXIT_NORM) {
     di_cleanup (di_data);
     exit (exitflag);
   }
 
-  count = di_iterate_init (di_data, DI_ITER_PRINTABLE);
-  while ((pub = di_iterate (di_data)) != NULL) {
-    double    dval;
-
-    /* compare terabytes available */
-    dval = di_get_scaled (di_data, pub->index, DI_SCALE_TERA,
-        DI_SPACE_AVAIL, DI_VALUE_NONE, DI_VALUE_NONE);
-    if (dval >= space_wanted) {
-      rval = HAVE_SPACE;
-    }
+  /* compare terabytes available */
+  dval = di_get_scaled (di_data, pub.index, DI_SCALE_TERA,
+      DI_SPACE_AVAIL, DI_VALUE_NONE, DI_VALUE_NONE);
+  if (dval >= space_wanted) {
+    rval = HAVE_SPACE;
   }
   di_cleanup (di_data);
 
@@ -64,6 +64,20 @@ if [ $rc -ne 0 ]; then
   grc=1
 fi
 
+${runpath}/dioptions_test
+rc=$?
+if [ $rc -ne 0 ]; then
+  echo "FAIL: dioptions tests"
+  grc=1
+fi
+
+${runpath}/dilib_test
+rc=$?
+if [ $rc -ne 0 ]; then
+  echo "FAIL: dilib tests"
+  grc=1
+fi
+
 vers=`${runpath}/di --version`
 case ${vers} in
   "di version ${DI_VERSION} ${DI_RELEASE_STATUS}")
@@ -124,5 +138,27 @@ case "$out" in
     ;;
 esac
 
+# --where also applies to the entries that only -a displays
+case ${systype} in
+  MINGW64*)
+    ;;
+  *)
+    out="`${runpath}/di -a -n -f M --where 'mount == "/"'`"
+    case "$out" in
+      "")
+        echo "FAIL: no output [-a --where]"
+        grc=1
+        ;;
+      *)
+        other=`echo "$out" | grep -v '^/ *$'`
+        if [ "x$other" != x ]; then
+          echo "FAIL: --where ignored with -a [$other]"
+          grc=1
+        fi
+        ;;
+    esac
+    ;;
+esac
+
 echo "localtest: $grc"
 exit $grc